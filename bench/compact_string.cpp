@@ -0,0 +1,130 @@
+// Sorting and hash-joining a million keys held as std::string, spl::string and spl::compact_string.
+//
+// Usage: bench_compact_string [count]
+
+#include "splcompactstring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+// Random lowercase words of 3 to 24 letters, so most comparisons are settled by the first 4 bytes
+std::vector<std::string> make_words(std::size_t count, unsigned seed)
+{
+	std::mt19937_64 rng(seed);
+	std::vector<std::string> keys;
+	keys.reserve(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::string key(3 + rng() % 22, 'a');
+
+		for (char &ch : key)
+			ch = static_cast<char>('a' + rng() % 26);
+
+		keys.push_back(std::move(key));
+	}
+
+	return keys;
+}
+
+// Identifiers and longer keys behind a handful of shared prefixes, like URLs or paths, the worst case for the prefix
+std::vector<std::string> make_prefixed(std::size_t count, unsigned seed)
+{
+	static const char *const prefixes[] = { "user_", "https://example.com/items/", "/var/lib/data/", "k", "order-2024-" };
+
+	std::mt19937_64 rng(seed);
+	std::vector<std::string> keys;
+	keys.reserve(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::string key = prefixes[rng() % std::size(prefixes)];
+		key += std::to_string(rng() % (count * 2));
+		keys.push_back(std::move(key));
+	}
+
+	return keys;
+}
+
+template <typename T>
+double time_sort(const std::vector<std::string> &keys)
+{
+	std::vector<T> values(keys.begin(), keys.end());
+
+	const auto start = std::chrono::steady_clock::now();
+	std::sort(values.begin(), values.end());
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (!std::is_sorted(values.begin(), values.end()))
+		std::abort();
+
+	return ms;
+}
+
+template <typename T>
+double time_join(const std::vector<std::string> &build, const std::vector<std::string> &probe, std::size_t &matches)
+{
+	const std::vector<T> build_values(build.begin(), build.end());
+	const std::vector<T> probe_values(probe.begin(), probe.end());
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::unordered_set<T> table(build_values.begin(), build_values.end());
+	matches = 0;
+
+	for (const T &value : probe_values)
+		matches += table.count(value);
+
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename T>
+void run(const char *dataset, const char *name, const std::vector<std::string> &keys, const std::vector<std::string> &probe)
+{
+	std::size_t matches;
+	const double sort_ms = time_sort<T>(keys);
+	const double join_ms = time_join<T>(keys, probe, matches);
+
+	std::printf("  { \"dataset\": \"%s\", \"type\": \"%s\", \"count\": %zu, \"sort_ms\": %.2f, \"hash_join_ms\": %.2f, \"matches\": %zu }",
+		dataset, name, keys.size(), sort_ms, join_ms, matches);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+	std::printf("[\n");
+
+	for (const auto &[dataset, make] : { std::make_pair("words", &make_words), std::make_pair("prefixed", &make_prefixed) })
+	{
+		const std::vector<std::string> keys = make(count, 1);
+		std::vector<std::string> probe = make(count / 2, 2);
+
+		// Half the probes hit
+		probe.insert(probe.end(), keys.begin(), keys.begin() + count / 2);
+
+		if (std::string_view(dataset) != "words")
+			std::printf(",\n");
+
+		run<std::string>(dataset, "std::string", keys, probe);
+		std::printf(",\n");
+		run<spl::string>(dataset, "spl::string", keys, probe);
+		std::printf(",\n");
+		run<spl::compact_string>(dataset, "spl::compact_string", keys, probe);
+	}
+
+	std::printf("\n]\n");
+
+	return 0;
+}
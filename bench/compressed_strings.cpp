@@ -0,0 +1,144 @@
+// spl::compressed_strings on URL-like and log-like columns: compression ratio, decode speed and find().
+//
+// Usage: bench_compressed_strings [count]
+
+#include "splcompressed.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::string> make_urls(std::size_t count)
+{
+	static const char *const hosts[] = { "www.example.com", "api.example.com", "cdn.static-assets.net", "shop.example.org", "images.example.com" };
+	static const char *const paths[] = { "/products/", "/api/v2/users/", "/search?q=", "/static/js/app.", "/blog/2021/", "/category/shoes/", "/account/orders/" };
+	static const char *const words[] = { "running", "winter", "jacket", "summer", "sale", "boots", "kids", "classic", "leather", "wireless" };
+
+	std::mt19937_64 rng(1);
+	std::vector<std::string> urls(count);
+
+	for (std::string &url : urls)
+	{
+		url = rng() % 5 ? "https://" : "http://";
+		url += hosts[rng() % std::size(hosts)];
+		url += paths[rng() % std::size(paths)];
+
+		for (std::size_t i = 0, parts = 1 + rng() % 3; i < parts; ++i)
+		{
+			url += words[rng() % std::size(words)];
+			url += i + 1 < parts ? '-' : '/';
+		}
+
+		if (rng() % 2)
+			url += "?id=" + std::to_string(rng() % 1000000) + "&ref=" + words[rng() % std::size(words)];
+	}
+
+	return urls;
+}
+
+std::vector<std::string> make_log_fields(std::size_t count)
+{
+	static const char *const levels[] = { "INFO", "WARN", "ERROR", "DEBUG" };
+	static const char *const messages[] = { "request completed", "connection reset by peer", "cache miss for key", "retrying upstream",
+		"user session expired", "slow query detected" };
+
+	std::mt19937_64 rng(2);
+	std::vector<std::string> fields(count);
+
+	for (std::string &field : fields)
+	{
+		field = "2021-06-" + std::to_string(10 + rng() % 20) + "T" + std::to_string(10 + rng() % 14) + ":" + std::to_string(10 + rng() % 50) + ":" +
+			std::to_string(10 + rng() % 50) + "Z " + levels[rng() % std::size(levels)] + " worker-" + std::to_string(rng() % 64) + " " +
+			messages[rng() % std::size(messages)] + " (" + std::to_string(rng() % 5000) + "ms)";
+	}
+
+	return fields;
+}
+
+double elapsed_seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run(const char *column, const std::vector<std::string> &strings, bool &first)
+{
+	std::size_t raw = 0;
+	std::size_t as_strings = 0;
+
+	for (const std::string &str : strings)
+	{
+		raw += str.size();
+
+		// Note: Roughly what a vector of spl::string costs, the object plus a heap block with malloc's 16 byte granularity and header
+		as_strings += sizeof(spl::string) + ((str.size() + 1 + 8 + 15) & ~std::size_t(15));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	const spl::compressed_strings compressed = spl::compressed_strings::from(strings);
+	const double build = elapsed_seconds(start);
+
+	std::vector<char> buffer(4096);
+	std::size_t checksum = 0;
+
+	start = std::chrono::steady_clock::now();
+
+	for (std::size_t round = 0; round < 5; ++round)
+	{
+		for (std::size_t i = 0; i < compressed.size(); ++i)
+		{
+			const std::size_t size = compressed.decompress(i, buffer.data(), buffer.size());
+			checksum += static_cast<unsigned char>(buffer[size / 2]);
+		}
+	}
+
+	const double decode = elapsed_seconds(start) / 5;
+
+	std::mt19937_64 rng(3);
+	std::vector<std::size_t> picks(64);
+
+	for (std::size_t &pick : picks)
+		pick = rng() % strings.size();
+
+	start = std::chrono::steady_clock::now();
+
+	for (const std::size_t pick : picks)
+		checksum += compressed.find(strings[pick]);
+
+	const double find_compressed = elapsed_seconds(start) / picks.size();
+
+	start = std::chrono::steady_clock::now();
+
+	for (const std::size_t pick : picks)
+		checksum += static_cast<std::size_t>(std::find(strings.begin(), strings.end(), strings[pick]) - strings.begin());
+
+	const double find_plain = elapsed_seconds(start) / picks.size();
+
+	std::printf("%s  { \"column\": \"%s\", \"strings\": %zu, \"raw_bytes\": %zu, \"compressed_bytes\": %zu, \"ratio\": %.2f, "
+		"\"memory_vs_spl_strings\": %.2f, \"symbols\": %zu, \"train_and_compress_ms\": %.0f, \"decode_gb_per_s\": %.2f, "
+		"\"find_ms\": %.2f, \"std_find_ms\": %.2f, \"checksum\": %zu }",
+		first ? "" : ",\n", column, strings.size(), raw, compressed.compressed_bytes(), static_cast<double>(raw) / compressed.compressed_bytes(),
+		static_cast<double>(as_strings) / compressed.memory_usage(), compressed.symbol_count(), build * 1000, raw / decode / 1e9,
+		find_compressed * 1000, find_plain * 1000, checksum);
+	first = false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+
+	bool first = true;
+	std::printf("[\n");
+
+	run("urls", make_urls(count), first);
+	run("log lines", make_log_fields(count), first);
+
+	std::printf("\n]\n");
+}
@@ -0,0 +1,181 @@
+// spl::csv_reader throughput next to the split-on-commas loop it replaces.
+//
+// Usage: bench_csv_reader [megabytes]
+
+#include "splcsv.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Numbers and short words, no quoting at all
+std::string make_plain(std::size_t bytes)
+{
+	std::mt19937_64 rng(1);
+	std::string text;
+	text.reserve(bytes + 256);
+
+	while (text.size() < bytes)
+	{
+		text += std::to_string(rng() % 1'000'000);
+		text += ",user";
+		text += std::to_string(rng() % 10'000);
+		text += ',';
+		text += std::to_string(rng() % 100);
+		text += ".";
+		text += std::to_string(rng() % 100);
+		text += ",2021-06-";
+		text += std::to_string(10 + rng() % 20);
+		text += ",active\n";
+	}
+
+	return text;
+}
+
+// Every row has a quoted free text column, some with embedded commas, newlines and "" escapes
+std::string make_quoted(std::size_t bytes)
+{
+	static const char *const comments[] = { "\"fine\"", "\"late, but complete\"", "\"said \"\"hello\"\" twice\"", "\"line one\nline two\"", "\"\"" };
+
+	std::mt19937_64 rng(2);
+	std::string text;
+	text.reserve(bytes + 256);
+
+	while (text.size() < bytes)
+	{
+		text += std::to_string(rng() % 1'000'000);
+		text += ",\"Doe, Jane\",";
+		text += comments[rng() % std::size(comments)];
+		text += ',';
+		text += std::to_string(rng() % 1000);
+		text += "\r\n";
+	}
+
+	return text;
+}
+
+struct result
+{
+	double seconds;
+	std::size_t rows;
+	std::size_t field_bytes;
+};
+
+template <typename Read>
+result time_read(Read read)
+{
+	const auto start = std::chrono::steady_clock::now();
+	result r = read();
+	r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return r;
+}
+
+result read_view(const std::string &text)
+{
+	spl::csv_reader reader(text);
+	spl::csv_row row;
+	result r {};
+
+	while (reader.read_row(row))
+	{
+		++r.rows;
+
+		for (const std::string_view &field : row)
+			r.field_bytes += field.size();
+	}
+
+	return r;
+}
+
+// Hands the text over in 64 KiB reads, like a file would
+result read_stream(const std::string &text)
+{
+	std::size_t offset = 0;
+
+	spl::csv_reader reader([&](char *buffer, std::size_t size)
+	{
+		const std::size_t count = std::min({ size, text.size() - offset, std::size_t(64 * 1024) });
+		std::memcpy(buffer, text.data() + offset, count);
+		offset += count;
+		return count;
+	});
+
+	spl::csv_row row;
+	result r {};
+
+	while (reader.read_row(row))
+	{
+		++r.rows;
+
+		for (const std::string_view &field : row)
+			r.field_bytes += field.size();
+	}
+
+	return r;
+}
+
+// What people write today: split into lines, then split each line. Wrong for quoted fields, but it's the baseline.
+result read_split(const std::string &text)
+{
+	std::vector<std::string_view> lines;
+	std::vector<std::string_view> fields;
+	result r {};
+
+	spl::split(text, '\n', lines);
+
+	for (const std::string_view &line : lines)
+	{
+		if (line.empty())
+			continue;
+
+		fields.clear();
+		spl::split(line, ',', fields);
+		++r.rows;
+
+		for (const std::string_view &field : fields)
+			r.field_bytes += field.size();
+	}
+
+	return r;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+	const std::size_t bytes = megabytes << 20;
+
+	bool first = true;
+	std::printf("[\n");
+
+	const std::pair<const char*, std::string (*)(std::size_t)> datasets[] = { { "plain", make_plain }, { "quoted", make_quoted } };
+	const std::pair<const char*, result (*)(const std::string&)> methods[] = {
+		{ "csv_reader view", read_view }, { "csv_reader streaming", read_stream }, { "split lines and commas", read_split } };
+
+	for (const auto &[dataset, make] : datasets)
+	{
+		const std::string text = make(bytes);
+
+		for (const auto &[method, read] : methods)
+		{
+			const result r = time_read([&] { return read(text); });
+
+			std::printf("%s  { \"dataset\": \"%s\", \"method\": \"%s\", \"bytes\": %zu, \"rows\": %zu, \"field_bytes\": %zu, \"ms\": %.2f, \"gb_per_s\": %.2f }",
+				first ? "" : ",\n", dataset, method, text.size(), r.rows, r.field_bytes, r.seconds * 1000.0, text.size() / r.seconds / 1e9);
+			first = false;
+		}
+	}
+
+	std::printf("\n]\n");
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+// spl base64 and hex encoding against a plain per-byte loop, for digest-sized and larger inputs, and JSON and
+// URL escaping of text with nothing to escape and with the odd character here and there.
+//
+// Usage: bench_encoding [total_mb]
+
+#include "splencoding.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+namespace
+{
+
+std::string naive_base64(const std::string_view &data)
+{
+	static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string out;
+
+	for (std::size_t i = 0; i < data.size(); i += 3)
+	{
+		std::uint32_t bits = static_cast<unsigned char>(data[i]) << 16;
+
+		if (i + 1 < data.size())
+			bits |= static_cast<unsigned char>(data[i + 1]) << 8;
+
+		if (i + 2 < data.size())
+			bits |= static_cast<unsigned char>(data[i + 2]);
+
+		out += chars[bits >> 18];
+		out += chars[(bits >> 12) & 0x3F];
+		out += i + 1 < data.size() ? chars[(bits >> 6) & 0x3F] : '=';
+		out += i + 2 < data.size() ? chars[bits & 0x3F] : '=';
+	}
+
+	return out;
+}
+
+std::string naive_hex(const std::string_view &data)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string out;
+
+	for (const char ch : data)
+	{
+		out += digits[static_cast<unsigned char>(ch) >> 4];
+		out += digits[static_cast<unsigned char>(ch) & 0x0F];
+	}
+
+	return out;
+}
+
+std::string naive_json_escape(const std::string_view &text)
+{
+	std::string out;
+
+	for (const char ch : text)
+	{
+		if (ch == '"' || ch == '\\')
+		{
+			out += '\\';
+			out += ch;
+		}
+		else if (ch == '\n')
+		{
+			out += "\\n";
+		}
+		else
+		{
+			out += ch;
+		}
+	}
+
+	return out;
+}
+
+template <typename F>
+void run(const char *method, std::size_t size, std::size_t total, F f, bool &first)
+{
+	std::size_t checksum = 0;
+	const std::size_t rounds = total / size;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < rounds; ++i)
+		checksum += f();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%s  { \"method\": \"%s\", \"size\": %zu, \"gb_per_s\": %.3f, \"checksum\": %zu }",
+		first ? "" : ",\n", method, size, static_cast<double>(rounds * size) / seconds / 1e9, checksum);
+	first = false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t total = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256) << 20;
+	const std::size_t sizes[] = { 32, 1024, 1 << 20 };
+
+	std::mt19937_64 rng(1);
+	bool first = true;
+	std::printf("[\n");
+
+	for (const std::size_t size : sizes)
+	{
+		std::string data(size, '\0');
+
+		for (char &ch : data)
+			ch = static_cast<char>(rng());
+
+		const spl::string base64 = spl::base64_encode(data);
+		const spl::string hex = spl::hex_encode(data);
+
+		run("naive base64 encode", size, total, [&] { return naive_base64(data).size(); }, first);
+		run("spl::base64_encode", size, total, [&] { return spl::base64_encode(data).size(); }, first);
+		run("spl::base64_decode", size, total, [&] { return spl::base64_decode(base64.view()).size(); }, first);
+		run("naive hex encode", size, total, [&] { return naive_hex(data).size(); }, first);
+		run("spl::hex_encode", size, total, [&] { return spl::hex_encode(data).size(); }, first);
+		run("spl::hex_decode", size, total, [&] { return spl::hex_decode(hex.view()).size(); }, first);
+
+		std::string clean(size, '\0');
+		std::string dirty(size, '\0');
+
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			clean[i] = static_cast<char>('a' + rng() % 26);
+			dirty[i] = rng() % 40 == 0 ? "\"\\\n /&"[rng() % 6] : clean[i];
+		}
+
+		run("naive json escape clean", size, total, [&] { return naive_json_escape(clean).size(); }, first);
+		run("spl::json_escape clean", size, total, [&] { return spl::json_escape(clean).size(); }, first);
+		run("naive json escape dirty", size, total, [&] { return naive_json_escape(dirty).size(); }, first);
+		run("spl::json_escape dirty", size, total, [&] { return spl::json_escape(dirty).size(); }, first);
+		run("spl::url_encode clean", size, total, [&] { return spl::url_encode(clean).size(); }, first);
+		run("spl::url_encode dirty", size, total, [&] { return spl::url_encode(dirty).size(); }, first);
+	}
+
+	std::printf("\n]\n");
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+// spl::glob against fnmatch() filtering a large set of keys.
+//
+// Usage: bench_glob [count]
+
+#include "splglob.h"
+
+#include <fnmatch.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::string> make_keys(std::size_t count)
+{
+	static const char *const kinds[] = { "session", "profile", "cart", "Session", "token" };
+
+	std::mt19937_64 rng(1);
+	std::vector<std::string> keys(count);
+
+	for (std::string &key : keys)
+	{
+		key = "user:" + std::to_string(rng() % 1'000'000) + ':' + kinds[rng() % std::size(kinds)] + ':';
+
+		for (std::size_t i = 0, length = 8 + rng() % 24; i < length; ++i)
+			key += static_cast<char>('a' + rng() % 26);
+	}
+
+	return keys;
+}
+
+template <typename Match>
+void run(const char *method, const char *pattern, const std::vector<std::string> &keys, Match match, bool &first)
+{
+	const auto start = std::chrono::steady_clock::now();
+	std::size_t matched = 0;
+
+	for (const std::string &key : keys)
+		matched += match(key);
+
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%s  { \"pattern\": \"%s\", \"method\": \"%s\", \"count\": %zu, \"matched\": %zu, \"ms\": %.2f, \"ns_per_key\": %.1f }",
+		first ? "" : ",\n", pattern, method, keys.size(), matched, ms, ms * 1e6 / keys.size());
+	first = false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+	const std::vector<std::string> keys = make_keys(count);
+
+	const std::pair<const char*, bool> patterns[] = {
+		{ "user:*", false },
+		{ "user:*:session:*", false },
+		{ "*:cart:*xyz*", false },
+		{ "user:12?4*:[pt]*", false },
+		{ "*[0-9][0-9]7:*q", false },
+		{ "*:SESSION:*", true },
+	};
+
+	bool first = true;
+	std::printf("[\n");
+
+	for (const auto &[pattern, case_insensitive] : patterns)
+	{
+		const spl::glob compiled(pattern, case_insensitive);
+		const int flags = case_insensitive ? FNM_CASEFOLD : 0;
+
+		run("spl::glob", pattern, keys, [&](const std::string &key) { return compiled.matches(key); }, first);
+		run("fnmatch", pattern, keys, [&](const std::string &key) { return fnmatch(pattern, key.c_str(), flags) == 0; }, first);
+	}
+
+	std::printf("\n]\n");
+
+	return 0;
+}
@@ -0,0 +1,134 @@
+// spl::line_index and spl::count_newlines() against rescanning a log with find('\n').
+//
+// Usage: bench_line_index [megabytes]
+
+#include "spllineindex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+spl::string make_log(std::size_t size)
+{
+	static const char *const messages[] = { "request completed", "connection reset by peer", "cache miss for key session:",
+		"retrying upstream after timeout", "slow query detected on table orders" };
+
+	std::mt19937_64 rng(1);
+	std::string log;
+	log.reserve(size + 256);
+
+	while (log.size() < size)
+	{
+		log += "2021-06-14T12:" + std::to_string(10 + rng() % 50) + ":" + std::to_string(10 + rng() % 50) + "Z INFO " + messages[rng() % std::size(messages)];
+
+		for (std::size_t i = 0, extra = rng() % 60; i < extra; ++i)
+			log += static_cast<char>('a' + rng() % 26);
+
+		log += '\n';
+	}
+
+	return spl::string(log);
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char *method, std::size_t operations, double ms, std::size_t checksum, bool &first)
+{
+	std::printf("%s  { \"method\": \"%s\", \"operations\": %zu, \"ms\": %.2f, \"us_per_operation\": %.3f, \"checksum\": %zu }",
+		first ? "" : ",\n", method, operations, ms, ms * 1000 / operations, checksum);
+	first = false;
+}
+
+// Line n found the way the tools do it now
+std::string_view nth_line(std::string_view text, std::size_t n)
+{
+	std::size_t begin = 0;
+
+	for (std::size_t i = 0; i < n; ++i)
+		begin = text.find('\n', begin) + 1;
+
+	return text.substr(begin, text.find('\n', begin) - begin);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+	const spl::string log = make_log(megabytes << 20);
+	const std::string_view text = log.view();
+
+	bool first = true;
+	std::printf("[\n");
+
+	auto start = std::chrono::steady_clock::now();
+	std::size_t count = static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+	report("std::count newlines", 1, elapsed_ms(start), count, first);
+
+	start = std::chrono::steady_clock::now();
+	count = spl::count_newlines(text);
+	report("spl::count_newlines", 1, elapsed_ms(start), count, first);
+
+	start = std::chrono::steady_clock::now();
+	const spl::line_index lines(text);
+	const double build_ms = elapsed_ms(start);
+
+	std::printf(",\n  { \"method\": \"build spl::line_index\", \"bytes\": %zu, \"lines\": %zu, \"ms\": %.2f, \"index_bytes_per_line\": %.2f }",
+		text.size(), lines.line_count(), build_ms, static_cast<double>(lines.memory_usage()) / lines.line_count());
+
+	// Appending a little at a time, as a tool tailing a log would
+	start = std::chrono::steady_clock::now();
+	spl::line_index growing;
+
+	for (std::size_t at = 0; at < text.size();)
+	{
+		at = std::min(text.size(), at + 4096);
+		growing.extend(text.substr(0, at));
+	}
+
+	report("spl::line_index extend by 4 KiB", text.size() / 4096, elapsed_ms(start), growing.line_count(), first);
+
+	std::mt19937_64 rng(2);
+	std::vector<std::size_t> targets(100000);
+
+	for (std::size_t &target : targets)
+		target = rng() % lines.line_count();
+
+	std::size_t checksum = 0;
+
+	// Note: The rescan only gets a handful of lookups, each one walks half the log on average
+	start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < 20; ++i)
+		checksum += nth_line(text, targets[i]).size();
+
+	report("find('\\\\n') rescan line(n)", 20, elapsed_ms(start), checksum, first);
+
+	checksum = 0;
+	start = std::chrono::steady_clock::now();
+
+	for (const std::size_t target : targets)
+		checksum += lines.line(target).size();
+
+	report("spl::line_index line(n)", targets.size(), elapsed_ms(start), checksum, first);
+
+	checksum = 0;
+	start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < targets.size(); ++i)
+		checksum += lines.position_of(rng() % text.size()).column;
+
+	report("spl::line_index position_of(offset)", targets.size(), elapsed_ms(start), checksum, first);
+
+	std::printf("\n]\n");
+}
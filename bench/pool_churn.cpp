@@ -0,0 +1,143 @@
+// Short-lived spl::string churn across a growing number of threads. Built twice, once on plain malloc and once
+// with SPL_STRING_POOLED_STORAGE, so the two binaries' output can be compared directly.
+//
+// The "alloc_only" rows are producer threads that only build strings and hand them back to the main thread to free,
+// so the producers' caches only ever fill from the shared depot. Those blocks have to be flushed when the producers
+// exit, or each round leaks them.
+//
+// Usage: bench_pool_churn_{malloc,pooled} [--ops <per thread>] [--max-threads <n>]
+
+#include "splstring.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(SPL_STRING_POOLED_STORAGE)
+	static constexpr const char *kBackend = "pooled";
+#else
+	static constexpr const char *kBackend = "malloc";
+#endif
+
+namespace
+{
+
+// Each op builds a string of 0 to 255 bytes, grows it, copies it and replaces a random slot in a small
+// working set, so most buffers die within a few dozen ops of being created.
+std::size_t churn(unsigned seed, std::size_t ops)
+{
+	static const std::string source(512, 'x');
+
+	std::minstd_rand rng(seed);
+	std::vector<spl::string> live(64);
+	std::size_t checksum = 0;
+
+	for (std::size_t i = 0; i < ops; ++i)
+	{
+		spl::string str(std::string_view(source).substr(0, rng() % 256));
+		str.append(std::string_view(source).substr(0, rng() % 32));
+		str.push_back('y');
+
+		spl::string copy = str;
+		checksum += copy.size();
+
+		live[rng() % live.size()] = std::move(str);
+	}
+
+	return checksum;
+}
+
+// Builds ops strings of 0 to 255 bytes and returns them without freeing any
+std::vector<spl::string> produce(unsigned seed, std::size_t ops)
+{
+	static const std::string source(512, 'x');
+
+	std::minstd_rand rng(seed);
+	std::vector<spl::string> produced;
+	produced.reserve(ops);
+
+	for (std::size_t i = 0; i < ops; ++i)
+		produced.emplace_back(std::string_view(source).substr(0, rng() % 256));
+
+	return produced;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	std::size_t ops = 2'000'000;
+	unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const std::string_view arg = argv[i];
+
+		if (arg == "--ops")
+			ops = std::strtoull(argv[i + 1], nullptr, 10);
+		else if (arg == "--max-threads")
+			max_threads = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+	}
+
+	std::printf("[\n");
+
+	for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+	{
+		std::vector<std::thread> workers;
+		std::vector<std::size_t> checksums(threads);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (unsigned t = 0; t < threads; ++t)
+			workers.emplace_back([t, ops, &checksums] { checksums[t] = churn(t + 1, ops); });
+
+		for (std::thread &worker : workers)
+			worker.join();
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double total_ops = double(ops) * threads;
+
+		std::printf("  { \"backend\": \"%s\", \"pattern\": \"churn\", \"threads\": %u, \"ops_per_second\": %.0f, \"ns_per_op_per_thread\": %.2f, \"checksum\": %zu },\n",
+			kBackend, threads, total_ops / seconds, seconds * 1e9 / ops, checksums[0]);
+	}
+
+	// Note: Fewer ops per round since every string stays alive until its producer has finished
+	const std::size_t produce_ops = std::max<std::size_t>(ops / 16, 1);
+
+	for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+	{
+		std::vector<std::thread> workers;
+		std::vector<std::vector<spl::string>> produced(threads);
+		std::size_t checksum = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (unsigned t = 0; t < threads; ++t)
+			workers.emplace_back([t, produce_ops, &produced] { produced[t] = produce(t + 1, produce_ops); });
+
+		for (std::thread &worker : workers)
+			worker.join();
+
+		for (std::vector<spl::string> &strings : produced)
+		{
+			for (const spl::string &str : strings)
+				checksum += str.size();
+
+			strings = {};
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double total_ops = double(produce_ops) * threads;
+
+		std::printf("  { \"backend\": \"%s\", \"pattern\": \"alloc_only\", \"threads\": %u, \"ops_per_second\": %.0f, \"ns_per_op_per_thread\": %.2f, \"checksum\": %zu }%s\n",
+			kBackend, threads, total_ops / seconds, seconds * 1e9 / produce_ops, checksum, threads * 2 <= max_threads ? "," : "");
+	}
+
+	std::printf("]\n");
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+// spl::prefix_trie against testing every route with starts_with() in a loop, for longest-prefix routing.
+//
+// Usage: bench_prefix_trie [lookups]
+
+#include "spltrie.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::vector<spl::string> make_routes(std::size_t count)
+{
+	static const char *const services[] = { "api", "static", "admin", "auth", "media", "v1", "v2", "internal" };
+	static const char *const resources[] = { "users", "orders", "items", "sessions", "files", "reports", "tags" };
+
+	std::mt19937_64 rng(count);
+	std::vector<spl::string> routes(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::string route = std::string("/") + services[rng() % std::size(services)] + '/' + resources[rng() % std::size(resources)] + '/';
+
+		// Note: The index keeps every route unique
+		route += std::to_string(i) + '/';
+
+		for (std::size_t j = 0, depth = rng() % 3; j < depth; ++j)
+			route += std::string(resources[rng() % std::size(resources)]) + '/';
+
+		routes[i] = route;
+	}
+
+	return routes;
+}
+
+// Request paths that extend a route, with one in eight under a route that doesn't exist
+std::vector<spl::string> make_paths(const std::vector<spl::string> &routes, std::size_t count)
+{
+	std::mt19937_64 rng(2);
+	std::vector<spl::string> paths(count);
+
+	for (spl::string &path : paths)
+	{
+		std::string text(routes[rng() % routes.size()].view());
+
+		if (rng() % 8 == 0)
+			text.insert(1, "missing/");
+
+		path = text + std::to_string(rng() % 100000) + "?page=" + std::to_string(rng() % 10);
+	}
+
+	return paths;
+}
+
+template <typename F>
+void run(const char *method, std::size_t routes, const std::vector<spl::string> &paths, std::size_t count, F f, bool &first)
+{
+	long long sum = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < count; ++i)
+		sum += f(paths[i % paths.size()]);
+
+	const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%s  { \"method\": \"%s\", \"routes\": %zu, \"lookups\": %zu, \"ns_per_lookup\": %.1f, \"checksum\": %lld }",
+		first ? "" : ",\n", method, routes, count, ns / count, sum);
+	first = false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+
+	bool first = true;
+	std::printf("[\n");
+
+	for (const std::size_t count : { 10'000, 100'000, 1'000'000 })
+	{
+		const std::vector<spl::string> routes = make_routes(count);
+		const std::vector<spl::string> paths = make_paths(routes, 65536);
+
+		const auto build_start = std::chrono::steady_clock::now();
+		spl::prefix_trie<int> trie;
+
+		for (std::size_t i = 0; i < routes.size(); ++i)
+			trie.insert(routes[i], static_cast<int>(i));
+
+		const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+
+		std::size_t key_bytes = 0;
+
+		for (const spl::string &route : routes)
+			key_bytes += route.size();
+
+		std::printf("%s  { \"method\": \"build\", \"routes\": %zu, \"ms\": %.1f, \"key_bytes\": %zu, \"trie_bytes\": %zu }",
+			first ? "" : ",\n", count, build_ms, key_bytes, trie.memory_usage());
+		first = false;
+
+		// Note: The linear scan gets fewer lookups so it finishes in reasonable time, the average is still comparable
+		run("starts_with loop", count, paths, std::max<std::size_t>(lookups / count, 1000), [&](const spl::string &path)
+		{
+			std::size_t best = 0;
+			int value = -1;
+
+			for (std::size_t i = 0; i < routes.size(); ++i)
+			{
+				if (routes[i].size() > best && path.starts_with(routes[i].view()))
+				{
+					best = routes[i].size();
+					value = static_cast<int>(i);
+				}
+			}
+
+			return value;
+		}, first);
+
+		run("spl::prefix_trie", count, paths, lookups, [&](const spl::string &path)
+		{
+			const auto match = trie.longest_prefix_match(path);
+			return match ? *match.value : -1;
+		}, first);
+	}
+
+	std::printf("\n]\n");
+}
@@ -0,0 +1,112 @@
+// spl::sort_strings against std::sort on a few key distributions.
+//
+// Usage: bench_sort_strings [count]
+
+#include "splsort.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::string> make_words(std::size_t count)
+{
+	std::mt19937_64 rng(1);
+	std::vector<std::string> keys(count);
+
+	for (std::string &key : keys)
+	{
+		key.resize(3 + rng() % 22);
+
+		for (char &ch : key)
+			ch = static_cast<char>('a' + rng() % 26);
+	}
+
+	return keys;
+}
+
+// Long shared prefixes, where comparison sorts keep re-reading the same bytes
+std::vector<std::string> make_urls(std::size_t count)
+{
+	static const char *const prefixes[] = { "https://example.com/api/v2/users/", "https://example.com/api/v2/orders/", "https://cdn.example.com/assets/img/" };
+
+	std::mt19937_64 rng(2);
+	std::vector<std::string> keys(count);
+
+	for (std::string &key : keys)
+		key = prefixes[rng() % std::size(prefixes)] + std::to_string(rng() % (count * 4)) + "/details";
+
+	return keys;
+}
+
+std::vector<std::string> make_files(std::size_t count)
+{
+	std::mt19937_64 rng(3);
+	std::vector<std::string> keys(count);
+
+	for (std::string &key : keys)
+		key = "IMG_" + std::to_string(rng() % (count * 4)) + ".jpg";
+
+	return keys;
+}
+
+template <typename T, typename Sort>
+double time_ms(const std::vector<std::string> &keys, Sort sort)
+{
+	std::vector<T> values(keys.begin(), keys.end());
+
+	const auto start = std::chrono::steady_clock::now();
+	sort(values);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char *dataset, const char *method, std::size_t count, double ms, bool &first)
+{
+	std::printf("%s  { \"dataset\": \"%s\", \"method\": \"%s\", \"count\": %zu, \"ms\": %.2f }", first ? "" : ",\n", dataset, method, count, ms);
+	first = false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+	spl::sort_options parallel;
+	parallel.parallel = true;
+
+	spl::sort_options folded;
+	folded.case_insensitive = true;
+
+	spl::sort_options natural;
+	natural.natural = true;
+
+	bool first = true;
+	std::printf("[\n");
+
+	const std::pair<const char*, std::function<std::vector<std::string>(std::size_t)>> datasets[] = {
+		{ "words", make_words }, { "urls", make_urls }, { "files", make_files } };
+
+	for (const auto &[dataset, make] : datasets)
+	{
+		const std::vector<std::string> keys = make(count);
+
+		report(dataset, "std::sort std::string", count, time_ms<std::string>(keys, [](auto &v) { std::sort(v.begin(), v.end()); }), first);
+		report(dataset, "std::sort spl::string", count, time_ms<spl::string>(keys, [](auto &v) { std::sort(v.begin(), v.end()); }), first);
+		report(dataset, "sort_strings std::string", count, time_ms<std::string>(keys, [](auto &v) { spl::sort_strings(v); }), first);
+		report(dataset, "sort_strings spl::string", count, time_ms<spl::string>(keys, [](auto &v) { spl::sort_strings(v); }), first);
+		report(dataset, "sort_strings parallel", count, time_ms<spl::string>(keys, [&](auto &v) { spl::sort_strings(v, parallel); }), first);
+		report(dataset, "sort_strings case_insensitive", count, time_ms<spl::string>(keys, [&](auto &v) { spl::sort_strings(v, folded); }), first);
+		report(dataset, "sort_strings natural", count, time_ms<spl::string>(keys, [&](auto &v) { spl::sort_strings(v, natural); }), first);
+	}
+
+	std::printf("\n]\n");
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+// spl::static_map against std::unordered_map, looking up HTTP header names (some missing) the way a server does.
+//
+// Usage: bench_static_map [lookups]
+
+#include "splstaticmap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+constexpr std::pair<std::string_view, int> header_list[] = {
+	{ "Accept", 1 }, { "Accept-Charset", 2 }, { "Accept-Encoding", 3 }, { "Accept-Language", 4 }, { "Accept-Ranges", 5 },
+	{ "Access-Control-Allow-Origin", 6 }, { "Age", 7 }, { "Allow", 8 }, { "Authorization", 9 }, { "Cache-Control", 10 },
+	{ "Connection", 11 }, { "Content-Disposition", 12 }, { "Content-Encoding", 13 }, { "Content-Language", 14 },
+	{ "Content-Length", 15 }, { "Content-Location", 16 }, { "Content-Range", 17 }, { "Content-Type", 18 }, { "Cookie", 19 },
+	{ "Date", 20 }, { "ETag", 21 }, { "Expect", 22 }, { "Expires", 23 }, { "Forwarded", 24 }, { "From", 25 }, { "Host", 26 },
+	{ "If-Match", 27 }, { "If-Modified-Since", 28 }, { "If-None-Match", 29 }, { "If-Range", 30 }, { "If-Unmodified-Since", 31 },
+	{ "Keep-Alive", 32 }, { "Last-Modified", 33 }, { "Link", 34 }, { "Location", 35 }, { "Max-Forwards", 36 }, { "Origin", 37 },
+	{ "Pragma", 38 }, { "Proxy-Authenticate", 39 }, { "Proxy-Authorization", 40 }, { "Range", 41 }, { "Referer", 42 },
+	{ "Retry-After", 43 }, { "Server", 44 }, { "Set-Cookie", 45 }, { "Strict-Transport-Security", 46 }, { "TE", 47 },
+	{ "Trailer", 48 }, { "Transfer-Encoding", 49 }, { "Upgrade", 50 }, { "User-Agent", 51 }, { "Vary", 52 }, { "Via", 53 },
+	{ "WWW-Authenticate", 54 }, { "X-Forwarded-For", 55 }, { "X-Forwarded-Proto", 56 }, { "X-Request-ID", 57 },
+};
+
+constexpr auto headers = spl::make_static_map(header_list);
+constexpr auto headers_icase = spl::make_static_map_icase(header_list);
+
+template <typename F>
+void run(const char *method, const std::vector<spl::string> &queries, std::size_t count, F f, bool &first)
+{
+	long long sum = 0;
+	const std::size_t rounds = count / queries.size();
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t round = 0; round < rounds; ++round)
+	{
+		for (const spl::string &query : queries)
+			sum += f(query);
+	}
+
+	const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%s  { \"method\": \"%s\", \"lookups\": %zu, \"ns_per_lookup\": %.2f, \"checksum\": %lld }",
+		first ? "" : ",\n", method, rounds * queries.size(), ns / (rounds * queries.size()), sum);
+	first = false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+	std::unordered_map<spl::string, int> string_map;
+	std::unordered_map<std::string_view, int> view_map;
+
+	for (const auto &[key, value] : header_list)
+	{
+		string_map.emplace(key, value);
+		view_map.emplace(key, value);
+	}
+
+	// Note: One in eight lookups is for a header that isn't there. The queries stay in cache, like a hot request path.
+	std::mt19937_64 rng(1);
+	std::vector<spl::string> queries(4096);
+
+	for (spl::string &query : queries)
+	{
+		query = header_list[rng() % std::size(header_list)].first;
+
+		if (rng() % 8 == 0)
+			query += "-Extra";
+	}
+
+	bool first = true;
+	std::printf("[\n");
+
+	run("std::unordered_map<spl::string>", queries, count, [&](const spl::string &q) { const auto it = string_map.find(q); return it == string_map.end() ? 0 : it->second; }, first);
+	run("std::unordered_map<std::string_view>", queries, count, [&](const spl::string &q) { const auto it = view_map.find(q.view()); return it == view_map.end() ? 0 : it->second; }, first);
+	run("spl::static_map", queries, count, [](const spl::string &q) { return headers.value_or(q.view(), 0); }, first);
+	run("spl::static_map icase", queries, count, [](const spl::string &q) { return headers_icase.value_or(q.view(), 0); }, first);
+
+	std::printf("\n]\n");
+
+	return 0;
+}
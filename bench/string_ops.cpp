@@ -0,0 +1,490 @@
+// Times every spl::string operation next to its std::string equivalent across size classes from 0 B to 64 MB.
+// Results go to stdout (or --json <file>) as JSON so runs can be diffed, with a readable table on stderr.
+//
+// Usage: bench_string_ops [--filter <substring>] [--max-size <bytes>] [--min-time <seconds>] [--json <file>]
+
+#include "splstring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+// Allocation counting. On glibc every malloc family call is routed through these, which covers both
+// spl::string (malloc/realloc) and std::string (operator new). Elsewhere the counters stay at zero.
+namespace
+{
+	std::atomic<std::uint64_t> gAllocations { 0 };
+	std::atomic<std::uint64_t> gReallocations { 0 };
+}
+
+#if defined(__GLIBC__)
+extern "C"
+{
+	void *__libc_malloc(std::size_t size);
+	void *__libc_calloc(std::size_t count, std::size_t size);
+	void *__libc_realloc(void *ptr, std::size_t size);
+	void __libc_free(void *ptr);
+
+	void *malloc(std::size_t size)
+	{
+		gAllocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_malloc(size);
+	}
+
+	void *calloc(std::size_t count, std::size_t size)
+	{
+		gAllocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_calloc(count, size);
+	}
+
+	void *realloc(void *ptr, std::size_t size)
+	{
+		gReallocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_realloc(ptr, size);
+	}
+
+	void free(void *ptr)
+	{
+		__libc_free(ptr);
+	}
+}
+
+constexpr bool kCountsAllocations = true;
+#else
+constexpr bool kCountsAllocations = false;
+#endif
+
+namespace
+{
+
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void *sink;
+	sink = &value;
+#endif
+}
+
+inline std::uint64_t read_cycles()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+constexpr bool kHasCycles =
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	true;
+#else
+	false;
+#endif
+
+struct options
+{
+	std::string filter;
+	std::size_t max_size = 64ull * 1024 * 1024;
+	double min_time = 0.05;
+	const char *json_path = nullptr;
+};
+
+struct result
+{
+	std::string op;
+	const char *impl;
+	std::size_t size;
+	std::uint64_t iterations;
+	double ns_per_op;
+	double bytes_per_second;
+	double allocations_per_op;
+	double reallocations_per_op;
+	double cycles_per_byte;
+};
+
+// Input data shared by every operation at one size class: lowercase text with a comma every 16 bytes,
+// and no 'Z' or '#' so the search benchmarks scan the whole string before finding their target.
+struct inputs
+{
+	explicit inputs(std::size_t size)
+	{
+		std::mt19937 rng(static_cast<std::mt19937::result_type>(size));
+		text.resize(size);
+
+		for (std::size_t i = 0; i < size; ++i)
+			text[i] = (i % 16 == 15) ? ',' : static_cast<char>('a' + rng() % 26);
+
+		tail_char = text;
+		head_char = text;
+		tail_needle = text;
+		head_needle = text;
+
+		if (size > 0)
+		{
+			tail_char[size - 1] = 'Z';
+			head_char[0] = 'Z';
+		}
+
+		if (size >= needle.size())
+		{
+			tail_needle.replace(size - needle.size(), needle.size(), needle);
+			head_needle.replace(0, needle.size(), needle);
+		}
+	}
+
+	std::string text;
+	std::string tail_char;
+	std::string head_char;
+	std::string tail_needle;
+	std::string head_needle;
+
+	const std::string needle = "#needle#";
+};
+
+using op_function = std::function<void(std::uint64_t iterations)>;
+
+struct benchmark
+{
+	const char *name;
+	std::size_t max_size;                  // Skipped above this, for operations that are quadratic-ish in spl::string
+	bool size_independent;                 // Only run once, at the first size class
+	std::function<op_function(const inputs &)> spl_op;
+	std::function<op_function(const inputs &)> std_op;
+};
+
+result measure(const std::string &name, const char *impl, std::size_t size, const op_function &op, double min_time)
+{
+	using clock = std::chrono::steady_clock;
+
+	// Warm up once so first-touch page faults don't land in the measurement
+	op(1);
+
+	std::uint64_t iterations = 1;
+
+	while (true)
+	{
+		const std::uint64_t allocations = gAllocations.load();
+		const std::uint64_t reallocations = gReallocations.load();
+		const std::uint64_t cycles = read_cycles();
+		const clock::time_point start = clock::now();
+
+		op(iterations);
+
+		const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+		const std::uint64_t elapsed_cycles = read_cycles() - cycles;
+
+		if (seconds >= min_time || iterations >= (1ull << 40))
+		{
+			result r;
+			r.op = name;
+			r.impl = impl;
+			r.size = size;
+			r.iterations = iterations;
+			r.ns_per_op = seconds * 1e9 / iterations;
+			r.bytes_per_second = size ? double(size) * iterations / seconds : 0.0;
+			r.allocations_per_op = double(gAllocations.load() - allocations) / iterations;
+			r.reallocations_per_op = double(gReallocations.load() - reallocations) / iterations;
+			r.cycles_per_byte = (kHasCycles && size) ? double(elapsed_cycles) / (double(size) * iterations) : -1.0;
+
+			return r;
+		}
+
+		// Aim a little past min_time next round
+		const double scale = seconds > 0 ? std::min(100.0, 1.4 * min_time / seconds) : 100.0;
+		iterations = std::max<std::uint64_t>(iterations + 1, static_cast<std::uint64_t>(iterations * scale));
+	}
+}
+
+std::vector<benchmark> make_benchmarks()
+{
+	std::vector<benchmark> benchmarks;
+	constexpr std::size_t unlimited = ~std::size_t(0);
+
+	benchmarks.push_back({ "construct", unlimited, false,
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) { for (; n; --n) { spl::string s(std::string_view(in.text)); do_not_optimize(s); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) { for (; n; --n) { std::string s(std::string_view(in.text)); do_not_optimize(s); } }; } });
+
+	benchmarks.push_back({ "copy", unlimited, false,
+		[](const inputs &in) -> op_function { auto src = std::make_shared<spl::string>(std::string_view(in.text));
+			return [src](std::uint64_t n) { for (; n; --n) { spl::string s(*src); do_not_optimize(s); } }; },
+		[](const inputs &in) -> op_function { auto src = std::make_shared<std::string>(in.text);
+			return [src](std::uint64_t n) { for (; n; --n) { std::string s(*src); do_not_optimize(s); } }; } });
+
+	benchmarks.push_back({ "move", unlimited, false,
+		[](const inputs &in) -> op_function { auto src = std::make_shared<spl::string>(std::string_view(in.text));
+			return [src](std::uint64_t n) { for (; n; --n) { spl::string s(std::move(*src)); do_not_optimize(s); *src = std::move(s); } }; },
+		[](const inputs &in) -> op_function { auto src = std::make_shared<std::string>(in.text);
+			return [src](std::uint64_t n) { for (; n; --n) { std::string s(std::move(*src)); do_not_optimize(s); *src = std::move(s); } }; } });
+
+	// Builds the whole string from 64 byte pieces
+	benchmarks.push_back({ "append", 16 * 1024 * 1024, false,
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { spl::string s; for (std::size_t i = 0; i < in.text.size(); i += 64) s.append(std::string_view(in.text).substr(i, 64)); do_not_optimize(s); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { std::string s; for (std::size_t i = 0; i < in.text.size(); i += 64) s.append(std::string_view(in.text).substr(i, 64)); do_not_optimize(s); } }; } });
+
+	benchmarks.push_back({ "push_back", 1024 * 1024, false,
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { spl::string s; for (const char ch : in.text) s.push_back(ch); do_not_optimize(s); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { std::string s; for (const char ch : in.text) s.push_back(ch); do_not_optimize(s); } }; } });
+
+	benchmarks.push_back({ "find_char", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.tail_char));
+			return [s](std::uint64_t n) { for (; n; --n) do_not_optimize(s->find('Z')); }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) { for (; n; --n) do_not_optimize(in.tail_char.find('Z')); }; } });
+
+	benchmarks.push_back({ "rfind_char", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.head_char));
+			return [s](std::uint64_t n) { for (; n; --n) do_not_optimize(s->rfind('Z')); }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) { for (; n; --n) do_not_optimize(in.head_char.rfind('Z')); }; } });
+
+	benchmarks.push_back({ "find_substring", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.tail_needle));
+			return [s, &in](std::uint64_t n) { for (; n; --n) do_not_optimize(s->find(in.needle)); }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) { for (; n; --n) do_not_optimize(in.tail_needle.find(in.needle)); }; } });
+
+	benchmarks.push_back({ "rfind_substring", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.head_needle));
+			return [s, &in](std::uint64_t n) { for (; n; --n) do_not_optimize(s->rfind(in.needle)); }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) { for (; n; --n) do_not_optimize(in.head_needle.rfind(in.needle)); }; } });
+
+	benchmarks.push_back({ "split", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.text));
+			return [s](std::uint64_t n) { std::vector<std::string_view> out; for (; n; --n) { out.clear(); s->split(',', out); do_not_optimize(out.data()); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			std::vector<std::string_view> out;
+			for (; n; --n)
+			{
+				out.clear();
+				const std::string_view text = in.text;
+				std::size_t last = 0;
+				for (std::size_t found = text.find(','); found != text.npos; found = text.find(',', last)) { out.push_back(text.substr(last, found - last)); last = found + 1; }
+				if (last < text.size()) out.push_back(text.substr(last));
+				do_not_optimize(out.data());
+			} }; } });
+
+	// Owning pieces: one blob for spl::string_table against a std::string per field
+	benchmarks.push_back({ "split_owned", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.text));
+			return [s](std::uint64_t n) { spl::string_table out; for (; n; --n) { out.clear(); s->split_into(',', out); do_not_optimize(out.offsets()); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			std::vector<std::string> out;
+			for (; n; --n)
+			{
+				out.clear();
+				const std::string_view text = in.text;
+				std::size_t last = 0;
+				for (std::size_t found = text.find(','); found != text.npos; found = text.find(',', last)) { out.emplace_back(text.substr(last, found - last)); last = found + 1; }
+				if (last < text.size()) out.emplace_back(text.substr(last));
+				do_not_optimize(out.data());
+			} }; } });
+
+	// Many short rows appended into one table a split_into() call at a time, which has to stay linear in the total
+	benchmarks.push_back({ "split_rows_into", unlimited, false,
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			spl::string_table out;
+			for (; n; --n)
+			{
+				out.clear();
+				const std::string_view text = in.text;
+				for (std::size_t row = 0; row < text.size(); row += 64) spl::split_into(text.substr(row, 64), ',', out);
+				do_not_optimize(out.offsets());
+			} }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			std::vector<std::string> out;
+			for (; n; --n)
+			{
+				out.clear();
+				const std::string_view text = in.text;
+				for (std::size_t row = 0; row < text.size(); row += 64)
+				{
+					const std::string_view line = text.substr(row, 64);
+					std::size_t last = 0;
+					for (std::size_t found = line.find(','); found != line.npos; found = line.find(',', last)) { out.emplace_back(line.substr(last, found - last)); last = found + 1; }
+					if (last < line.size()) out.emplace_back(line.substr(last));
+				}
+				do_not_optimize(out.data());
+			} }; } });
+
+	benchmarks.push_back({ "rsplit", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.head_char));
+			return [s](std::uint64_t n) { for (; n; --n) do_not_optimize(s->rsplit('Z')); }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { const std::string_view text = in.head_char; const std::size_t found = text.rfind('Z');
+				do_not_optimize(found == text.npos ? text : text.substr(found + 1)); } }; } });
+
+	benchmarks.push_back({ "lower", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.text));
+			return [s](std::uint64_t n) { for (; n; --n) { spl::string low = s->lower(); do_not_optimize(low); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { std::string low = in.text; std::transform(low.begin(), low.end(), low.begin(), ::tolower); do_not_optimize(low); } }; } });
+
+	benchmarks.push_back({ "upper", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.text));
+			return [s](std::uint64_t n) { for (; n; --n) { spl::string up = s->upper(); do_not_optimize(up); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { std::string up = in.text; std::transform(up.begin(), up.end(), up.begin(), ::toupper); do_not_optimize(up); } }; } });
+
+	benchmarks.push_back({ "reverse", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.text));
+			return [s](std::uint64_t n) { for (; n; --n) { spl::string rev = s->reverse(); do_not_optimize(rev); } }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) {
+			for (; n; --n) { std::string rev(in.text.rbegin(), in.text.rend()); do_not_optimize(rev); } }; } });
+
+	// Erases the first byte and appends one so the size stays put between iterations
+	benchmarks.push_back({ "erase_front", 16 * 1024 * 1024, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.text));
+			return [s](std::uint64_t n) { for (; n; --n) { if (s->empty()) break; s->erase(0, 1); s->push_back('x'); do_not_optimize(*s); } }; },
+		[](const inputs &in) -> op_function { auto s = std::make_shared<std::string>(in.text);
+			return [s](std::uint64_t n) { for (; n; --n) { if (s->empty()) break; s->erase(0, 1); s->push_back('x'); do_not_optimize(*s); } }; } });
+
+	benchmarks.push_back({ "get_as<int>", unlimited, true,
+		[](const inputs &) -> op_function { auto s = std::make_shared<spl::string>("123456789");
+			return [s](std::uint64_t n) { for (; n; --n) { do_not_optimize(*s); do_not_optimize(s->get_as<int>()); } }; },
+		[](const inputs &) -> op_function { auto s = std::make_shared<std::string>("123456789");
+			return [s](std::uint64_t n) { for (; n; --n) { do_not_optimize(*s); do_not_optimize(std::stoi(*s)); } }; } });
+
+	benchmarks.push_back({ "to_string", unlimited, true,
+		[](const inputs &) -> op_function { return [](std::uint64_t n) { int value = 123456789; for (; n; --n) { do_not_optimize(value); spl::string s = spl::to_string(value); do_not_optimize(s); } }; },
+		[](const inputs &) -> op_function { return [](std::uint64_t n) { int value = 123456789; for (; n; --n) { do_not_optimize(value); std::string s = std::to_string(value); do_not_optimize(s); } }; } });
+
+	benchmarks.push_back({ "hash", unlimited, false,
+		[](const inputs &in) -> op_function { auto s = std::make_shared<spl::string>(std::string_view(in.text));
+			return [s](std::uint64_t n) { for (; n; --n) do_not_optimize(std::hash<spl::string>{}(*s)); }; },
+		[](const inputs &in) -> op_function { return [&](std::uint64_t n) { for (; n; --n) do_not_optimize(std::hash<std::string>{}(in.text)); }; } });
+
+	return benchmarks;
+}
+
+void write_json(std::FILE *file, const std::vector<result> &results)
+{
+	std::fprintf(file, "{\n  \"counts_allocations\": %s,\n  \"has_cycles\": %s,\n  \"results\": [\n",
+		kCountsAllocations ? "true" : "false", kHasCycles ? "true" : "false");
+
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const result &r = results[i];
+
+		std::fprintf(file, "    { \"op\": \"%s\", \"impl\": \"%s\", \"size\": %zu, \"iterations\": %llu, \"ns_per_op\": %.3f, "
+			"\"bytes_per_second\": %.1f, \"allocations_per_op\": %.4f, \"reallocations_per_op\": %.4f, \"cycles_per_byte\": ",
+			r.op.c_str(), r.impl, r.size, static_cast<unsigned long long>(r.iterations), r.ns_per_op,
+			r.bytes_per_second, r.allocations_per_op, r.reallocations_per_op);
+
+		if (r.cycles_per_byte < 0)
+			std::fprintf(file, "null }");
+		else
+			std::fprintf(file, "%.4f }", r.cycles_per_byte);
+
+		std::fprintf(file, i + 1 < results.size() ? ",\n" : "\n");
+	}
+
+	std::fprintf(file, "  ]\n}\n");
+}
+
+bool parse_options(int argc, char **argv, options &opts)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+
+		if (i + 1 >= argc)
+			return false;
+
+		if (arg == "--filter")
+			opts.filter = argv[++i];
+		else if (arg == "--max-size")
+			opts.max_size = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--min-time")
+			opts.min_time = std::strtod(argv[++i], nullptr);
+		else if (arg == "--json")
+			opts.json_path = argv[++i];
+		else
+			return false;
+	}
+
+	return true;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	options opts;
+
+	if (!parse_options(argc, argv, opts))
+	{
+		std::fprintf(stderr, "usage: %s [--filter <substring>] [--max-size <bytes>] [--min-time <seconds>] [--json <file>]\n", argv[0]);
+		return 1;
+	}
+
+	const std::size_t sizes[] = { 0, 16, 64, 256, 1024, 4096, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+	const std::vector<benchmark> benchmarks = make_benchmarks();
+	std::vector<result> results;
+
+	std::fprintf(stderr, "%-16s %-4s %10s %14s %12s %10s %10s\n", "op", "impl", "size", "ns/op", "MB/s", "allocs/op", "cyc/byte");
+
+	for (const std::size_t size : sizes)
+	{
+		if (size > opts.max_size)
+			break;
+
+		const inputs in(size);
+
+		for (const benchmark &bench : benchmarks)
+		{
+			if (!opts.filter.empty() && std::string_view(bench.name).find(opts.filter) == std::string_view::npos)
+				continue;
+
+			if (size > bench.max_size || (bench.size_independent && size != sizes[0]))
+				continue;
+
+			const std::size_t reported_size = bench.size_independent ? 0 : size;
+
+			for (const auto &[impl, make] : { std::pair<const char*, const std::function<op_function(const inputs &)>&>("spl", bench.spl_op),
+				std::pair<const char*, const std::function<op_function(const inputs &)>&>("std", bench.std_op) })
+			{
+				const result r = measure(bench.name, impl, reported_size, make(in), opts.min_time);
+				results.push_back(r);
+
+				std::fprintf(stderr, "%-16s %-4s %10zu %14.1f %12.1f %10.3f %10.3f\n", r.op.c_str(), r.impl, r.size, r.ns_per_op,
+					r.bytes_per_second / (1024.0 * 1024.0), r.allocations_per_op + r.reallocations_per_op, r.cycles_per_byte);
+			}
+		}
+	}
+
+	if (opts.json_path)
+	{
+		std::FILE *file = std::fopen(opts.json_path, "w");
+
+		if (!file)
+		{
+			std::perror(opts.json_path);
+			return 1;
+		}
+
+		write_json(file, results);
+		std::fclose(file);
+	}
+	else
+	{
+		write_json(stdout, results);
+	}
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+// spl::text_index against scanning the corpus with find() for every query.
+//
+// Usage: bench_text_index [megabytes]
+
+#include "spltextindex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Words with a skewed distribution, so some queries hit a lot and others hardly at all
+spl::string make_corpus(std::size_t size, std::vector<std::string> &words)
+{
+	std::mt19937_64 rng(1);
+
+	for (std::size_t i = 0; i < 20000; ++i)
+	{
+		std::string word;
+
+		for (std::size_t j = 0, length = 3 + rng() % 8; j < length; ++j)
+			word += static_cast<char>('a' + rng() % 26);
+
+		words.push_back(word);
+	}
+
+	std::string corpus;
+	corpus.reserve(size + 16);
+
+	while (corpus.size() < size)
+	{
+		const double skew = std::uniform_real_distribution<double>(0, 1)(rng);
+		corpus += words[static_cast<std::size_t>(skew * skew * skew * words.size())];
+		corpus += rng() % 12 ? ' ' : '\n';
+	}
+
+	return spl::string(corpus);
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename F>
+void run(const char *method, const std::vector<std::string> &queries, F f, bool &first)
+{
+	std::size_t total = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (const std::string &query : queries)
+		total += f(query);
+
+	const double ms = elapsed_ms(start);
+
+	std::printf("%s  { \"method\": \"%s\", \"queries\": %zu, \"us_per_query\": %.2f, \"occurrences\": %zu }",
+		first ? "" : ",\n", method, queries.size(), ms * 1000 / queries.size(), total);
+	first = false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	const std::size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 32;
+
+	std::vector<std::string> words;
+	const spl::string corpus = make_corpus(megabytes << 20, words);
+
+	std::mt19937_64 rng(2);
+	std::vector<std::string> queries(2000);
+
+	for (std::string &query : queries)
+		query = words[rng() % words.size()] + (rng() % 2 ? " " + words[rng() % 256] : std::string());
+
+	bool first = true;
+	std::printf("[\n");
+
+	const auto build = [&](const char *method, const spl::text_index_options &options)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		spl::text_index index(corpus, options);
+		const double ms = elapsed_ms(start);
+
+		std::printf("%s  { \"method\": \"%s\", \"text_bytes\": %zu, \"index_bytes\": %zu, \"build_ms\": %.0f }",
+			first ? "" : ",\n", method, corpus.size(), index.memory_usage(), ms);
+		first = false;
+
+		return index;
+	};
+
+	spl::text_index_options fm_options;
+	fm_options.mode = spl::text_index_mode::fm_index;
+
+	spl::text_index_options parallel_options = fm_options;
+	parallel_options.parallel = true;
+
+	const spl::text_index suffix_array = build("build suffix_array", {});
+	const spl::text_index fm_index = build("build fm_index", fm_options);
+	build("build fm_index parallel", parallel_options);
+
+	// Note: The scan only gets the first few queries, it's the whole corpus every time
+	const std::vector<std::string> scan_queries(queries.begin(), queries.begin() + 20);
+
+	run("find() scan count", scan_queries, [&](const std::string &query)
+	{
+		std::size_t count = 0;
+
+		for (std::size_t at = corpus.find(query); at != spl::string::npos; at = corpus.find(query, at + 1))
+			++count;
+
+		return count;
+	}, first);
+
+	run("suffix_array count", queries, [&](const std::string &query) { return suffix_array.count(query); }, first);
+	run("fm_index count", queries, [&](const std::string &query) { return fm_index.count(query); }, first);
+	run("suffix_array locate", queries, [&](const std::string &query) { return suffix_array.locate(query).size(); }, first);
+	run("fm_index locate", queries, [&](const std::string &query) { return fm_index.locate(query).size(); }, first);
+
+	std::printf("\n]\n");
+}
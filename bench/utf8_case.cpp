@@ -0,0 +1,103 @@
+// Throughput of utf8_lower()/utf8_upper()/utf8_casefold() on corpora with different script mixes,
+// next to the ASCII-only lower() and a per code point std::towlower() loop.
+
+#include "splstring.h"
+
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <cwctype>
+#include <functional>
+#include <random>
+
+namespace
+{
+
+spl::string make_corpus(const std::vector<const char*> &words, std::size_t size)
+{
+	std::mt19937 rng(1234);
+	std::string corpus;
+
+	while (corpus.size() < size)
+	{
+		corpus += words[rng() % words.size()];
+		corpus += ' ';
+	}
+
+	return spl::string(std::string_view(corpus));
+}
+
+// Touches the output so the compiler can't drop the work
+template <typename T>
+std::size_t consume(const T &str)
+{
+	return str.size() + static_cast<unsigned char>(str.empty() ? 0 : str[str.size() / 2]);
+}
+
+std::string towlower_loop(const std::string_view &view)
+{
+	std::string out;
+	out.reserve(view.size());
+
+	for (spl::utf8_view::iterator it = spl::utf8_view(view).begin(), end = spl::utf8_view(view).end(); it != end; ++it)
+	{
+		char buffer[4];
+		char *last = spl::detail::encode_utf8(static_cast<char32_t>(std::towlower(static_cast<wint_t>(*it))), buffer);
+		out.append(buffer, last - buffer);
+	}
+
+	return out;
+}
+
+void run(const char *corpus_name, const char *op_name, const spl::string &corpus, const std::function<std::size_t()> &op)
+{
+	using clock = std::chrono::steady_clock;
+
+	std::size_t sink = 0;
+	std::size_t iterations = 0;
+	const auto start = clock::now();
+	auto elapsed = clock::duration();
+
+	do
+	{
+		sink += op();
+		++iterations;
+		elapsed = clock::now() - start;
+	}
+	while (elapsed < std::chrono::milliseconds(300));
+
+	const double seconds = std::chrono::duration<double>(elapsed).count();
+	const double mb_per_second = double(corpus.size()) * iterations / seconds / (1024.0 * 1024.0);
+
+	std::printf("%-10s %-16s %10.1f MB/s  (%zu)\n", corpus_name, op_name, mb_per_second, sink % 10);
+}
+
+}
+
+int main()
+{
+	std::setlocale(LC_ALL, "C.UTF-8");
+
+	const std::size_t size = 4 * 1024 * 1024;
+
+	const std::vector<std::pair<const char*, spl::string>> corpora = {
+		{ "english", make_corpus({ "The", "quick", "Brown", "fox", "JUMPS", "over", "the", "lazy", "Dog" }, size) },
+		{ "german", make_corpus({ "Straße", "Grüße", "ÄRGER", "über", "Fußball", "Öffnung", "und", "der" }, size) },
+		{ "greek", make_corpus({ "Καλημέρα", "ΚΌΣΜΕ", "ελληνικά", "ΑΘΗΝΑ", "φίλος" }, size) },
+		{ "cyrillic", make_corpus({ "Привет", "МИР", "русский", "Москва", "ЯЗЫК" }, size) },
+		{ "mixed", make_corpus({ "Hello", "Straße", "ΚΌΣΜΕ", "Привет", "東京", "İstanbul", "ǅemal", "WORLD" }, size) },
+	};
+
+	for (const auto &[name, corpus] : corpora)
+	{
+		const spl::string &text = corpus;
+
+		run(name, "lower (ascii)", text, [&] { return consume(text.lower()); });
+		run(name, "utf8_lower", text, [&] { return consume(text.utf8_lower()); });
+		run(name, "utf8_upper", text, [&] { return consume(text.utf8_upper()); });
+		run(name, "utf8_casefold", text, [&] { return consume(text.utf8_casefold()); });
+		run(name, "towlower loop", text, [&] { return consume(towlower_loop(text.view())); });
+	}
+
+	return 0;
+}
@@ -0,0 +1,424 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+// A size-class buffer pool for short-lived string storage.
+//
+// Requests up to 32 KiB are rounded up to a power of two and served from a per-thread free list, so the common
+// allocate/free pair never touches the global allocator or takes a lock. Each thread caches a bounded number of
+// blocks per class and hands half of them to a shared depot when it overflows, refilling from the depot when it
+// runs dry. Larger requests go straight to malloc.
+//
+// Every block is its own malloc allocation with a small header in front, so a block can be freed on any thread:
+// it simply joins that thread's cache. Blocks freed after a thread's cache has been torn down go back to the system.
+//
+// spl::string uses this for its storage when SPL_STRING_POOLED_STORAGE is defined. That define must be the same in
+// every translation unit, so set it on the command line rather than before an #include.
+
+namespace spl
+{
+
+namespace detail
+{
+
+constexpr std::size_t pool_min_block_shift = 4;
+constexpr std::size_t pool_class_count = 12;    // 16 B to 32 KiB
+constexpr std::size_t pool_large_class = pool_class_count;
+constexpr std::size_t pool_max_block = std::size_t(1) << (pool_min_block_shift + pool_class_count - 1);
+constexpr std::size_t pool_cache_bytes = 256 * 1024;
+constexpr std::size_t pool_depot_factor = 16;
+
+struct alignas(16) pool_header
+{
+	std::size_t size_class;
+	std::size_t capacity;
+};
+
+static_assert(sizeof(pool_header) == 16);
+
+struct pool_node
+{
+	pool_node *next;
+};
+
+constexpr std::size_t pool_block_size(std::size_t size_class) noexcept
+{
+	return std::size_t(1) << (size_class + pool_min_block_shift);
+}
+
+// How many blocks of a class a thread keeps before spilling half to the depot
+constexpr std::size_t pool_cache_limit(std::size_t size_class) noexcept
+{
+	return std::clamp<std::size_t>(pool_cache_bytes / pool_block_size(size_class), 8, 512);
+}
+
+inline std::size_t pool_size_class(std::size_t size) noexcept
+{
+	if (size <= pool_block_size(0))
+		return 0;
+
+	if (size > pool_max_block)
+		return pool_large_class;
+
+	// Bit width of size - 1 is the power of two that fits it
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, size - 1);
+	return index + 1 - pool_min_block_shift;
+#elif defined(__GNUC__) || defined(__clang__)
+	return (sizeof(unsigned long long) * 8 - __builtin_clzll(size - 1)) - pool_min_block_shift;
+#else
+	std::size_t size_class = 0;
+
+	while (pool_block_size(size_class) < size)
+		++size_class;
+
+	return size_class;
+#endif
+}
+
+inline pool_header *pool_header_of(void *ptr) noexcept
+{
+	return static_cast<pool_header*>(ptr) - 1;
+}
+
+inline void *pool_system_allocate(std::size_t size_class, std::size_t capacity) noexcept
+{
+	pool_header *header = static_cast<pool_header*>(std::malloc(sizeof(pool_header) + capacity));
+
+	if (!header)
+		return nullptr;
+
+	header->size_class = size_class;
+	header->capacity = capacity;
+
+	return header + 1;
+}
+
+inline void pool_system_free_list(pool_node *node) noexcept
+{
+	while (node)
+	{
+		pool_node *next = node->next;
+		std::free(pool_header_of(node));
+		node = next;
+	}
+}
+
+// Shared between threads. Never destroyed so blocks freed during static destruction still have somewhere to go.
+struct pool_depot
+{
+	std::mutex lock;
+	pool_node *heads[pool_class_count] = {};
+	std::size_t counts[pool_class_count] = {};
+
+	static pool_depot &get()
+	{
+		static pool_depot *depot = new pool_depot;
+		return *depot;
+	}
+
+	// Takes ownership of a chain of count blocks, or frees it if the depot is already full for that class
+	void push(std::size_t size_class, pool_node *head, pool_node *tail, std::size_t count) noexcept
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			if (counts[size_class] + count <= pool_cache_limit(size_class) * pool_depot_factor)
+			{
+				tail->next = heads[size_class];
+				heads[size_class] = head;
+				counts[size_class] += count;
+				return;
+			}
+		}
+
+		tail->next = nullptr;
+		pool_system_free_list(head);
+	}
+
+	// Detaches up to max_count blocks, returning the chain and setting count to how many were taken
+	pool_node *pop(std::size_t size_class, std::size_t max_count, std::size_t &count) noexcept
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		pool_node *head = heads[size_class];
+		pool_node *tail = nullptr;
+		count = 0;
+
+		for (pool_node *node = head; node && count < max_count; node = node->next)
+		{
+			tail = node;
+			++count;
+		}
+
+		if (!tail)
+			return nullptr;
+
+		heads[size_class] = tail->next;
+		counts[size_class] -= count;
+		tail->next = nullptr;
+
+		return head;
+	}
+
+	void release() noexcept
+	{
+		pool_node *lists[pool_class_count];
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			for (std::size_t i = 0; i < pool_class_count; ++i)
+			{
+				lists[i] = std::exchange(heads[i], nullptr);
+				counts[i] = 0;
+			}
+		}
+
+		for (pool_node *list : lists)
+			pool_system_free_list(list);
+	}
+};
+
+// Constant-initialized with a trivial destructor so it stays usable during thread teardown.
+// The flush on thread exit is done by pool_cache_guard below.
+struct pool_cache
+{
+	pool_node *heads[pool_class_count];
+	std::uint32_t counts[pool_class_count];
+	bool registered;
+	bool destroyed;
+};
+
+inline thread_local pool_cache pool_thread_cache {};
+
+inline void pool_flush(pool_cache &cache) noexcept
+{
+	for (std::size_t i = 0; i < pool_class_count; ++i)
+	{
+		pool_node *head = cache.heads[i];
+
+		if (!head)
+			continue;
+
+		pool_node *tail = head;
+
+		while (tail->next)
+			tail = tail->next;
+
+		pool_depot::get().push(i, head, tail, cache.counts[i]);
+
+		cache.heads[i] = nullptr;
+		cache.counts[i] = 0;
+	}
+}
+
+struct pool_cache_guard
+{
+	pool_cache *cache = nullptr;
+
+	~pool_cache_guard()
+	{
+		if (cache)
+			pool_flush(*cache);
+
+		pool_thread_cache.destroyed = true;
+	}
+};
+
+inline thread_local pool_cache_guard pool_thread_guard;
+
+// Called before a thread's cache first takes blocks, whether they come from the depot or from deallocate().
+// Note: Storing into the guard is what constructs it, and with it schedules the flush on thread exit
+inline void pool_register(pool_cache &cache) noexcept
+{
+	if (cache.registered)
+		return;
+
+	cache.registered = true;
+	pool_thread_guard.cache = &cache;
+}
+
+}
+
+class buffer_pool
+{
+public:
+
+	// Returns nullptr if the system allocator fails, like malloc
+	static void *allocate(std::size_t size) noexcept
+	{
+		const std::size_t size_class = detail::pool_size_class(size);
+
+		if (size_class == detail::pool_large_class)
+			return detail::pool_system_allocate(size_class, size);
+
+		detail::pool_cache &cache = detail::pool_thread_cache;
+
+		if (!cache.heads[size_class] && !cache.destroyed)
+			refill(cache, size_class);
+
+		if (detail::pool_node *node = cache.heads[size_class])
+		{
+			cache.heads[size_class] = node->next;
+			--cache.counts[size_class];
+			return node;
+		}
+
+		return detail::pool_system_allocate(size_class, detail::pool_block_size(size_class));
+	}
+
+	// Stays in place while the size still maps to the same class
+	static void *reallocate(void *ptr, std::size_t size) noexcept
+	{
+		if (!ptr)
+			return allocate(size);
+
+		detail::pool_header *header = detail::pool_header_of(ptr);
+		const std::size_t size_class = detail::pool_size_class(size);
+
+		if (size_class == header->size_class)
+		{
+			if (size_class != detail::pool_large_class)
+				return ptr;
+
+			detail::pool_header *resized = static_cast<detail::pool_header*>(std::realloc(header, sizeof(detail::pool_header) + size));
+
+			if (!resized)
+				return nullptr;
+
+			resized->capacity = size;
+			return resized + 1;
+		}
+
+		void *moved = allocate(size);
+
+		if (!moved)
+			return nullptr;
+
+		std::memcpy(moved, ptr, std::min<std::size_t>(header->capacity, size));
+		deallocate(ptr);
+
+		return moved;
+	}
+
+	static void deallocate(void *ptr) noexcept
+	{
+		if (!ptr)
+			return;
+
+		detail::pool_header *header = detail::pool_header_of(ptr);
+		const std::size_t size_class = header->size_class;
+
+		detail::pool_cache &cache = detail::pool_thread_cache;
+
+		if (size_class == detail::pool_large_class || cache.destroyed)
+		{
+			std::free(header);
+			return;
+		}
+
+		detail::pool_register(cache);
+
+		detail::pool_node *node = static_cast<detail::pool_node*>(ptr);
+		node->next = cache.heads[size_class];
+		cache.heads[size_class] = node;
+
+		if (++cache.counts[size_class] > detail::pool_cache_limit(size_class))
+			spill(cache, size_class);
+	}
+
+	// Usable bytes behind a pointer returned by allocate() or reallocate()
+	static std::size_t capacity(const void *ptr) noexcept
+	{
+		return ptr ? detail::pool_header_of(const_cast<void*>(ptr))->capacity : 0;
+	}
+
+	// Returns the calling thread's cached blocks and everything in the shared depot to the system
+	static void trim() noexcept
+	{
+		detail::pool_cache &cache = detail::pool_thread_cache;
+
+		for (std::size_t i = 0; i < detail::pool_class_count; ++i)
+		{
+			detail::pool_system_free_list(cache.heads[i]);
+			cache.heads[i] = nullptr;
+			cache.counts[i] = 0;
+		}
+
+		detail::pool_depot::get().release();
+	}
+
+private:
+
+	static void refill(detail::pool_cache &cache, std::size_t size_class) noexcept
+	{
+		detail::pool_register(cache);
+
+		std::size_t count;
+		cache.heads[size_class] = detail::pool_depot::get().pop(size_class, detail::pool_cache_limit(size_class) / 2, count);
+		cache.counts[size_class] = static_cast<std::uint32_t>(count);
+	}
+
+	// Keeps the most recently freed half, which is most likely to still be in cache
+	static void spill(detail::pool_cache &cache, std::size_t size_class) noexcept
+	{
+		const std::size_t keep = cache.counts[size_class] / 2;
+		detail::pool_node *last_kept = cache.heads[size_class];
+
+		for (std::size_t i = 1; i < keep; ++i)
+			last_kept = last_kept->next;
+
+		detail::pool_node *head = last_kept->next;
+		detail::pool_node *tail = head;
+		std::size_t count = 1;
+
+		while (tail->next)
+		{
+			tail = tail->next;
+			++count;
+		}
+
+		last_kept->next = nullptr;
+		cache.counts[size_class] = static_cast<std::uint32_t>(keep);
+
+		detail::pool_depot::get().push(size_class, head, tail, count);
+	}
+};
+
+}
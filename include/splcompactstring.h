@@ -0,0 +1,284 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+namespace spl
+{
+
+// A 16 byte immutable string for sorting, joining and deduplicating large sets of keys.
+//
+// Layout is a 4 byte length followed by 12 bytes that hold the whole string if it fits, or otherwise the first
+// 4 bytes of it and a pointer to a heap copy. Since the length and the first 4 bytes are always inline, most
+// comparisons are decided without following the pointer, and short strings never allocate at all.
+//
+// Strings are limited to 4 GiB - 1 bytes. There's no c_str(), as a 12 byte string has no room for the terminator.
+class alignas(8) compact_string
+{
+public:
+
+	using size_type = std::size_t;
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+	constexpr static size_type inline_capacity = 12;
+	constexpr static size_type prefix_size = 4;
+
+	compact_string() noexcept = default;
+
+	compact_string(const std::string_view &sv)
+	{
+		assign_view(sv);
+	}
+
+	compact_string(const char *str) : compact_string(std::string_view(str)) {}
+	compact_string(const string &str) : compact_string(str.view()) {}
+	compact_string(const std::string &str) : compact_string(std::string_view(str)) {}
+
+	compact_string(const compact_string &other)
+	{
+		assign_view(other.view());
+	}
+
+	compact_string(compact_string &&other) noexcept :
+		mLength(std::exchange(other.mLength, 0))
+	{
+		std::memcpy(mData, other.mData, sizeof(mData));
+		std::memset(other.mData, 0, sizeof(other.mData));
+	}
+
+	compact_string &operator=(const compact_string &rhs)
+	{
+		if (&rhs != this)
+			*this = compact_string(rhs);
+
+		return *this;
+	}
+
+	compact_string &operator=(compact_string &&rhs) noexcept
+	{
+		if (&rhs == this)
+			return *this;
+
+		release();
+
+		mLength = std::exchange(rhs.mLength, 0);
+		std::memcpy(mData, rhs.mData, sizeof(mData));
+		std::memset(rhs.mData, 0, sizeof(rhs.mData));
+
+		return *this;
+	}
+
+	~compact_string()
+	{
+		release();
+	}
+
+	const char *data() const noexcept { return is_inline() ? mData : heap(); }
+
+	size_type size() const noexcept { return mLength; }
+	size_type length() const noexcept { return mLength; }
+	bool empty() const noexcept { return mLength == 0; }
+
+	bool is_inline() const noexcept { return mLength <= inline_capacity; }
+
+	std::string_view view() const noexcept { return { data(), size() }; }
+	operator std::string_view() const noexcept { return view(); }
+
+	explicit operator spl::string() const { return spl::string(view()); }
+	std::string std_string() const { return std::string(view()); }
+
+	char operator[](size_type pos) const noexcept { return data()[pos]; }
+
+	// The first 4 bytes, zero padded, as a big-endian integer, so ordering prefixes orders the strings
+	std::uint32_t prefix() const noexcept
+	{
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(mData);
+		return std::uint32_t(bytes[0]) << 24 | std::uint32_t(bytes[1]) << 16 | std::uint32_t(bytes[2]) << 8 | std::uint32_t(bytes[3]);
+	}
+
+	int compare(const compact_string &other) const noexcept
+	{
+		const std::uint32_t lhs_prefix = prefix();
+		const std::uint32_t rhs_prefix = other.prefix();
+
+		if (lhs_prefix != rhs_prefix)
+			return lhs_prefix < rhs_prefix ? -1 : 1;
+
+		// Both inline: the zero padded payloads order the same way the strings do, with length breaking ties
+		if (is_inline() && other.is_inline())
+		{
+			const std::uint64_t lhs_rest = big_endian_tail();
+			const std::uint64_t rhs_rest = other.big_endian_tail();
+
+			if (lhs_rest != rhs_rest)
+				return lhs_rest < rhs_rest ? -1 : 1;
+
+			return size() == other.size() ? 0 : (size() < other.size() ? -1 : 1);
+		}
+
+		// Note: Zero padding means a prefix tie can still differ in length, e.g. "ab" and "ab\0"
+		const size_type common = std::min(size(), other.size());
+
+		if (common > prefix_size)
+		{
+			if (const int result = std::memcmp(data() + prefix_size, other.data() + prefix_size, common - prefix_size))
+				return result;
+		}
+
+		return size() == other.size() ? 0 : (size() < other.size() ? -1 : 1);
+	}
+
+	int compare(const std::string_view &sv) const noexcept
+	{
+		return view().compare(sv);
+	}
+
+	bool operator==(const compact_string &rhs) const noexcept
+	{
+		// Length and prefix in one go
+		if (head() != rhs.head())
+			return false;
+
+		if (is_inline())
+			return tail() == rhs.tail();
+
+		return std::memcmp(heap() + prefix_size, rhs.heap() + prefix_size, size() - prefix_size) == 0;
+	}
+
+	bool operator!=(const compact_string &rhs) const noexcept { return !(*this == rhs); }
+	bool operator<(const compact_string &rhs) const noexcept { return compare(rhs) < 0; }
+	bool operator>(const compact_string &rhs) const noexcept { return compare(rhs) > 0; }
+	bool operator<=(const compact_string &rhs) const noexcept { return compare(rhs) <= 0; }
+	bool operator>=(const compact_string &rhs) const noexcept { return compare(rhs) >= 0; }
+
+	// Inline strings are hashed straight from their 16 bytes. Not the same value as std::hash<std::string_view>.
+	std::size_t hash() const noexcept
+	{
+		if (!is_inline())
+			return std::hash<std::string_view>{}(view());
+
+		std::uint64_t hash = head() * 0x9E3779B97F4A7C15ull;
+		hash ^= tail() + 0x632BE59BD9B4E019ull + (hash << 6) + (hash >> 2);
+		hash *= 0xBF58476D1CE4E5B9ull;
+
+		return static_cast<std::size_t>(hash ^ (hash >> 31));
+	}
+
+	bool operator==(const std::string_view &rhs) const noexcept { return view() == rhs; }
+	bool operator!=(const std::string_view &rhs) const noexcept { return view() != rhs; }
+	bool operator==(const char *rhs) const noexcept { return view() == rhs; }
+	bool operator!=(const char *rhs) const noexcept { return view() != rhs; }
+
+	friend std::ostream &operator<<(std::ostream &os, const compact_string &str)
+	{
+		return os << str.view();
+	}
+
+private:
+
+	void assign_view(const std::string_view &sv)
+	{
+		if (sv.size() > std::numeric_limits<std::uint32_t>::max())
+			throw std::length_error("string too long");
+
+		if (sv.size() <= inline_capacity)
+		{
+			if (!sv.empty())
+				std::memcpy(mData, sv.data(), sv.size());
+
+			mLength = static_cast<std::uint32_t>(sv.size());
+			return;
+		}
+
+		char *buffer = detail::storage_allocate(sv.size());
+
+		if (!buffer)
+			throw std::bad_alloc();
+
+		std::memcpy(buffer, sv.data(), sv.size());
+		std::memcpy(mData, sv.data(), prefix_size);
+		std::memcpy(mData + prefix_size, &buffer, sizeof(buffer));
+
+		mLength = static_cast<std::uint32_t>(sv.size());
+	}
+
+	void release() noexcept
+	{
+		if (!is_inline())
+			detail::storage_free(const_cast<char*>(heap()));
+	}
+
+	const char *heap() const noexcept
+	{
+		const char *buffer;
+		std::memcpy(&buffer, mData + prefix_size, sizeof(buffer));
+		return buffer;
+	}
+
+	std::uint64_t head() const noexcept
+	{
+		std::uint32_t prefix;
+		std::memcpy(&prefix, mData, sizeof(prefix));
+		return std::uint64_t(mLength) << 32 | prefix;
+	}
+
+	std::uint64_t tail() const noexcept
+	{
+		std::uint64_t value;
+		std::memcpy(&value, mData + prefix_size, sizeof(value));
+		return value;
+	}
+
+	std::uint64_t big_endian_tail() const noexcept
+	{
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(mData + prefix_size);
+		std::uint64_t value = 0;
+
+		for (size_type i = 0; i < sizeof(value); ++i)
+			value = value << 8 | bytes[i];
+
+		return value;
+	}
+
+	// Note: Unused inline bytes are kept zeroed so head() and tail() can compare them wholesale
+	std::uint32_t mLength = 0;
+	char mData[inline_capacity] = {};
+};
+
+static_assert(sizeof(compact_string) == 16);
+
+}
+
+namespace std
+{
+	template<> struct hash<spl::compact_string>
+	{
+		std::size_t operator()(const spl::compact_string &str) const noexcept
+		{
+			return str.hash();
+		}
+	};
+}
@@ -0,0 +1,643 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+#include <iterator>
+#include <map>
+
+// A column of many short strings kept compressed, each one on its own so any of them can be read back without
+// touching the rest.
+//
+//	auto urls = spl::compressed_strings::from(lines);
+//	spl::string url = urls[42];
+//	size_type index = urls.find("https://example.com/");
+//
+// The compression is FSST (Boncz, Neumann and Leis, "FSST: Fast Random Access String Compression"). A table of up
+// to 255 symbols, each 1 to 8 bytes, is trained on a sample of the strings, and every string is stored as one-byte
+// codes for those symbols. Bytes no symbol covers are stored as an escape code followed by the byte itself.
+// Decompressing is a table lookup and an 8-byte store per code, four codes at a time when none of them is an escape.
+//
+// Compression always picks the same codes for the same string, so find() compresses the string it's looking for
+// once and compares compressed bytes, without decompressing anything.
+//
+// Strings are packed back to back in one buffer with a 32-bit end offset each, plus a 64-bit base offset for every
+// 128 strings. There's no per-string allocation.
+
+namespace spl
+{
+
+namespace detail
+{
+
+constexpr unsigned fsst_escape = 255;
+constexpr std::size_t fsst_max_symbols = 255;
+constexpr std::size_t fsst_hash_bits = 10;
+constexpr std::size_t fsst_sample_bytes = 1 << 16;
+constexpr std::size_t fsst_generations = 5;
+
+// Up to 8 bytes in memory order, zero padded
+inline std::uint64_t fsst_load(const char *str, std::size_t size) noexcept
+{
+	std::uint64_t word = 0;
+	std::memcpy(&word, str, size < 8 ? size : 8);
+	return word;
+}
+
+// Keeps the first length bytes of a word from fsst_load()
+inline std::uint64_t fsst_mask(std::size_t length) noexcept
+{
+	if (length >= 8)
+		return ~std::uint64_t(0);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return ~(~std::uint64_t(0) >> (length * 8));
+#else
+	return (std::uint64_t(1) << (length * 8)) - 1;
+#endif
+}
+
+// Slot for symbols of 3 bytes or more, from their first 3 bytes
+inline std::size_t fsst_hash(const char *str) noexcept
+{
+	const std::uint32_t prefix = static_cast<unsigned char>(str[0]) | static_cast<unsigned char>(str[1]) << 8 | static_cast<std::uint32_t>(static_cast<unsigned char>(str[2])) << 16;
+	return (prefix * 0x9E3779B1u) >> (32 - fsst_hash_bits);
+}
+
+struct fsst_symbol
+{
+	std::uint64_t value = 0;    // The bytes, as loaded by fsst_load()
+	std::uint8_t length = 0;
+
+	const char *data() const noexcept { return reinterpret_cast<const char*>(&value); }
+};
+
+class fsst_table
+{
+public:
+
+	fsst_table() :
+		mShortCodes(65536),
+		mHash(std::size_t(1) << fsst_hash_bits)
+	{
+		build({});
+	}
+
+	// Greedy FSST training: compress the sample with the current table, count how often each symbol and each
+	// pair of neighbouring symbols comes up, and keep the 255 symbols and concatenations that save the most bytes.
+	static fsst_table train(const std::vector<std::string_view> &sample)
+	{
+		fsst_table table;
+
+		// Note: Ids 0 to 254 are codes, 256 + byte is that byte escaped
+		std::vector<std::uint32_t> single(512);
+		std::vector<std::uint32_t> pairs(512 * 512);
+
+		for (std::size_t generation = 0; generation < fsst_generations; ++generation)
+		{
+			std::fill(single.begin(), single.end(), 0);
+			std::fill(pairs.begin(), pairs.end(), 0);
+
+			for (const std::string_view &str : sample)
+			{
+				std::size_t previous = 0;
+				bool first = true;
+
+				for (std::size_t i = 0; i < str.size();)
+				{
+					const std::uint16_t match = table.match(str.data() + i, str.size() - i);
+					const std::size_t code = match & 0xFF;
+					const std::size_t length = match >> 8;
+					const std::size_t id = code == fsst_escape ? 256 + static_cast<unsigned char>(str[i]) : code;
+
+					++single[id];
+
+					// Note: Keeps single bytes in the running even when longer symbols usually cover them
+					if (length > 1)
+						++single[256 + static_cast<unsigned char>(str[i])];
+
+					if (!first)
+						++pairs[previous * 512 + id];
+
+					previous = id;
+					first = false;
+					i += length;
+				}
+			}
+
+			const auto symbol_of = [&table](std::size_t id)
+			{
+				if (id < 256)
+					return table.mSymbols[id];
+
+				fsst_symbol symbol;
+				const char byte = static_cast<char>(id - 256);
+				symbol.value = fsst_load(&byte, 1);
+				symbol.length = 1;
+
+				return symbol;
+			};
+
+			std::map<std::pair<std::uint64_t, std::uint8_t>, std::uint64_t> gains;
+
+			for (std::size_t a = 0; a < 512; ++a)
+			{
+				if (!single[a])
+					continue;
+
+				const fsst_symbol first = symbol_of(a);
+				gains[{ first.value, first.length }] += std::uint64_t(single[a]) * first.length;
+
+				// Note: The last generation only picks from the symbols it has, so the table it ends with is what was counted
+				if (generation + 1 == fsst_generations)
+					continue;
+
+				for (std::size_t b = 0; b < 512; ++b)
+				{
+					const std::uint32_t count = pairs[a * 512 + b];
+
+					if (!count)
+						continue;
+
+					const fsst_symbol second = symbol_of(b);
+
+					if (first.length + second.length > 8)
+						continue;
+
+					char bytes[8] = {};
+					std::memcpy(bytes, first.data(), first.length);
+					std::memcpy(bytes + first.length, second.data(), second.length);
+
+					const std::uint8_t length = static_cast<std::uint8_t>(first.length + second.length);
+					gains[{ fsst_load(bytes, length), length }] += std::uint64_t(count) * length;
+				}
+			}
+
+			std::vector<std::pair<std::uint64_t, fsst_symbol>> candidates;
+			candidates.reserve(gains.size());
+
+			for (const auto &[key, gain] : gains)
+			{
+				fsst_symbol symbol;
+				symbol.value = key.first;
+				symbol.length = key.second;
+				candidates.emplace_back(gain, symbol);
+			}
+
+			// Note: Ties go to the longer symbol, then to the smaller value, so training is deterministic
+			std::sort(candidates.begin(), candidates.end(), [](const auto &lhs, const auto &rhs)
+			{
+				if (lhs.first != rhs.first)
+					return lhs.first > rhs.first;
+
+				if (lhs.second.length != rhs.second.length)
+					return lhs.second.length > rhs.second.length;
+
+				return lhs.second.value < rhs.second.value;
+			});
+
+			std::vector<fsst_symbol> symbols;
+			std::vector<bool> taken(std::size_t(1) << fsst_hash_bits);
+
+			for (const auto &[gain, symbol] : candidates)
+			{
+				if (symbols.size() == fsst_max_symbols)
+					break;
+
+				// Note: Each hash slot holds one long symbol, the rest with the same slot lose out
+				if (symbol.length >= 3)
+				{
+					const std::size_t slot = fsst_hash(symbol.data());
+
+					if (taken[slot])
+						continue;
+
+					taken[slot] = true;
+				}
+
+				symbols.push_back(symbol);
+			}
+
+			table.build(symbols);
+		}
+
+		return table;
+	}
+
+	std::size_t symbol_count() const noexcept { return mCount; }
+
+	// Writes at most 2 * size bytes
+	std::size_t compress(const char *str, std::size_t size, char *out) const noexcept
+	{
+		char *const begin = out;
+
+		for (std::size_t i = 0; i < size;)
+		{
+			const std::uint16_t match = this->match(str + i, size - i);
+			const unsigned code = match & 0xFF;
+
+			*out++ = static_cast<char>(code);
+
+			if (code == fsst_escape)
+				*out++ = str[i];
+
+			i += match >> 8;
+		}
+
+		return static_cast<std::size_t>(out - begin);
+	}
+
+	std::size_t decompressed_size(const char *in, std::size_t size) const noexcept
+	{
+		std::size_t result = 0;
+
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			const unsigned code = static_cast<unsigned char>(in[i]);
+
+			if (code == fsst_escape)
+			{
+				++i;
+				++result;
+			}
+			else
+				result += mSymbols[code].length;
+		}
+
+		return result;
+	}
+
+	// Writes at most capacity bytes, and returns the whole decompressed size even if it's more than that
+	std::size_t decompress(const char *in, std::size_t size, char *out, std::size_t capacity) const noexcept
+	{
+		const unsigned char *code = reinterpret_cast<const unsigned char*>(in);
+		const unsigned char *const end = code + size;
+		std::size_t written = 0;
+
+		// Every symbol goes out as a whole 8-byte store while there's room for it
+		while (code < end && capacity - written >= 8)
+		{
+			if (end - code >= 4 && capacity - written >= 32)
+			{
+				std::uint32_t four;
+				std::memcpy(&four, code, sizeof(four));
+
+				const std::uint32_t inverted = ~four;
+
+				// Note: True when no byte is 0xFF, i.e. there isn't an escape among the four
+				if (!((inverted - 0x01010101u) & ~inverted & 0x80808080u))
+				{
+					for (int i = 0; i < 4; ++i)
+					{
+						const fsst_symbol &symbol = mSymbols[code[i]];
+						std::memcpy(out + written, &symbol.value, 8);
+						written += symbol.length;
+					}
+
+					code += 4;
+					continue;
+				}
+			}
+
+			const unsigned current = *code++;
+
+			if (current != fsst_escape)
+			{
+				const fsst_symbol &symbol = mSymbols[current];
+				std::memcpy(out + written, &symbol.value, 8);
+				written += symbol.length;
+			}
+			else if (code < end)
+				out[written++] = static_cast<char>(*code++);
+		}
+
+		// Close to the end of the buffer, byte by byte
+		while (code < end)
+		{
+			const unsigned current = *code++;
+
+			if (current != fsst_escape)
+			{
+				const fsst_symbol &symbol = mSymbols[current];
+
+				if (written < capacity)
+					std::memcpy(out + written, &symbol.value, std::min<std::size_t>(symbol.length, capacity - written));
+
+				written += symbol.length;
+			}
+			else if (code < end)
+			{
+				if (written < capacity)
+					out[written] = static_cast<char>(*code);
+
+				++written;
+				++code;
+			}
+		}
+
+		return written;
+	}
+
+	std::size_t memory_usage() const noexcept
+	{
+		return sizeof(*this) + mShortCodes.capacity() * sizeof(std::uint16_t) + mHash.capacity() * sizeof(hash_entry);
+	}
+
+private:
+
+	struct hash_entry
+	{
+		std::uint64_t value;
+		std::uint8_t length;    // 0 for an empty slot
+		std::uint8_t code;
+	};
+
+	void build(const std::vector<fsst_symbol> &symbols)
+	{
+		mCount = symbols.size();
+
+		for (std::size_t i = 0; i < 256; ++i)
+			mSymbols[i] = i < symbols.size() ? symbols[i] : fsst_symbol();
+
+		for (std::size_t byte = 0; byte < 256; ++byte)
+			mByteCodes[byte] = static_cast<std::uint16_t>(1 << 8 | fsst_escape);
+
+		std::fill(mHash.begin(), mHash.end(), hash_entry());
+
+		for (std::size_t code = 0; code < symbols.size(); ++code)
+		{
+			if (symbols[code].length == 1)
+				mByteCodes[static_cast<unsigned char>(symbols[code].data()[0])] = static_cast<std::uint16_t>(1 << 8 | code);
+		}
+
+		for (std::size_t prefix = 0; prefix < 65536; ++prefix)
+			mShortCodes[prefix] = mByteCodes[prefix & 0xFF];
+
+		for (std::size_t code = 0; code < symbols.size(); ++code)
+		{
+			const fsst_symbol &symbol = symbols[code];
+			const unsigned char *bytes = reinterpret_cast<const unsigned char*>(symbol.data());
+
+			if (symbol.length == 2)
+				mShortCodes[bytes[0] | bytes[1] << 8] = static_cast<std::uint16_t>(2 << 8 | code);
+			else if (symbol.length >= 3)
+			{
+				hash_entry &entry = mHash[fsst_hash(symbol.data())];
+
+				if (!entry.length)
+					entry = { symbol.value, symbol.length, static_cast<std::uint8_t>(code) };
+			}
+		}
+	}
+
+	// The longest symbol at the start of str, as length << 8 | code
+	std::uint16_t match(const char *str, std::size_t size) const noexcept
+	{
+		if (size >= 3)
+		{
+			const hash_entry &entry = mHash[fsst_hash(str)];
+
+			if (entry.length && entry.length <= size && (fsst_load(str, size) & fsst_mask(entry.length)) == entry.value)
+				return static_cast<std::uint16_t>(entry.length << 8 | entry.code);
+		}
+
+		if (size >= 2)
+			return mShortCodes[static_cast<unsigned char>(str[0]) | static_cast<unsigned char>(str[1]) << 8];
+
+		return mByteCodes[static_cast<unsigned char>(str[0])];
+	}
+
+	fsst_symbol mSymbols[256];
+	std::size_t mCount = 0;
+
+	// Codes for matching, each length << 8 | code
+	std::uint16_t mByteCodes[256];
+	std::vector<std::uint16_t> mShortCodes;    // By the first two bytes, for symbols of 1 or 2 bytes
+	std::vector<hash_entry> mHash;             // By fsst_hash(), for symbols of 3 bytes or more
+};
+
+}
+
+class compressed_strings
+{
+public:
+
+	using size_type = std::size_t;
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+	// Note: Without a trained table every byte is stored escaped, which takes twice the space
+	compressed_strings() = default;
+
+	// Trains the symbol table on (a sample of) strings, any range of things that convert to std::string_view.
+	// The strings themselves aren't added.
+	template <typename Range>
+	explicit compressed_strings(const Range &strings) :
+		mTable(detail::fsst_table::train(sample_of(strings)))
+	{
+	}
+
+	// Trains on strings and adds all of them, without leaving spare capacity behind
+	template <typename Range>
+	static compressed_strings from(const Range &strings)
+	{
+		compressed_strings result(strings);
+
+		for (const auto &str : strings)
+			result.push_back(std::string_view(str));
+
+		result.shrink_to_fit();
+
+		return result;
+	}
+
+	void push_back(std::string_view str)
+	{
+		if (mEnds.size() % block_size == 0)
+			mBases.push_back(mBytes.size());
+
+		const size_type start = mBytes.size();
+		mBytes.resize(start + str.size() * 2);
+		mBytes.resize(start + mTable.compress(str.data(), str.size(), mBytes.data() + start));
+
+		const size_type end = mBytes.size() - mBases.back();
+
+		if (end > std::numeric_limits<std::uint32_t>::max())
+		{
+			mBytes.resize(start);
+
+			if (mEnds.size() % block_size == 0)
+				mBases.pop_back();
+
+			throw std::length_error("compressed_strings block too large");
+		}
+
+		mEnds.push_back(static_cast<std::uint32_t>(end));
+		mRawBytes += str.size();
+	}
+
+	size_type size() const noexcept { return mEnds.size(); }
+	bool empty() const noexcept { return mEnds.empty(); }
+
+	string operator[](size_type index) const
+	{
+		const std::string_view codes = compressed(index);
+		const size_type length = mTable.decompressed_size(codes.data(), codes.size());
+
+		string result;
+		result.resize_and_overwrite(length, [this, codes](char *out, size_type count)
+		{
+			return mTable.decompress(codes.data(), codes.size(), out, count);
+		});
+
+		return result;
+	}
+
+	string at(size_type index) const
+	{
+		if (index >= size())
+			throw std::out_of_range("invalid compressed_strings index");
+
+		return (*this)[index];
+	}
+
+	// Decompresses string index into out, writing at most capacity bytes. Returns the string's full size,
+	// so a return value bigger than capacity means it didn't fit.
+	size_type decompress(size_type index, char *out, size_type capacity) const noexcept
+	{
+		const std::string_view codes = compressed(index);
+		return mTable.decompress(codes.data(), codes.size(), out, capacity);
+	}
+
+	size_type size_of(size_type index) const noexcept
+	{
+		const std::string_view codes = compressed(index);
+		return mTable.decompressed_size(codes.data(), codes.size());
+	}
+
+	// The compressed bytes of string index
+	std::string_view compressed(size_type index) const noexcept
+	{
+		const size_type base = mBases[index / block_size];
+		const size_type begin = base + (index % block_size ? mEnds[index - 1] : 0);
+
+		return std::string_view(mBytes.data() + begin, base + mEnds[index] - begin);
+	}
+
+	// Index of the first string equal to str at or after from, or npos. Compares compressed bytes.
+	size_type find(std::string_view str, size_type from = 0) const
+	{
+		std::vector<char> codes(str.size() * 2);
+		codes.resize(mTable.compress(str.data(), str.size(), codes.data()));
+
+		const std::string_view needle(codes.data(), codes.size());
+
+		for (size_type i = from; i < size(); ++i)
+		{
+			if (compressed(i) == needle)
+				return i;
+		}
+
+		return npos;
+	}
+
+	bool contains(std::string_view str) const { return find(str) != npos; }
+
+	// Total size of the strings as they were added
+	size_type bytes() const noexcept { return mRawBytes; }
+
+	size_type compressed_bytes() const noexcept { return mBytes.size(); }
+
+	size_type symbol_count() const noexcept { return mTable.symbol_count(); }
+
+	// Everything allocated, including the symbol table and unused capacity
+	size_type memory_usage() const noexcept
+	{
+		return mBytes.capacity() + mEnds.capacity() * sizeof(std::uint32_t) + mBases.capacity() * sizeof(std::uint64_t) + mTable.memory_usage();
+	}
+
+	void reserve(size_type count, size_type compressed_bytes)
+	{
+		mEnds.reserve(count);
+		mBases.reserve(count / block_size + 1);
+		mBytes.reserve(compressed_bytes);
+	}
+
+	void shrink_to_fit()
+	{
+		mBytes.shrink_to_fit();
+		mEnds.shrink_to_fit();
+		mBases.shrink_to_fit();
+	}
+
+	// Removes the strings but keeps the symbol table
+	void clear() noexcept
+	{
+		mBytes.clear();
+		mEnds.clear();
+		mBases.clear();
+		mRawBytes = 0;
+	}
+
+private:
+
+	constexpr static size_type block_size = 128;
+
+	// Every so many strings, to keep training to a few milliseconds however many there are
+	template <typename Range>
+	static std::vector<std::string_view> sample_of(const Range &strings)
+	{
+		const size_type count = static_cast<size_type>(std::distance(std::begin(strings), std::end(strings)));
+		const size_type step = std::max<size_type>(1, count / 4096);
+
+		std::vector<std::string_view> sample;
+		size_type bytes = 0;
+		size_type i = 0;
+
+		for (const auto &str : strings)
+		{
+			if (i++ % step)
+				continue;
+
+			const std::string_view view(str);
+			sample.push_back(view);
+			bytes += view.size();
+
+			if (bytes >= detail::fsst_sample_bytes)
+				break;
+		}
+
+		return sample;
+	}
+
+	detail::fsst_table mTable;
+	std::vector<char> mBytes;
+	std::vector<std::uint32_t> mEnds;     // End of each string, from its block's base
+	std::vector<std::uint64_t> mBases;    // Start of every block_size strings
+	size_type mRawBytes = 0;
+};
+
+}
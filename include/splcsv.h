@@ -0,0 +1,516 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+#include <functional>
+#include <istream>
+
+// An RFC 4180 CSV reader.
+//
+// Input is classified 64 bytes at a time into bitmasks of quotes, delimiters and newlines. A prefix XOR of the
+// quote mask gives every byte that sits between quotes, so separators inside quoted fields drop out with one AND
+// and the remaining bits are the field boundaries. Fields are handed out as views into the input; only quoted
+// fields containing "" escapes are copied, into a scratch buffer the reader reuses from row to row.
+//
+// Note: Like any bitmask approach this trusts the input to be well formed. A quote in the middle of an unquoted
+// field still toggles the quoted state, and fields that don't both start and end with a quote are returned as is.
+
+namespace spl
+{
+
+struct csv_options
+{
+	char delimiter = ',';
+	char quote = '"';
+};
+
+class csv_row
+{
+public:
+
+	using size_type = std::size_t;
+	using const_iterator = std::vector<std::string_view>::const_iterator;
+
+	size_type size() const noexcept { return mFields.size(); }
+	bool empty() const noexcept { return mFields.empty(); }
+
+	const std::string_view &operator[](size_type index) const noexcept { return mFields[index]; }
+
+	const std::string_view &at(size_type index) const
+	{
+		if (index >= mFields.size())
+			throw std::out_of_range("invalid field index");
+
+		return mFields[index];
+	}
+
+	const_iterator begin() const noexcept { return mFields.begin(); }
+	const_iterator end() const noexcept { return mFields.end(); }
+
+	const std::vector<std::string_view> &fields() const noexcept { return mFields; }
+
+private:
+
+	friend class csv_reader;
+
+	std::vector<std::string_view> mFields;
+};
+
+// Fills buffer with up to size bytes and returns how many it wrote, 0 meaning the end of the input
+using csv_source = std::function<std::size_t(char *buffer, std::size_t size)>;
+
+namespace detail
+{
+
+constexpr std::size_t csv_block_size = 64;
+constexpr std::size_t csv_chunk_blocks = 256;    // 16 KiB classified per pass, so the masks stay in L1
+
+inline std::uint64_t csv_scalar_mask(const char *block, char ch)
+{
+	std::uint64_t mask = 0;
+
+	for (std::size_t i = 0; i < csv_block_size; ++i)
+		mask |= std::uint64_t(block[i] == ch) << i;
+
+	return mask;
+}
+
+inline void csv_classify_scalar(const char *data, std::size_t blocks, const csv_options &options, std::uint64_t *quotes, std::uint64_t *separators)
+{
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		const char *block = data + b * csv_block_size;
+
+		quotes[b] = csv_scalar_mask(block, options.quote);
+		separators[b] = csv_scalar_mask(block, options.delimiter) | csv_scalar_mask(block, '\n');
+	}
+}
+
+#if defined(SPL_STRING_SSE2)
+inline void csv_classify_sse2(const char *data, std::size_t blocks, const csv_options &options, std::uint64_t *quotes, std::uint64_t *separators)
+{
+	const __m128i quote = _mm_set1_epi8(options.quote);
+	const __m128i delimiter = _mm_set1_epi8(options.delimiter);
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		const char *block = data + b * csv_block_size;
+		std::uint64_t quote_mask = 0;
+		std::uint64_t separator_mask = 0;
+
+		for (std::size_t i = 0; i < csv_block_size; i += 16)
+		{
+			const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+			const __m128i separator = _mm_or_si128(_mm_cmpeq_epi8(input, delimiter), _mm_cmpeq_epi8(input, newline));
+
+			quote_mask |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(input, quote)))) << i;
+			separator_mask |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(separator))) << i;
+		}
+
+		quotes[b] = quote_mask;
+		separators[b] = separator_mask;
+	}
+}
+
+SPL_STRING_TARGET("avx2")
+inline std::uint64_t csv_mask_avx2(__m256i low, __m256i high)
+{
+	return std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(low))) |
+		std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(high))) << 32;
+}
+
+SPL_STRING_TARGET("avx2")
+inline void csv_classify_avx2(const char *data, std::size_t blocks, const csv_options &options, std::uint64_t *quotes, std::uint64_t *separators)
+{
+	const __m256i quote = _mm256_set1_epi8(options.quote);
+	const __m256i delimiter = _mm256_set1_epi8(options.delimiter);
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		const char *block = data + b * csv_block_size;
+		const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+		const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+		quotes[b] = csv_mask_avx2(_mm256_cmpeq_epi8(low, quote), _mm256_cmpeq_epi8(high, quote));
+		separators[b] = csv_mask_avx2(_mm256_or_si256(_mm256_cmpeq_epi8(low, delimiter), _mm256_cmpeq_epi8(low, newline)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(high, delimiter), _mm256_cmpeq_epi8(high, newline)));
+	}
+}
+#endif
+
+inline void csv_classify(const char *data, std::size_t blocks, const csv_options &options, std::uint64_t *quotes, std::uint64_t *separators)
+{
+#if defined(SPL_STRING_SSE2)
+	if (cpu().avx2)
+		return csv_classify_avx2(data, blocks, options, quotes, separators);
+
+	return csv_classify_sse2(data, blocks, options, quotes, separators);
+#else
+	return csv_classify_scalar(data, blocks, options, quotes, separators);
+#endif
+}
+
+// Bit i of the result is the XOR of bits 0 to i, i.e. set for every byte after an odd number of quotes
+inline std::uint64_t csv_prefix_xor(std::uint64_t mask)
+{
+	mask ^= mask << 1;
+	mask ^= mask << 2;
+	mask ^= mask << 4;
+	mask ^= mask << 8;
+	mask ^= mask << 16;
+	mask ^= mask << 32;
+	return mask;
+}
+
+// Writes the offsets of separators outside quotes and returns how many there were.
+// inside carries the quoted state from one block to the next, all ones while inside quotes.
+inline std::size_t csv_structurals(const std::uint64_t *quotes, const std::uint64_t *separators, std::size_t blocks, std::uint64_t &inside, std::uint32_t *out)
+{
+	std::size_t count = 0;
+
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		const std::uint64_t quoted = csv_prefix_xor(quotes[b]) ^ inside;
+		inside = static_cast<std::uint64_t>(static_cast<std::int64_t>(quoted) >> 63);
+
+		std::uint64_t bits = separators[b] & ~quoted;
+		const std::uint32_t base = static_cast<std::uint32_t>(b * csv_block_size);
+
+		while (bits)
+		{
+			out[count++] = base + count_trailing_zeros64(bits);
+			bits &= bits - 1;
+		}
+	}
+
+	return count;
+}
+
+}
+
+class csv_reader
+{
+public:
+
+	using size_type = std::size_t;
+
+	// Note: The data has to outlive the reader, and fields point into it
+	explicit csv_reader(const std::string_view &data, const csv_options &options = {}) :
+		mData(data),
+		mOptions(options)
+	{
+		init();
+	}
+
+	explicit csv_reader(const char *data, const csv_options &options = {}) : csv_reader(std::string_view(data), options) {}
+
+	explicit csv_reader(const string &data, const csv_options &options = {}) : csv_reader(data.view(), options) {}
+	explicit csv_reader(const std::string &data, const csv_options &options = {}) : csv_reader(std::string_view(data), options) {}
+
+	csv_reader(const string &&data, const csv_options &options = {}) = delete;
+	csv_reader(const std::string &&data, const csv_options &options = {}) = delete;
+
+	// Reads through a buffer of buffer_size bytes, which grows if a single row doesn't fit
+	explicit csv_reader(csv_source source, const csv_options &options = {}, size_type buffer_size = 1 << 20) :
+		mOptions(options),
+		mSource(std::move(source)),
+		mBuffer(std::max<size_type>(buffer_size, detail::csv_block_size))
+	{
+		init();
+	}
+
+	explicit csv_reader(std::istream &stream, const csv_options &options = {}, size_type buffer_size = 1 << 20) :
+		csv_reader([&stream](char *buffer, std::size_t size) -> std::size_t
+		{
+			stream.read(buffer, static_cast<std::streamsize>(size));
+			return static_cast<std::size_t>(stream.gcount());
+		}, options, buffer_size)
+	{
+	}
+
+	csv_reader(const csv_reader &) = delete;
+	csv_reader &operator=(const csv_reader &) = delete;
+
+	csv_reader(csv_reader &&) = default;
+	csv_reader &operator=(csv_reader &&) = default;
+
+	// Returns false once the input is exhausted. The row's fields stay valid until the next call.
+	// Blank lines come back as rows with no fields.
+	bool read_row(csv_row &row)
+	{
+		std::vector<std::string_view> &fields = row.mFields;
+
+		fields.clear();
+		mScratch.clear();
+		mEscaped.clear();
+
+		while (mPos >= mData.size())
+		{
+			if (!refill())
+				return false;
+		}
+
+		size_type field_start = mPos;
+
+		for (;;)
+		{
+			// Note: Kept in locals, since every field stored could otherwise alias the members
+			const char *data = mData.data();
+			const std::uint32_t *index = mIndex.data();
+			const size_type base = mIndexBase;
+			const size_type count = mIndexCount;
+			size_type pos = mIndexPos;
+
+			while (pos < count)
+			{
+				const size_type separator = base + index[pos++];
+
+				if (data[separator] != '\n')
+				{
+					add_field(fields, data + field_start, separator - field_start);
+					field_start = separator + 1;
+					continue;
+				}
+
+				mIndexPos = pos;
+				mPos = separator + 1;
+				add_last_field(fields, data + field_start, separator - field_start);
+
+				return finish_row(fields);
+			}
+
+			mIndexPos = pos;
+
+			if (mScanned < mData.size())
+			{
+				scan();
+				continue;
+			}
+
+			if (refill())
+			{
+				// The partial row was moved to the front of the buffer, start it over
+				field_start = mPos;
+				fields.clear();
+				mScratch.clear();
+				mEscaped.clear();
+				continue;
+			}
+
+			mPos = mData.size();
+			add_last_field(fields, data + field_start, mData.size() - field_start);
+
+			return finish_row(fields);
+		}
+	}
+
+	// Rows returned so far
+	size_type rows() const noexcept { return mRows; }
+
+	// Offset of the next row from the start of the input
+	size_type offset() const noexcept { return mConsumed + mPos; }
+
+	const csv_options &options() const noexcept { return mOptions; }
+
+private:
+
+	struct escaped_field
+	{
+		size_type index;
+		size_type offset;
+	};
+
+	void init()
+	{
+		mQuotes.resize(detail::csv_chunk_blocks);
+		mSeparators.resize(detail::csv_chunk_blocks);
+		mIndex.resize(detail::csv_chunk_blocks * detail::csv_block_size);
+	}
+
+	// Classifies the next chunk of input and replaces the index with its separators
+	void scan()
+	{
+		const size_type remaining = mData.size() - mScanned;
+		const size_type blocks = std::min(remaining / detail::csv_block_size, detail::csv_chunk_blocks);
+
+		mIndexBase = mScanned;
+		mIndexPos = 0;
+
+		if (blocks)
+		{
+			detail::csv_classify(mData.data() + mScanned, blocks, mOptions, mQuotes.data(), mSeparators.data());
+			mIndexCount = detail::csv_structurals(mQuotes.data(), mSeparators.data(), blocks, mInside, mIndex.data());
+			mScanned += blocks * detail::csv_block_size;
+			return;
+		}
+
+		char tail[detail::csv_block_size] = {};
+		std::memcpy(tail, mData.data() + mScanned, remaining);
+
+		detail::csv_classify(tail, 1, mOptions, mQuotes.data(), mSeparators.data());
+
+		const std::uint64_t valid = (std::uint64_t(1) << remaining) - 1;
+		mQuotes[0] &= valid;
+		mSeparators[0] &= valid;
+
+		mIndexCount = detail::csv_structurals(mQuotes.data(), mSeparators.data(), 1, mInside, mIndex.data());
+		mScanned += remaining;
+	}
+
+	// Moves the unread part of the buffer to the front and reads more after it, which invalidates every offset
+	// into the buffer. Returns false without touching anything for string_view input or once the source has run dry.
+	bool refill()
+	{
+		if (!mSource || mEnded)
+			return false;
+
+		const size_type kept = mData.size() - mPos;
+
+		if (kept && mPos)
+			std::memmove(mBuffer.data(), mBuffer.data() + mPos, kept);
+
+		// Note: A row that fills the whole buffer needs a bigger one
+		if (kept == mBuffer.size())
+			mBuffer.resize(mBuffer.size() * 2);
+
+		mConsumed += mPos;
+
+		size_type size = kept;
+
+		while (size < mBuffer.size())
+		{
+			const size_type read = mSource(mBuffer.data() + size, mBuffer.size() - size);
+
+			if (read == 0)
+			{
+				mEnded = true;
+				break;
+			}
+
+			size += read;
+		}
+
+		mData = std::string_view(mBuffer.data(), size);
+		mPos = 0;
+		mScanned = 0;
+		mInside = 0;
+		mIndexBase = 0;
+		mIndexPos = 0;
+		mIndexCount = 0;
+
+		return true;
+	}
+
+	void add_field(std::vector<std::string_view> &fields, const char *field, size_type size)
+	{
+		const char quote = mOptions.quote;
+
+		if (size < 2 || field[0] != quote || field[size - 1] != quote)
+			fields.emplace_back(field, size);
+		else
+			add_quoted_field(fields, field, size);
+	}
+
+	// Drops the \r of a \r\n line ending, and the only field of a blank line
+	void add_last_field(std::vector<std::string_view> &fields, const char *field, size_type size)
+	{
+		if (size && field[size - 1] == '\r')
+			--size;
+
+		if (size || !fields.empty())
+			add_field(fields, field, size);
+	}
+
+	void add_quoted_field(std::vector<std::string_view> &fields, const char *field, size_type size)
+	{
+		const char quote = mOptions.quote;
+		const char *first = field + 1;
+		const char *last = field + size - 1;
+		const char *escape = static_cast<const char*>(std::memchr(first, quote, last - first));
+
+		if (!escape)
+		{
+			fields.emplace_back(first, size - 2);
+			return;
+		}
+
+		// "" stands for a single quote, copy the content over with those collapsed
+		const size_type offset = mScratch.size();
+
+		while (escape)
+		{
+			mScratch.append(first, escape + 1);
+			first = escape + 1;
+
+			if (first < last && *first == quote)
+				++first;
+
+			escape = static_cast<const char*>(std::memchr(first, quote, last - first));
+		}
+
+		mScratch.append(first, last);
+		mEscaped.push_back({ fields.size(), offset });
+		fields.emplace_back(nullptr, mScratch.size() - offset);
+	}
+
+	bool finish_row(std::vector<std::string_view> &fields)
+	{
+		// Note: The scratch buffer may have moved while the row was read, so escaped fields are pointed at it last
+		for (const escaped_field &escaped : mEscaped)
+			fields[escaped.index] = std::string_view(mScratch.data() + escaped.offset, fields[escaped.index].size());
+
+		++mRows;
+		return true;
+	}
+
+	std::string_view mData;
+	csv_options mOptions;
+
+	csv_source mSource;
+	std::vector<char> mBuffer;
+	bool mEnded = false;
+	size_type mConsumed = 0;
+
+	size_type mPos = 0;
+	size_type mScanned = 0;
+	std::uint64_t mInside = 0;
+
+	std::vector<std::uint64_t> mQuotes;
+	std::vector<std::uint64_t> mSeparators;
+	std::vector<std::uint32_t> mIndex;
+	size_type mIndexBase = 0;
+	size_type mIndexPos = 0;
+	size_type mIndexCount = 0;
+
+	std::string mScratch;
+	std::vector<escaped_field> mEscaped;
+	size_type mRows = 0;
+};
+
+}
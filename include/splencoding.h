@@ -0,0 +1,1171 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+// Base64 (RFC 4648, standard and URL-safe alphabets) and hex encoding, plus JSON string and URL escaping.
+//
+// Base64 and hex each come in three shapes: writing to a caller's buffer (the *_to functions, sized with the *_size ones),
+// returning a new spl::string, and appending to an existing one. With SSSE3 or AVX2 available at runtime, whole
+// blocks are converted with byte shuffles and multiplies; what's left over goes through lookup tables.
+//
+// Decoding is strict. Anything outside the alphabet, misplaced or missing padding, and leftover bits that aren't
+// zero are all errors, and the error says where in the input it was found.
+//
+// The escapers find the bytes that need escaping with SIMD compares and copy the runs in between with memcpy(),
+// after a counting pass that sizes the output exactly.
+
+namespace spl
+{
+
+enum struct base64_alphabet
+{
+	standard,    // A-Z a-z 0-9 + /, always padded with =
+	url          // A-Z a-z 0-9 - _, padding optional
+};
+
+// Thrown by decoders. position() is the first byte of the input that couldn't be decoded, or the size of the input
+// if it ended too early.
+class decode_error : public std::invalid_argument
+{
+public:
+
+	decode_error(const char *what, std::size_t position) :
+		std::invalid_argument(what),
+		mPosition(position)
+	{
+	}
+
+	std::size_t position() const noexcept { return mPosition; }
+
+private:
+
+	std::size_t mPosition;
+};
+
+struct decode_result
+{
+	constexpr static std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+	std::size_t size = 0;               // Bytes written
+	std::size_t error_position = npos;  // Same meaning as decode_error::position()
+
+	explicit operator bool() const noexcept { return error_position == npos; }
+};
+
+namespace detail
+{
+
+inline const char *base64_chars(base64_alphabet alphabet) noexcept
+{
+	return alphabet == base64_alphabet::url ?
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_" :
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+}
+
+// Value of each byte in an alphabet, or -1
+struct decode_table
+{
+	std::int8_t values[256] = {};
+
+	constexpr explicit decode_table(const char *chars)
+	{
+		for (std::int8_t &value : values)
+			value = -1;
+
+		for (std::int8_t i = 0; chars[i]; ++i)
+			values[static_cast<unsigned char>(chars[i])] = i;
+	}
+};
+
+inline const decode_table &base64_table(base64_alphabet alphabet) noexcept
+{
+	static constexpr decode_table standard("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+	static constexpr decode_table url("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_");
+
+	return alphabet == base64_alphabet::url ? url : standard;
+}
+
+inline const decode_table &hex_table() noexcept
+{
+	static constexpr decode_table table = []
+	{
+		decode_table result("0123456789abcdef");
+
+		for (std::int8_t i = 0; i < 6; ++i)
+			result.values['A' + i] = static_cast<std::int8_t>(10 + i);
+
+		return result;
+	}();
+
+	return table;
+}
+
+#if defined(SPL_STRING_SSE2)
+
+// Base64 kernels after Wojciech Muła and Daniel Lemire. Encoding spreads each 3 bytes over 4 and isolates the
+// 6 bit fields with multiplies, then offsets every field into its range of the alphabet with a shuffle lookup.
+// Decoding range checks every byte, subtracts the offset back out and packs the fields together with multiply-adds.
+
+inline __m128i in_range_sse2(__m128i input, char first, char count)
+{
+	const __m128i offset = _mm_sub_epi8(input, _mm_set1_epi8(first));
+	return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(count - 1))), offset);
+}
+
+// Converts base64 characters to their 6 bit values and sets valid to a movemask of the ones that were in the alphabet
+inline __m128i base64_values_sse2(__m128i input, char char_62, char char_63, std::uint32_t &valid)
+{
+	const __m128i upper = in_range_sse2(input, 'A', 26);
+	const __m128i lower = in_range_sse2(input, 'a', 26);
+	const __m128i digit = in_range_sse2(input, '0', 10);
+	const __m128i is_62 = _mm_cmpeq_epi8(input, _mm_set1_epi8(char_62));
+	const __m128i is_63 = _mm_cmpeq_epi8(input, _mm_set1_epi8(char_63));
+
+	valid = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(is_62, is_63)))));
+
+	__m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+	shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+	shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+	shift = _mm_or_si128(shift, _mm_and_si128(is_62, _mm_set1_epi8(static_cast<char>(62 - char_62))));
+	shift = _mm_or_si128(shift, _mm_and_si128(is_63, _mm_set1_epi8(static_cast<char>(63 - char_63))));
+
+	return _mm_add_epi8(input, shift);
+}
+
+SPL_STRING_TARGET("ssse3")
+inline __m128i base64_encode_block_ssse3(__m128i input, __m128i shift_lut)
+{
+	input = _mm_shuffle_epi8(input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+	const __m128i high = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+	const __m128i low = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+	const __m128i indices = _mm_or_si128(high, low);
+
+	// 0-25 to 13, 26-51 to 0, 52-61 to 1-10, 62 to 11 and 63 to 12, then look up how far each is from its character
+	__m128i lut_index = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+	lut_index = _mm_or_si128(lut_index, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+
+	return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, lut_index), indices);
+}
+
+inline __m128i base64_shift_lut(base64_alphabet alphabet)
+{
+	const char *chars = base64_chars(alphabet);
+
+	return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		static_cast<char>(chars[62] - 62), static_cast<char>(chars[63] - 63), 'A', 0, 0);
+}
+
+// Each of these handles whole blocks while it's safe to load and store full registers, returning how much input it used.
+// Decoders also stop at a block with an invalid character, leaving it for the scalar code to pin down.
+
+SPL_STRING_TARGET("ssse3")
+inline std::size_t base64_encode_ssse3(const char *in, std::size_t size, char *out, base64_alphabet alphabet)
+{
+	const __m128i shift_lut = base64_shift_lut(alphabet);
+	std::size_t i = 0;
+
+	for (; i + 16 <= size; i += 12, out += 16)
+	{
+		const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), base64_encode_block_ssse3(input, shift_lut));
+	}
+
+	return i;
+}
+
+SPL_STRING_TARGET("ssse3")
+inline std::size_t base64_decode_ssse3(const char *in, std::size_t size, char *out, base64_alphabet alphabet)
+{
+	const char *chars = base64_chars(alphabet);
+	std::size_t i = 0;
+
+	// Note: Stores are 16 bytes for 12 decoded, so there has to be another block after this one
+	for (; i + 32 <= size; i += 16, out += 12)
+	{
+		std::uint32_t valid;
+		const __m128i values = base64_values_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), chars[62], chars[63], valid);
+
+		if (valid != 0xFFFF)
+			break;
+
+		const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+		const __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+		const __m128i packed = _mm_shuffle_epi8(words, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+	}
+
+	return i;
+}
+
+SPL_STRING_TARGET("ssse3")
+inline std::size_t hex_encode_ssse3(const char *in, std::size_t size, char *out, bool uppercase)
+{
+	const __m128i digits = uppercase ?
+		_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F') :
+		_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+	const __m128i low_nibble = _mm_set1_epi8(0x0F);
+	std::size_t i = 0;
+
+	for (; i + 16 <= size; i += 16, out += 32)
+	{
+		const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+		const __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(input, low_nibble));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(high, low));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi8(high, low));
+	}
+
+	return i;
+}
+
+// Converts hex digits to nibbles and sets valid to a movemask of the ones that were digits
+inline __m128i hex_values_sse2(__m128i input, std::uint32_t &valid)
+{
+	const __m128i digit_offset = _mm_sub_epi8(input, _mm_set1_epi8('0'));
+	const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit_offset, _mm_set1_epi8(9)), digit_offset);
+
+	// Note: Setting 0x20 lowercases A-F and can't turn anything else into a-f
+	const __m128i letter_offset = _mm_sub_epi8(_mm_or_si128(input, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter_offset, _mm_set1_epi8(5)), letter_offset);
+
+	valid = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)));
+
+	return _mm_or_si128(_mm_and_si128(is_digit, digit_offset), _mm_and_si128(is_letter, _mm_add_epi8(letter_offset, _mm_set1_epi8(10))));
+}
+
+SPL_STRING_TARGET("ssse3")
+inline std::size_t hex_decode_ssse3(const char *in, std::size_t size, char *out)
+{
+	std::size_t i = 0;
+
+	for (; i + 16 <= size; i += 16, out += 8)
+	{
+		std::uint32_t valid;
+		const __m128i nibbles = hex_values_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), valid);
+
+		if (valid != 0xFFFF)
+			break;
+
+		const __m128i bytes = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(bytes, bytes));
+	}
+
+	return i;
+}
+
+SPL_STRING_TARGET("avx2")
+inline __m256i in_range_avx2(__m256i input, char first, char count)
+{
+	const __m256i offset = _mm256_sub_epi8(input, _mm256_set1_epi8(first));
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(static_cast<char>(count - 1))), offset);
+}
+
+SPL_STRING_TARGET("avx2")
+inline __m256i base64_values_avx2(__m256i input, char char_62, char char_63, std::uint32_t &valid)
+{
+	const __m256i upper = in_range_avx2(input, 'A', 26);
+	const __m256i lower = in_range_avx2(input, 'a', 26);
+	const __m256i digit = in_range_avx2(input, '0', 10);
+	const __m256i is_62 = _mm256_cmpeq_epi8(input, _mm256_set1_epi8(char_62));
+	const __m256i is_63 = _mm256_cmpeq_epi8(input, _mm256_set1_epi8(char_63));
+
+	valid = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, _mm256_or_si256(is_62, is_63)))));
+
+	__m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+	shift = _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+	shift = _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+	shift = _mm256_or_si256(shift, _mm256_and_si256(is_62, _mm256_set1_epi8(static_cast<char>(62 - char_62))));
+	shift = _mm256_or_si256(shift, _mm256_and_si256(is_63, _mm256_set1_epi8(static_cast<char>(63 - char_63))));
+
+	return _mm256_add_epi8(input, shift);
+}
+
+SPL_STRING_TARGET("avx2")
+inline std::size_t base64_encode_avx2(const char *in, std::size_t size, char *out, base64_alphabet alphabet)
+{
+	const __m256i shift_lut = _mm256_broadcastsi128_si256(base64_shift_lut(alphabet));
+	const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	std::size_t i = 0;
+
+	// Note: Each lane takes 12 bytes from its own 16 byte load
+	for (; i + 28 <= size; i += 24, out += 32)
+	{
+		const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+		const __m256i input = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1), spread);
+
+		const __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(input, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+		const __m256i low = _mm256_mullo_epi16(_mm256_and_si256(input, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+		const __m256i indices = _mm256_or_si256(high, low);
+
+		__m256i lut_index = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+		lut_index = _mm256_or_si256(lut_index, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, lut_index), indices));
+	}
+
+	return i;
+}
+
+SPL_STRING_TARGET("avx2")
+inline std::size_t base64_decode_avx2(const char *in, std::size_t size, char *out, base64_alphabet alphabet)
+{
+	const char *chars = base64_chars(alphabet);
+	const __m256i gather = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	std::size_t i = 0;
+
+	// Note: Stores are 32 bytes for 24 decoded, so there has to be at least half a block after this one
+	for (; i + 48 <= size; i += 32, out += 24)
+	{
+		std::uint32_t valid;
+		const __m256i values = base64_values_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), chars[62], chars[63], valid);
+
+		if (valid != 0xFFFFFFFFu)
+			break;
+
+		const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+		const __m256i words = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+		const __m256i packed = _mm256_shuffle_epi8(words, gather);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7)));
+	}
+
+	return i;
+}
+
+SPL_STRING_TARGET("avx2")
+inline std::size_t hex_encode_avx2(const char *in, std::size_t size, char *out, bool uppercase)
+{
+	const __m256i digits = _mm256_broadcastsi128_si256(uppercase ?
+		_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F') :
+		_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'));
+	const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+	std::size_t i = 0;
+
+	for (; i + 32 <= size; i += 32, out += 64)
+	{
+		const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		const __m256i high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+		const __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(input, low_nibble));
+
+		// Note: Unpacking works within lanes, so the halves have to be put back in order
+		const __m256i first = _mm256_unpacklo_epi8(high, low);
+		const __m256i second = _mm256_unpackhi_epi8(high, low);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), _mm256_permute2x128_si256(first, second, 0x31));
+	}
+
+	return i;
+}
+
+SPL_STRING_TARGET("avx2")
+inline std::size_t hex_decode_avx2(const char *in, std::size_t size, char *out)
+{
+	std::size_t i = 0;
+
+	for (; i + 32 <= size; i += 32, out += 16)
+	{
+		const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+
+		const __m256i digit_offset = _mm256_sub_epi8(input, _mm256_set1_epi8('0'));
+		const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit_offset, _mm256_set1_epi8(9)), digit_offset);
+		const __m256i letter_offset = _mm256_sub_epi8(_mm256_or_si256(input, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+		const __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter_offset, _mm256_set1_epi8(5)), letter_offset);
+
+		if (static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter))) != 0xFFFFFFFFu)
+			break;
+
+		const __m256i nibbles = _mm256_or_si256(_mm256_and_si256(is_digit, digit_offset),
+			_mm256_and_si256(is_letter, _mm256_add_epi8(letter_offset, _mm256_set1_epi8(10))));
+		const __m256i bytes = _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(bytes, bytes), 0x08);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(packed));
+	}
+
+	return i;
+}
+
+#endif
+
+// Note: AVX2 leaves up to a block and a half for SSSE3 to pick up, which matters for digest-sized inputs
+
+inline std::size_t base64_encode_blocks(const char *in, std::size_t size, char *out, base64_alphabet alphabet)
+{
+	std::size_t done = 0;
+
+#if defined(SPL_STRING_SSE2)
+	if (cpu().avx2)
+		done = base64_encode_avx2(in, size, out, alphabet);
+
+	if (cpu().ssse3)
+		done += base64_encode_ssse3(in + done, size - done, out + done / 3 * 4, alphabet);
+#endif
+
+	return done;
+}
+
+inline std::size_t base64_decode_blocks(const char *in, std::size_t size, char *out, base64_alphabet alphabet)
+{
+	std::size_t done = 0;
+
+#if defined(SPL_STRING_SSE2)
+	if (cpu().avx2)
+		done = base64_decode_avx2(in, size, out, alphabet);
+
+	if (cpu().ssse3)
+		done += base64_decode_ssse3(in + done, size - done, out + done / 4 * 3, alphabet);
+#endif
+
+	return done;
+}
+
+inline std::size_t hex_encode_blocks(const char *in, std::size_t size, char *out, bool uppercase)
+{
+	std::size_t done = 0;
+
+#if defined(SPL_STRING_SSE2)
+	if (cpu().avx2)
+		done = hex_encode_avx2(in, size, out, uppercase);
+
+	if (cpu().ssse3)
+		done += hex_encode_ssse3(in + done, size - done, out + done * 2, uppercase);
+#endif
+
+	return done;
+}
+
+inline std::size_t hex_decode_blocks(const char *in, std::size_t size, char *out)
+{
+	std::size_t done = 0;
+
+#if defined(SPL_STRING_SSE2)
+	if (cpu().avx2)
+		done = hex_decode_avx2(in, size, out);
+
+	if (cpu().ssse3)
+		done += hex_decode_ssse3(in + done, size - done, out + done / 2);
+#endif
+
+	return done;
+}
+
+// Grows out by up to max_size bytes, has write fill them and keeps what it reports. Throws on a decode error,
+// leaving out as it was.
+template <typename Write>
+string &append_decoded(string &out, std::size_t max_size, const char *what, Write write)
+{
+	const std::size_t old_size = out.size();
+	decode_result result;
+
+	out.resize_and_overwrite(old_size + max_size, [&](char *buffer, std::size_t)
+	{
+		result = write(buffer + old_size);
+		return result ? old_size + result.size : old_size;
+	});
+
+	if (!result)
+		throw decode_error(what, result.error_position);
+
+	return out;
+}
+
+}
+
+// Length of the base64 encoding of size bytes
+constexpr std::size_t base64_encoded_size(std::size_t size, bool padding = true) noexcept
+{
+	return padding ? (size + 2) / 3 * 4 : size / 3 * 4 + (size % 3 ? size % 3 + 1 : 0);
+}
+
+// Most bytes that text can decode to, which is exact for valid unpadded input
+constexpr std::size_t base64_decoded_size(std::size_t size) noexcept
+{
+	return size / 4 * 3 + (size % 4 ? size % 4 - 1 : 0);
+}
+
+// Writes base64_encoded_size(data.size(), padding) characters to out and returns that count
+inline std::size_t base64_encode_to(char *out, const std::string_view &data, base64_alphabet alphabet = base64_alphabet::standard, bool padding = true)
+{
+	const char *chars = detail::base64_chars(alphabet);
+	const unsigned char *in = reinterpret_cast<const unsigned char*>(data.data());
+	const std::size_t size = data.size();
+
+	std::size_t i = detail::base64_encode_blocks(data.data(), size, out, alphabet);
+	char *cursor = out + i / 3 * 4;
+
+	for (; i + 3 <= size; i += 3, cursor += 4)
+	{
+		const std::uint32_t bits = std::uint32_t(in[i]) << 16 | std::uint32_t(in[i + 1]) << 8 | in[i + 2];
+
+		cursor[0] = chars[bits >> 18];
+		cursor[1] = chars[(bits >> 12) & 0x3F];
+		cursor[2] = chars[(bits >> 6) & 0x3F];
+		cursor[3] = chars[bits & 0x3F];
+	}
+
+	if (i < size)
+	{
+		const std::uint32_t bits = std::uint32_t(in[i]) << 16 | (i + 1 < size ? std::uint32_t(in[i + 1]) << 8 : 0);
+
+		*cursor++ = chars[bits >> 18];
+		*cursor++ = chars[(bits >> 12) & 0x3F];
+
+		if (i + 1 < size)
+			*cursor++ = chars[(bits >> 6) & 0x3F];
+		else if (padding)
+			*cursor++ = '=';
+
+		if (padding)
+			*cursor++ = '=';
+	}
+
+	return static_cast<std::size_t>(cursor - out);
+}
+
+inline string &append_base64(string &out, const std::string_view &data, base64_alphabet alphabet = base64_alphabet::standard, bool padding = true)
+{
+	const std::size_t old_size = out.size();
+
+	out.resize_and_overwrite(old_size + base64_encoded_size(data.size(), padding), [&](char *buffer, std::size_t size)
+	{
+		base64_encode_to(buffer + old_size, data, alphabet, padding);
+		return size;
+	});
+
+	return out;
+}
+
+inline string base64_encode(const std::string_view &data, base64_alphabet alphabet = base64_alphabet::standard, bool padding = true)
+{
+	string result;
+	append_base64(result, data, alphabet, padding);
+	return result;
+}
+
+// Writes at most base64_decoded_size(text.size()) bytes to out. Doesn't throw, check the result instead.
+inline decode_result base64_decode_to(char *out, const std::string_view &text, base64_alphabet alphabet = base64_alphabet::standard)
+{
+	const std::int8_t *values = detail::base64_table(alphabet).values;
+	const unsigned char *in = reinterpret_cast<const unsigned char*>(text.data());
+	decode_result result;
+
+	std::size_t body = text.size();
+	std::size_t padding = 0;
+
+	while (padding < 2 && body > 0 && text[body - 1] == '=')
+	{
+		--body;
+		++padding;
+	}
+
+	const std::size_t full = body - body % 4;
+	std::size_t i = detail::base64_decode_blocks(text.data(), full, out, alphabet);
+	char *cursor = out + i / 4 * 3;
+
+	const auto fail = [&](std::size_t position)
+	{
+		result.error_position = position;
+		return result;
+	};
+
+	for (; i < full; i += 4, cursor += 3)
+	{
+		const int a = values[in[i]];
+		const int b = values[in[i + 1]];
+		const int c = values[in[i + 2]];
+		const int d = values[in[i + 3]];
+
+		if ((a | b | c | d) < 0)
+			return fail(i + (a < 0 ? 0 : b < 0 ? 1 : c < 0 ? 2 : 3));
+
+		const std::uint32_t bits = std::uint32_t(a) << 18 | std::uint32_t(b) << 12 | std::uint32_t(c) << 6 | std::uint32_t(d);
+
+		cursor[0] = static_cast<char>(bits >> 16);
+		cursor[1] = static_cast<char>(bits >> 8);
+		cursor[2] = static_cast<char>(bits);
+	}
+
+	const std::size_t left = body - full;
+
+	for (std::size_t j = i; j < body; ++j)
+	{
+		if (values[in[j]] < 0)
+			return fail(j);
+	}
+
+	// Note: Padding only ever completes a group of four
+	if (padding && text.size() % 4)
+		return fail(body);
+
+	if (left == 1 || (left && !padding && alphabet == base64_alphabet::standard))
+		return fail(text.size());
+
+	if (left)
+	{
+		const std::uint32_t bits = std::uint32_t(values[in[i]]) << 18 | std::uint32_t(values[in[i + 1]]) << 12 |
+			(left == 3 ? std::uint32_t(values[in[i + 2]]) << 6 : 0);
+
+		// Note: Bits past the last whole byte have to be zero, or two different strings would decode the same
+		if (bits & (left == 3 ? 0xFFu : 0xFFFFu))
+			return fail(i + left - 1);
+
+		*cursor++ = static_cast<char>(bits >> 16);
+
+		if (left == 3)
+			*cursor++ = static_cast<char>(bits >> 8);
+	}
+
+	result.size = static_cast<std::size_t>(cursor - out);
+	return result;
+}
+
+// Throws decode_error on invalid input, leaving out as it was
+inline string &append_base64_decoded(string &out, const std::string_view &text, base64_alphabet alphabet = base64_alphabet::standard)
+{
+	return detail::append_decoded(out, base64_decoded_size(text.size()), "invalid base64", [&](char *buffer)
+	{
+		return base64_decode_to(buffer, text, alphabet);
+	});
+}
+
+inline string base64_decode(const std::string_view &text, base64_alphabet alphabet = base64_alphabet::standard)
+{
+	string result;
+	append_base64_decoded(result, text, alphabet);
+	return result;
+}
+
+constexpr std::size_t hex_encoded_size(std::size_t size) noexcept { return size * 2; }
+constexpr std::size_t hex_decoded_size(std::size_t size) noexcept { return size / 2; }
+
+// Writes hex_encoded_size(data.size()) characters to out and returns that count
+inline std::size_t hex_encode_to(char *out, const std::string_view &data, bool uppercase = false)
+{
+	const char *digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+	std::size_t i = detail::hex_encode_blocks(data.data(), data.size(), out, uppercase);
+
+	for (; i < data.size(); ++i)
+	{
+		const unsigned char byte = static_cast<unsigned char>(data[i]);
+
+		out[i * 2] = digits[byte >> 4];
+		out[i * 2 + 1] = digits[byte & 0x0F];
+	}
+
+	return data.size() * 2;
+}
+
+inline string &append_hex(string &out, const std::string_view &data, bool uppercase = false)
+{
+	const std::size_t old_size = out.size();
+
+	out.resize_and_overwrite(old_size + hex_encoded_size(data.size()), [&](char *buffer, std::size_t size)
+	{
+		hex_encode_to(buffer + old_size, data, uppercase);
+		return size;
+	});
+
+	return out;
+}
+
+inline string hex_encode(const std::string_view &data, bool uppercase = false)
+{
+	string result;
+	append_hex(result, data, uppercase);
+	return result;
+}
+
+// Writes at most hex_decoded_size(text.size()) bytes to out. Either case is accepted. Doesn't throw, check the result instead.
+inline decode_result hex_decode_to(char *out, const std::string_view &text)
+{
+	const std::int8_t *values = detail::hex_table().values;
+	const unsigned char *in = reinterpret_cast<const unsigned char*>(text.data());
+	decode_result result;
+
+	const std::size_t even = text.size() & ~std::size_t(1);
+	std::size_t i = detail::hex_decode_blocks(text.data(), even, out);
+
+	for (; i < even; i += 2)
+	{
+		const int high = values[in[i]];
+		const int low = values[in[i + 1]];
+
+		if ((high | low) < 0)
+		{
+			result.error_position = high < 0 ? i : i + 1;
+			return result;
+		}
+
+		out[i / 2] = static_cast<char>(high << 4 | low);
+	}
+
+	if (even != text.size())
+	{
+		result.error_position = values[in[even]] < 0 ? even : text.size();
+		return result;
+	}
+
+	result.size = even / 2;
+	return result;
+}
+
+// Throws decode_error on invalid input, leaving out as it was
+inline string &append_hex_decoded(string &out, const std::string_view &text)
+{
+	return detail::append_decoded(out, hex_decoded_size(text.size()), "invalid hex", [&](char *buffer)
+	{
+		return hex_decode_to(buffer, text);
+	});
+}
+
+inline string hex_decode(const std::string_view &text)
+{
+	string result;
+	append_hex_decoded(result, text);
+	return result;
+}
+
+namespace detail
+{
+
+// Bytes a JSON string can't hold as they are
+struct json_special
+{
+	static bool test(char ch) noexcept
+	{
+		return static_cast<unsigned char>(ch) < 0x20 || ch == '"' || ch == '\\';
+	}
+
+#if defined(SPL_STRING_AVX2)
+	static std::uint32_t mask(__m256i block) noexcept
+	{
+		const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(block, _mm256_set1_epi8(0x1F)), block);
+		const __m256i quote = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"'));
+		const __m256i backslash = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\'));
+
+		return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(control, _mm256_or_si256(quote, backslash))));
+	}
+#endif
+
+#if defined(SPL_STRING_SSE2)
+	static std::uint32_t mask(__m128i block) noexcept
+	{
+		const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(0x1F)), block);
+		const __m128i quote = _mm_cmpeq_epi8(block, _mm_set1_epi8('"'));
+		const __m128i backslash = _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'));
+
+		return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(control, _mm_or_si128(quote, backslash))));
+	}
+#endif
+};
+
+// Bytes outside RFC 3986's unreserved set, A-Z a-z 0-9 - . _ ~
+struct url_special
+{
+	static bool test(char ch) noexcept
+	{
+		return !((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') ||
+			ch == '-' || ch == '.' || ch == '_' || ch == '~');
+	}
+
+#if defined(SPL_STRING_AVX2)
+	static std::uint32_t mask(__m256i block) noexcept
+	{
+		// Note: Setting 0x20 lowercases letters, and no other byte lands in a-z
+		const __m256i letter = in_range_avx2(_mm256_or_si256(block, _mm256_set1_epi8(0x20)), 'a', 26);
+		const __m256i digit = in_range_avx2(block, '0', 10);
+		const __m256i marks = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('-')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('.'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('~'))));
+
+		return ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(letter, _mm256_or_si256(digit, marks))));
+	}
+#endif
+
+#if defined(SPL_STRING_SSE2)
+	static std::uint32_t mask(__m128i block) noexcept
+	{
+		const __m128i letter = in_range_sse2(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 26);
+		const __m128i digit = in_range_sse2(block, '0', 10);
+		const __m128i marks = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('-')), _mm_cmpeq_epi8(block, _mm_set1_epi8('.'))),
+			_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('_')), _mm_cmpeq_epi8(block, _mm_set1_epi8('~'))));
+
+		return ~static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(letter, _mm_or_si128(digit, marks)))) & 0xFFFFu;
+	}
+#endif
+};
+
+// Bytes that start something to decode in a URL, '%' and the '+' of form encoding
+struct url_escape_special
+{
+	static bool test(char ch) noexcept { return ch == '%' || ch == '+'; }
+
+#if defined(SPL_STRING_AVX2)
+	static std::uint32_t mask(__m256i block) noexcept
+	{
+		return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(
+			_mm256_cmpeq_epi8(block, _mm256_set1_epi8('%')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('+')))));
+	}
+#endif
+
+#if defined(SPL_STRING_SSE2)
+	static std::uint32_t mask(__m128i block) noexcept
+	{
+		return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(
+			_mm_cmpeq_epi8(block, _mm_set1_epi8('%')), _mm_cmpeq_epi8(block, _mm_set1_epi8('+')))));
+	}
+#endif
+};
+
+// Position of the first byte at or after pos that Special picks out, or size
+template <typename Special>
+std::size_t find_special(const char *str, std::size_t size, std::size_t pos) noexcept
+{
+#if defined(SPL_STRING_AVX2)
+	for (; pos + 32 <= size; pos += 32)
+	{
+		const std::uint32_t mask = Special::mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + pos)));
+
+		if (mask)
+			return pos + count_trailing_zeros(mask);
+	}
+#endif
+#if defined(SPL_STRING_SSE2)
+	for (; pos + 16 <= size; pos += 16)
+	{
+		const std::uint32_t mask = Special::mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(str + pos)));
+
+		if (mask)
+			return pos + count_trailing_zeros(mask);
+	}
+#endif
+
+	for (; pos < size; ++pos)
+	{
+		if (Special::test(str[pos]))
+			return pos;
+	}
+
+	return size;
+}
+
+// Appends text to out with every special byte replaced by what escape writes for it. escape_size gives how long
+// that is, so the output can be sized up front; when nothing needs escaping this is one scan and one copy.
+template <typename Special, typename EscapeSize, typename Escape>
+string &append_escaped(string &out, const std::string_view &text, EscapeSize escape_size, Escape escape)
+{
+	const char *in = text.data();
+	const std::size_t size = text.size();
+	const std::size_t first = find_special<Special>(in, size, 0);
+
+	std::size_t escaped_size = size;
+
+	for (std::size_t pos = first; pos < size; pos = find_special<Special>(in, size, pos + 1))
+		escaped_size += escape_size(in[pos]) - 1;
+
+	const std::size_t old_size = out.size();
+
+	out.resize_and_overwrite(old_size + escaped_size, [&](char *buffer, std::size_t total)
+	{
+		char *cursor = buffer + old_size;
+		std::size_t run = 0;
+
+		for (std::size_t pos = first; pos < size; pos = find_special<Special>(in, size, pos + 1))
+		{
+			std::memcpy(cursor, in + run, pos - run);
+			cursor = escape(in[pos], cursor + (pos - run));
+			run = pos + 1;
+		}
+
+		std::memcpy(cursor, in + run, size - run);
+		return total;
+	});
+
+	return out;
+}
+
+inline int hex_value(char ch) noexcept
+{
+	return hex_table().values[static_cast<unsigned char>(ch)];
+}
+
+}
+
+// Escapes text for use between the quotes of a JSON string: '"', '\\' and control characters get backslash escapes
+// and everything else, UTF-8 included, is copied as it is
+inline string &append_json_escaped(string &out, const std::string_view &text)
+{
+	const auto escape_size = [](char ch) -> std::size_t
+	{
+		switch (ch)
+		{
+			case '"': case '\\': case '\b': case '\f': case '\n': case '\r': case '\t':
+				return 2;
+			default:
+				return 6;
+		}
+	};
+
+	const auto escape = [](char ch, char *cursor)
+	{
+		*cursor++ = '\\';
+
+		switch (ch)
+		{
+			case '"': *cursor++ = '"'; break;
+			case '\\': *cursor++ = '\\'; break;
+			case '\b': *cursor++ = 'b'; break;
+			case '\f': *cursor++ = 'f'; break;
+			case '\n': *cursor++ = 'n'; break;
+			case '\r': *cursor++ = 'r'; break;
+			case '\t': *cursor++ = 't'; break;
+			default:
+				*cursor++ = 'u';
+				*cursor++ = '0';
+				*cursor++ = '0';
+				*cursor++ = "0123456789abcdef"[static_cast<unsigned char>(ch) >> 4];
+				*cursor++ = "0123456789abcdef"[ch & 0x0F];
+				break;
+		}
+
+		return cursor;
+	};
+
+	return detail::append_escaped<detail::json_special>(out, text, escape_size, escape);
+}
+
+inline string json_escape(const std::string_view &text)
+{
+	string result;
+	append_json_escaped(result, text);
+	return result;
+}
+
+// Reverses append_json_escaped() on the contents of a JSON string, without the quotes. \u escapes become UTF-8,
+// with surrogate pairs combined. Throws decode_error for unknown escapes, lone surrogates and raw '"' or control
+// characters, leaving out as it was.
+inline string &append_json_unescaped(string &out, const std::string_view &text)
+{
+	const char *in = text.data();
+	const std::size_t size = text.size();
+	const std::size_t old_size = out.size();
+
+	// Note: Escapes never decode to more bytes than they take up, so text.size() is enough room
+	out.resize_and_overwrite(old_size + size, [&](char *buffer, std::size_t)
+	{
+		char *cursor = buffer + old_size;
+		std::size_t run = 0;
+
+		// Reads the four hex digits after a \u at pos
+		const auto code_unit = [&](std::size_t pos)
+		{
+			char32_t unit = 0;
+
+			for (std::size_t i = pos + 2; i < pos + 6; ++i)
+			{
+				if (i >= size)
+					throw decode_error("invalid JSON escape", size);
+
+				const int digit = detail::hex_value(in[i]);
+
+				if (digit < 0)
+					throw decode_error("invalid JSON escape", i);
+
+				unit = unit << 4 | static_cast<char32_t>(digit);
+			}
+
+			return unit;
+		};
+
+		for (std::size_t pos = detail::find_special<detail::json_special>(in, size, 0); pos < size;
+			pos = detail::find_special<detail::json_special>(in, size, run))
+		{
+			if (in[pos] != '\\')
+				throw decode_error("unescaped character in JSON string", pos);
+
+			if (pos + 1 >= size)
+				throw decode_error("invalid JSON escape", size);
+
+			std::memcpy(cursor, in + run, pos - run);
+			cursor += pos - run;
+			run = pos + 2;
+
+			switch (in[pos + 1])
+			{
+				case '"': *cursor++ = '"'; break;
+				case '\\': *cursor++ = '\\'; break;
+				case '/': *cursor++ = '/'; break;
+				case 'b': *cursor++ = '\b'; break;
+				case 'f': *cursor++ = '\f'; break;
+				case 'n': *cursor++ = '\n'; break;
+				case 'r': *cursor++ = '\r'; break;
+				case 't': *cursor++ = '\t'; break;
+				case 'u':
+				{
+					char32_t cp = code_unit(pos);
+					run = pos + 6;
+
+					if (cp >= 0xDC00 && cp <= 0xDFFF)
+						throw decode_error("unpaired surrogate in JSON string", pos);
+
+					if (cp >= 0xD800 && cp <= 0xDBFF)
+					{
+						if (run + 1 >= size || in[run] != '\\' || in[run + 1] != 'u')
+							throw decode_error("unpaired surrogate in JSON string", pos);
+
+						const char32_t low = code_unit(run);
+
+						if (low < 0xDC00 || low > 0xDFFF)
+							throw decode_error("unpaired surrogate in JSON string", pos);
+
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+						run += 6;
+					}
+
+					cursor = detail::encode_utf8(cp, cursor);
+					break;
+				}
+				default:
+					throw decode_error("invalid JSON escape", pos);
+			}
+		}
+
+		std::memcpy(cursor, in + run, size - run);
+		return static_cast<std::size_t>(cursor + (size - run) - buffer);
+	});
+
+	return out;
+}
+
+inline string json_unescape(const std::string_view &text)
+{
+	string result;
+	append_json_unescaped(result, text);
+	return result;
+}
+
+// Percent-encodes every byte outside RFC 3986's unreserved set. With form set, spaces become '+' the way
+// application/x-www-form-urlencoded query strings have them.
+inline string &append_url_encoded(string &out, const std::string_view &text, bool form = false)
+{
+	const auto escape_size = [form](char ch) -> std::size_t
+	{
+		return form && ch == ' ' ? 1 : 3;
+	};
+
+	const auto escape = [form](char ch, char *cursor)
+	{
+		if (form && ch == ' ')
+		{
+			*cursor++ = '+';
+			return cursor;
+		}
+
+		*cursor++ = '%';
+		*cursor++ = "0123456789ABCDEF"[static_cast<unsigned char>(ch) >> 4];
+		*cursor++ = "0123456789ABCDEF"[ch & 0x0F];
+
+		return cursor;
+	};
+
+	return detail::append_escaped<detail::url_special>(out, text, escape_size, escape);
+}
+
+inline string url_encode(const std::string_view &text, bool form = false)
+{
+	string result;
+	append_url_encoded(result, text, form);
+	return result;
+}
+
+// Decodes %XX escapes, and '+' as a space when form is set. Throws decode_error for a '%' that isn't followed by
+// two hex digits, leaving out as it was.
+inline string &append_url_decoded(string &out, const std::string_view &text, bool form = false)
+{
+	const char *in = text.data();
+	const std::size_t size = text.size();
+	const std::size_t old_size = out.size();
+
+	out.resize_and_overwrite(old_size + size, [&](char *buffer, std::size_t)
+	{
+		char *cursor = buffer + old_size;
+		std::size_t run = 0;
+
+		for (std::size_t pos = detail::find_special<detail::url_escape_special>(in, size, 0); pos < size;
+			pos = detail::find_special<detail::url_escape_special>(in, size, pos + 1))
+		{
+			// Note: Without form, '+' is just a '+' and stays part of the run
+			if (in[pos] == '+' && !form)
+				continue;
+
+			std::memcpy(cursor, in + run, pos - run);
+			cursor += pos - run;
+
+			if (in[pos] == '+')
+			{
+				*cursor++ = ' ';
+				run = pos + 1;
+				continue;
+			}
+
+			const int high = pos + 1 < size ? detail::hex_value(in[pos + 1]) : -1;
+			const int low = pos + 2 < size ? detail::hex_value(in[pos + 2]) : -1;
+
+			if (high < 0)
+				throw decode_error("invalid percent escape", pos + 1);
+
+			if (low < 0)
+				throw decode_error("invalid percent escape", pos + 2);
+
+			*cursor++ = static_cast<char>(high << 4 | low);
+			pos += 2;
+			run = pos + 1;
+		}
+
+		std::memcpy(cursor, in + run, size - run);
+		return static_cast<std::size_t>(cursor + (size - run) - buffer);
+	});
+
+	return out;
+}
+
+inline string url_decode(const std::string_view &text, bool form = false)
+{
+	string result;
+	append_url_decoded(result, text, form);
+	return result;
+}
+
+}
@@ -0,0 +1,434 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+// Levenshtein distance (insertions, deletions and substitutions, all costing 1) between byte strings.
+//
+// This is Myers' bit-vector algorithm: a whole column of the dynamic programming matrix is kept as two bit vectors
+// of +1/-1 vertical differences, and a text byte advances it with a handful of word operations. Patterns up to 64
+// bytes fit one word and need no memory besides a 2 KiB table on the stack. Longer ones are split into 64 bit blocks
+// that pass carries down. The shorter string is always used as the pattern.
+//
+// Bounded variants give up as soon as the remaining bytes can't bring the distance back down to the bound.
+
+namespace spl
+{
+
+struct fuzzy_match
+{
+	constexpr static std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+	std::size_t position = npos;
+	std::size_t length = 0;
+	std::size_t distance = 0;
+
+	explicit operator bool() const noexcept { return position != npos; }
+};
+
+namespace detail
+{
+
+constexpr std::size_t myers_word_bits = 64;
+constexpr std::size_t myers_stack_blocks = 4;    // Patterns up to 256 bytes keep their column state on the stack
+
+inline std::size_t myers_blocks(std::size_t length) noexcept
+{
+	return (length + myers_word_bits - 1) / myers_word_bits;
+}
+
+// peq[c * blocks + b] has bit i set when byte 64 * b + i of the pattern is c. Expects peq to be zeroed.
+inline void myers_fill(const char *pattern, std::size_t length, std::size_t blocks, std::uint64_t *peq) noexcept
+{
+	for (std::size_t i = 0; i < length; ++i)
+		peq[static_cast<unsigned char>(pattern[i]) * blocks + i / myers_word_bits] |= std::uint64_t(1) << (i % myers_word_bits);
+}
+
+// Advances one block of the column by a text byte. hin is the difference coming in from the block above
+// (the row above the pattern for the first block) and the return value the one going out at high.
+inline int myers_advance(std::uint64_t &pv, std::uint64_t &mv, std::uint64_t eq, int hin, std::uint64_t high) noexcept
+{
+	const std::uint64_t xv = eq | mv;
+
+	if (hin < 0)
+		eq |= 1;
+
+	const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+	std::uint64_t ph = mv | ~(xh | pv);
+	std::uint64_t mh = pv & xh;
+
+	// Note: ph and mh never share a bit, and this is too random for branches to predict well
+	const int hout = static_cast<int>((ph & high) != 0) - static_cast<int>((mh & high) != 0);
+
+	ph <<= 1;
+	mh <<= 1;
+
+	if (hin < 0)
+		mh |= 1;
+	else if (hin > 0)
+		ph |= 1;
+
+	pv = mh | ~(xv | ph);
+	mv = ph & xv;
+
+	return hout;
+}
+
+struct myers_pattern
+{
+	const std::uint64_t *peq;
+	std::size_t blocks;
+	std::size_t length;
+};
+
+// Feeds text through the pattern and calls column(j, distance) after text[j], distance being the bottom row.
+// Stops early if column returns false. top is 1 when every text byte skipped costs an edit (edit distance)
+// and 0 when the pattern may start anywhere (searching). state holds 2 * blocks words.
+template <typename Column>
+void myers_scan(const myers_pattern &pattern, const char *text, std::size_t size, int top, std::uint64_t *state, Column &&column)
+{
+	const std::size_t blocks = pattern.blocks;
+	const std::uint64_t last_high = std::uint64_t(1) << ((pattern.length - 1) % myers_word_bits);
+	std::size_t distance = pattern.length;
+
+	if (blocks == 1)
+	{
+		std::uint64_t pv = ~std::uint64_t(0);
+		std::uint64_t mv = 0;
+
+		for (std::size_t j = 0; j < size; ++j)
+		{
+			distance += myers_advance(pv, mv, pattern.peq[static_cast<unsigned char>(text[j])], top, last_high);
+
+			if (!column(j, distance))
+				return;
+		}
+
+		return;
+	}
+
+	std::uint64_t *pv = state;
+	std::uint64_t *mv = state + blocks;
+
+	std::fill(pv, pv + blocks, ~std::uint64_t(0));
+	std::fill(mv, mv + blocks, 0);
+
+	constexpr std::uint64_t high = std::uint64_t(1) << (myers_word_bits - 1);
+
+	for (std::size_t j = 0; j < size; ++j)
+	{
+		const std::uint64_t *eq = pattern.peq + static_cast<unsigned char>(text[j]) * blocks;
+		int carry = top;
+
+		for (std::size_t b = 0; b + 1 < blocks; ++b)
+			carry = myers_advance(pv[b], mv[b], eq[b], carry, high);
+
+		distance += myers_advance(pv[blocks - 1], mv[blocks - 1], eq[blocks - 1], carry, last_high);
+
+		if (!column(j, distance))
+			return;
+	}
+}
+
+// Edit distance between the pattern and text, or bound + 1 once it's certain to exceed bound
+inline std::size_t myers_distance(const myers_pattern &pattern, const std::string_view &text, std::size_t bound, std::uint64_t *state)
+{
+	if (pattern.length == 0)
+		return text.size() <= bound ? text.size() : bound + 1;
+
+	const std::size_t difference = text.size() > pattern.length ? text.size() - pattern.length : pattern.length - text.size();
+
+	if (difference > bound)
+		return bound + 1;
+
+	// Note: The distance can't be more than the longer length, which also keeps the early exit test from overflowing
+	bound = std::min(bound, std::max(text.size(), pattern.length));
+
+	std::size_t result = pattern.length;
+
+	myers_scan(pattern, text.data(), text.size(), 1, state, [&](std::size_t j, std::size_t distance)
+	{
+		result = distance;
+
+		// Note: Each byte left can lower the distance by at most one
+		return distance <= bound + (text.size() - j - 1);
+	});
+
+	return result <= bound ? result : bound + 1;
+}
+
+// Owns the match table and column state for a pattern, on the stack when it's short enough
+class myers_buffers
+{
+public:
+
+	myers_buffers(const std::string_view &pattern) :
+		mBlocks(myers_blocks(pattern.size()))
+	{
+		if (mBlocks <= 1)
+		{
+			std::memset(mSmallPeq, 0, sizeof(mSmallPeq));
+			myers_fill(pattern.data(), pattern.size(), 1, mSmallPeq);
+			mPeq = mSmallPeq;
+		}
+		else
+		{
+			mLargePeq.assign(mBlocks * 256, 0);
+			myers_fill(pattern.data(), pattern.size(), mBlocks, mLargePeq.data());
+			mPeq = mLargePeq.data();
+		}
+
+		if (mBlocks <= myers_stack_blocks)
+		{
+			mState = mSmallState;
+		}
+		else
+		{
+			mLargeState.resize(mBlocks * 2);
+			mState = mLargeState.data();
+		}
+
+		mLength = pattern.size();
+	}
+
+	myers_buffers(const myers_buffers &) = delete;
+	myers_buffers &operator=(const myers_buffers &) = delete;
+
+	myers_pattern pattern() const noexcept { return { mPeq, mBlocks, mLength }; }
+	std::uint64_t *state() noexcept { return mState; }
+
+private:
+
+	std::size_t mBlocks;
+	std::size_t mLength = 0;
+	std::uint64_t *mPeq = nullptr;
+	std::uint64_t *mState = nullptr;
+
+	std::uint64_t mSmallPeq[256];
+	std::uint64_t mSmallState[myers_stack_blocks * 2];
+	std::vector<std::uint64_t> mLargePeq;
+	std::vector<std::uint64_t> mLargeState;
+};
+
+}
+
+// Smallest number of single byte insertions, deletions and substitutions that turn a into b
+inline std::size_t edit_distance(const std::string_view &a, const std::string_view &b)
+{
+	const std::string_view &pattern = a.size() <= b.size() ? a : b;
+	const std::string_view &text = a.size() <= b.size() ? b : a;
+
+	detail::myers_buffers buffers(pattern);
+	return detail::myers_distance(buffers.pattern(), text, std::numeric_limits<std::size_t>::max() - 1, buffers.state());
+}
+
+// The edit distance if it's at most max_distance, otherwise max_distance + 1. Stops as soon as that's known.
+inline std::size_t bounded_edit_distance(const std::string_view &a, const std::string_view &b, std::size_t max_distance)
+{
+	const std::string_view &pattern = a.size() <= b.size() ? a : b;
+	const std::string_view &text = a.size() <= b.size() ? b : a;
+
+	max_distance = std::min(max_distance, std::numeric_limits<std::size_t>::max() - 1);
+
+	if (text.size() - pattern.size() > max_distance)
+		return max_distance + 1;
+
+	detail::myers_buffers buffers(pattern);
+	return detail::myers_distance(buffers.pattern(), text, max_distance, buffers.state());
+}
+
+// Finds the first substring of haystack, starting at or after pos, within max_distance edits of needle.
+// The match ends where the distance first drops to max_distance or below, extended for as long as that keeps
+// lowering it, and starts wherever gives that distance with the shortest length.
+inline fuzzy_match fuzzy_find(const std::string_view &haystack, const std::string_view &needle, std::size_t max_distance, std::size_t pos = 0)
+{
+	fuzzy_match match;
+
+	if (pos > haystack.size())
+		return match;
+
+	// Note: Deleting the whole needle is within reach, so the empty string right at pos matches
+	if (needle.size() <= max_distance)
+	{
+		match.position = pos;
+		match.distance = needle.size();
+		return match;
+	}
+
+	std::size_t end = fuzzy_match::npos;
+	std::size_t best = needle.size();
+
+	{
+		detail::myers_buffers buffers(needle);
+
+		detail::myers_scan(buffers.pattern(), haystack.data() + pos, haystack.size() - pos, 0, buffers.state(), [&](std::size_t j, std::size_t distance)
+		{
+			if (end == fuzzy_match::npos)
+			{
+				if (distance > max_distance)
+					return true;
+			}
+			else if (distance >= best)
+			{
+				return false;
+			}
+
+			end = pos + j + 1;
+			best = distance;
+			return best != 0;
+		});
+	}
+
+	if (end == fuzzy_match::npos)
+		return match;
+
+	// Walk back from the end with both strings reversed, where the match has to begin right at the end
+	const std::size_t window = std::min(end - pos, needle.size() + best);
+
+	// Note: best is under needle.size(), so a single block needle and its window fit in 3 words of bytes
+	char small_reversed[3 * detail::myers_word_bits];
+	std::string large_reversed;
+	char *reversed = small_reversed;
+
+	if (needle.size() > detail::myers_word_bits)
+	{
+		large_reversed.resize(needle.size() + window);
+		reversed = large_reversed.data();
+	}
+
+	std::reverse_copy(needle.begin(), needle.end(), reversed);
+	std::reverse_copy(haystack.data() + end - window, haystack.data() + end, reversed + needle.size());
+
+	detail::myers_buffers buffers(std::string_view(reversed, needle.size()));
+	std::size_t length = 0;
+
+	detail::myers_scan(buffers.pattern(), reversed + needle.size(), window, 1, buffers.state(), [&](std::size_t j, std::size_t distance)
+	{
+		if (distance != best)
+			return true;
+
+		length = j + 1;
+		return false;
+	});
+
+	match.position = end - length;
+	match.length = length;
+	match.distance = best;
+
+	return match;
+}
+
+// One string scored against many, with the work that only depends on it done once
+class edit_distance_query
+{
+public:
+
+	using size_type = std::size_t;
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+	explicit edit_distance_query(const std::string_view &query) :
+		mQuery(query),
+		mBlocks(detail::myers_blocks(query.size())),
+		mPeq(std::max<size_type>(mBlocks, 1) * 256, 0)
+	{
+		detail::myers_fill(query.data(), query.size(), std::max<size_type>(mBlocks, 1), mPeq.data());
+	}
+
+	const string &query() const noexcept { return mQuery; }
+
+	size_type distance(const std::string_view &candidate) const
+	{
+		return bounded_distance(candidate, npos - 1);
+	}
+
+	// The distance if it's at most max_distance, otherwise max_distance + 1
+	size_type bounded_distance(const std::string_view &candidate, size_type max_distance) const
+	{
+		max_distance = std::min(max_distance, npos - 1);
+
+		std::uint64_t small_state[detail::myers_stack_blocks * 2];
+		std::vector<std::uint64_t> large_state;
+		std::uint64_t *state = small_state;
+
+		if (mBlocks > detail::myers_stack_blocks)
+		{
+			large_state.resize(mBlocks * 2);
+			state = large_state.data();
+		}
+
+		return detail::myers_distance({ mPeq.data(), mBlocks, mQuery.size() }, candidate, max_distance, state);
+	}
+
+	// out[i] is bounded_distance(candidates[i], max_distance)
+	template <typename Range>
+	void distances(const Range &candidates, std::vector<size_type> &out, size_type max_distance = npos) const
+	{
+		out.clear();
+
+		for (const auto &candidate : candidates)
+			out.push_back(bounded_distance(std::string_view(candidate), max_distance));
+	}
+
+	// Index of the closest candidate within max_distance, the earliest one on ties, or npos if there's none.
+	// The bound tightens as better candidates are found, so most of the rest are rejected early.
+	template <typename Range>
+	size_type closest(const Range &candidates, size_type max_distance = npos, size_type *distance = nullptr) const
+	{
+		size_type best = npos;
+		size_type index = 0;
+
+		for (const auto &candidate : candidates)
+		{
+			const size_type result = bounded_distance(std::string_view(candidate), max_distance);
+
+			if (result <= max_distance)
+			{
+				best = index;
+
+				if (distance)
+					*distance = result;
+
+				if (result == 0)
+					break;
+
+				max_distance = result - 1;
+			}
+
+			++index;
+		}
+
+		return best;
+	}
+
+private:
+
+	string mQuery;
+	size_type mBlocks;
+	std::vector<std::uint64_t> mPeq;
+};
+
+}
@@ -0,0 +1,372 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+// A wildcard pattern compiled once and matched against many strings.
+//
+// Supported syntax, matched against the whole string:
+//   *        any run of bytes, including none
+//   ?        any single byte
+//   [abc]    one of the listed bytes, with ranges like [a-z] and negation with [!abc] or [^abc]
+//   \x       x itself
+//
+// Unlike shell globbing there is nothing special about '/' or a leading '.'. Case-insensitive matching folds ASCII only.
+//
+// The pattern is cut at each '*' into segments that always match a fixed number of bytes. The first and last
+// segments are anchored to the ends of the string, and the ones in between are found one after another, each at
+// the leftmost place it fits. That greedy choice is always safe for '*', so a match never backtracks.
+// Segments are found with a SIMD scan for their two most selective bytes, followed by a check of the rest.
+
+namespace spl
+{
+
+namespace detail
+{
+
+struct glob_segment
+{
+	std::vector<char_set> atoms;
+	std::string literal;    // The bytes to memcmp() against when every atom is a single byte
+	bool is_literal = true;
+
+	// Atoms the search filters candidates with, the two with the smallest sets
+	std::size_t first_anchor = 0;
+	std::size_t second_anchor = 0;
+
+	std::size_t size() const noexcept { return atoms.size(); }
+
+	bool matches_at(const char *text) const noexcept
+	{
+		if (is_literal)
+			return std::memcmp(text, literal.data(), literal.size()) == 0;
+
+		for (std::size_t i = 0; i < atoms.size(); ++i)
+		{
+			if (!atoms[i].contains(text[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	void finish()
+	{
+		for (const char_set &atom : atoms)
+		{
+			if (atom.list_size != 1)
+			{
+				is_literal = false;
+				literal.clear();
+				break;
+			}
+
+			literal.push_back(atom.list[0]);
+		}
+
+		if (atoms.empty())
+			return;
+
+		// Note: Ties keep the earliest first anchor and the latest second one, so the two tend to be far apart
+		for (std::size_t i = 1; i < atoms.size(); ++i)
+		{
+			if (atoms[i].list_size < atoms[first_anchor].list_size)
+				first_anchor = i;
+		}
+
+		second_anchor = first_anchor;
+
+		for (std::size_t i = atoms.size(); i-- > 0;)
+		{
+			if (i != first_anchor && (second_anchor == first_anchor || atoms[i].list_size < atoms[second_anchor].list_size))
+				second_anchor = i;
+		}
+	}
+
+	// Leftmost position in [from, to - size()] where the segment matches, or npos
+	std::size_t find(const char *text, std::size_t from, std::size_t to) const noexcept
+	{
+		const std::size_t length = size();
+
+		if (to - from < length)
+			return std::numeric_limits<std::size_t>::max();
+
+		if (length == 0)
+			return from;
+
+		const std::size_t last = to - length;
+		std::size_t i = from;
+
+		// Note: Short ranges don't fill a SIMD block, and memchr() on the first byte wins there
+		if (is_literal && last - from < 64)
+		{
+			const std::size_t found = std::string_view(text + from, to - from).find(literal);
+			return found == std::string_view::npos ? found : from + found;
+		}
+
+		const char_set &first = atoms[first_anchor];
+		const char_set &second = atoms[second_anchor];
+
+		if (first.simd_friendly() && second.simd_friendly())
+		{
+#if defined(SPL_STRING_AVX2)
+			for (; i + 32 <= last + 1; i += 32)
+			{
+				const __m256i first_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + first_anchor));
+				const __m256i second_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + second_anchor));
+				std::uint32_t mask = char_set_mask(first_block, first) & char_set_mask(second_block, second);
+
+				while (mask)
+				{
+					const std::size_t candidate = i + count_trailing_zeros(mask);
+
+					if (matches_at(text + candidate))
+						return candidate;
+
+					mask &= mask - 1;
+				}
+			}
+#endif
+#if defined(SPL_STRING_SSE2)
+			for (; i + 16 <= last + 1; i += 16)
+			{
+				const __m128i first_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + first_anchor));
+				const __m128i second_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + second_anchor));
+				std::uint32_t mask = char_set_mask(first_block, first) & char_set_mask(second_block, second);
+
+				while (mask)
+				{
+					const std::size_t candidate = i + count_trailing_zeros(mask);
+
+					if (matches_at(text + candidate))
+						return candidate;
+
+					mask &= mask - 1;
+				}
+			}
+#endif
+		}
+
+		for (; i <= last; ++i)
+		{
+			if (first.contains(text[i + first_anchor]) && second.contains(text[i + second_anchor]) && matches_at(text + i))
+				return i;
+		}
+
+		return std::numeric_limits<std::size_t>::max();
+	}
+};
+
+}
+
+class glob
+{
+public:
+
+	using size_type = std::size_t;
+
+	explicit glob(const std::string_view &pattern, bool case_insensitive = false) :
+		mPattern(pattern),
+		mCaseInsensitive(case_insensitive)
+	{
+		compile();
+	}
+
+	bool matches(const std::string_view &text) const noexcept
+	{
+		if (text.size() < mMinLength)
+			return false;
+
+		const detail::glob_segment &front = mSegments.front();
+
+		if (!mHasStar)
+			return text.size() == front.size() && front.matches_at(text.data());
+
+		const detail::glob_segment &back = mSegments.back();
+
+		if (!front.matches_at(text.data()) || !back.matches_at(text.data() + text.size() - back.size()))
+			return false;
+
+		size_type pos = front.size();
+		const size_type end = text.size() - back.size();
+
+		for (size_type i = 1; i + 1 < mSegments.size(); ++i)
+		{
+			const size_type found = mSegments[i].find(text.data(), pos, end);
+
+			if (found == npos)
+				return false;
+
+			pos = found + mSegments[i].size();
+		}
+
+		return true;
+	}
+
+	bool operator()(const std::string_view &text) const noexcept { return matches(text); }
+
+	const string &pattern() const noexcept { return mPattern; }
+	bool case_insensitive() const noexcept { return mCaseInsensitive; }
+
+	// Shortest string the pattern can match
+	size_type min_length() const noexcept { return mMinLength; }
+
+private:
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+	void compile()
+	{
+		const std::string_view pattern = mPattern.view();
+		mSegments.emplace_back();
+
+		for (size_type i = 0; i < pattern.size();)
+		{
+			const char ch = pattern[i];
+
+			if (ch == '*')
+			{
+				// Note: Runs of stars are the same as one
+				if (!mHasStar || !mSegments.back().atoms.empty())
+					mSegments.emplace_back();
+
+				mHasStar = true;
+				++i;
+				continue;
+			}
+
+			std::string chars;
+
+			if (ch == '?')
+			{
+				chars.resize(256);
+
+				for (size_type c = 0; c < 256; ++c)
+					chars[c] = static_cast<char>(c);
+
+				++i;
+			}
+			else if (ch == '[' && parse_class(pattern, i, chars))
+			{
+			}
+			else
+			{
+				if (ch == '\\' && i + 1 < pattern.size())
+					++i;
+
+				chars = fold(pattern[i]);
+				++i;
+			}
+
+			mSegments.back().atoms.emplace_back(chars);
+		}
+
+		for (detail::glob_segment &segment : mSegments)
+		{
+			segment.finish();
+			mMinLength += segment.size();
+		}
+	}
+
+	std::string fold(char ch) const
+	{
+		std::string chars(1, ch);
+
+		if (mCaseInsensitive && detail::ascii_lower(ch) != detail::ascii_upper(ch))
+			chars = { detail::ascii_lower(ch), detail::ascii_upper(ch) };
+
+		return chars;
+	}
+
+	// Parses a bracket expression starting at pattern[i], advancing i past it.
+	// Returns false if it's never closed, in which case the '[' is just a literal.
+	bool parse_class(const std::string_view &pattern, size_type &i, std::string &chars) const
+	{
+		size_type pos = i + 1;
+		bool negate = false;
+
+		if (pos < pattern.size() && (pattern[pos] == '!' || pattern[pos] == '^'))
+		{
+			negate = true;
+			++pos;
+		}
+
+		bool member[256] = {};
+		bool first = true;
+
+		for (;;)
+		{
+			if (pos >= pattern.size())
+				return false;
+
+			char low = pattern[pos];
+
+			// Note: A ']' right after the opening bracket is a member, not the end
+			if (low == ']' && !first)
+				break;
+
+			if (low == '\\' && pos + 1 < pattern.size())
+				low = pattern[++pos];
+
+			++pos;
+			first = false;
+
+			char high = low;
+
+			if (pos + 1 < pattern.size() && pattern[pos] == '-' && pattern[pos + 1] != ']')
+			{
+				high = pattern[pos + 1];
+				pos += 2;
+
+				if (high == '\\' && pos < pattern.size())
+					high = pattern[pos++];
+			}
+
+			for (int c = static_cast<unsigned char>(low); c <= static_cast<unsigned char>(high); ++c)
+			{
+				for (const char folded : fold(static_cast<char>(c)))
+					member[static_cast<unsigned char>(folded)] = true;
+			}
+		}
+
+		for (size_type c = 0; c < 256; ++c)
+		{
+			if (member[c] != negate)
+				chars.push_back(static_cast<char>(c));
+		}
+
+		i = pos + 1;
+		return true;
+	}
+
+	string mPattern;
+	bool mCaseInsensitive = false;
+	bool mHasStar = false;
+	size_type mMinLength = 0;
+	std::vector<detail::glob_segment> mSegments;
+};
+
+}
@@ -0,0 +1,373 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+#include <cerrno>
+#include <climits>
+#include <deque>
+#include <system_error>
+
+#if defined(_WIN32)
+	#include <io.h>
+#else
+	#include <poll.h>
+	#include <sys/uio.h>
+	#include <unistd.h>
+#endif
+
+// Builds output out of references to existing strings and writes it with writev(), instead of appending
+// everything into one buffer first. Pieces of copy_threshold bytes or less are copied into a scratch area that
+// starts out inside the builder, since an iovec entry for them costs more than the copy. Everything else goes
+// out straight from where it already lives.
+
+namespace spl
+{
+
+namespace detail
+{
+
+#if !defined(_WIN32)
+#if defined(IOV_MAX)
+constexpr std::size_t iovec_batch = IOV_MAX < 1024 ? IOV_MAX : 1024;
+#else
+constexpr std::size_t iovec_batch = 16;    // _XOPEN_IOV_MAX, the least POSIX allows
+#endif
+#endif
+
+}
+
+class iovec_builder
+{
+public:
+
+	using size_type = std::size_t;
+
+	constexpr static size_type copy_threshold = 64;
+	constexpr static size_type inline_scratch = 512;
+
+	iovec_builder() = default;
+
+	// Note: Not copyable, the segments point into strings the builder owns
+	iovec_builder(const iovec_builder &) = delete;
+	iovec_builder &operator=(const iovec_builder &) = delete;
+
+	iovec_builder(iovec_builder &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	// Note: The owned strings and heap scratch move without their buffers moving, so the segments stay valid
+	iovec_builder &operator=(iovec_builder &&rhs) noexcept
+	{
+		if (&rhs == this)
+			return *this;
+
+		mSegments = std::move(rhs.mSegments);
+		mOwned = std::move(rhs.mOwned);
+		mHeapScratch = std::move(rhs.mHeapScratch);
+		mFront = rhs.mFront;
+		mFrontOffset = rhs.mFrontOffset;
+		mSize = rhs.mSize;
+		mScratchSize = rhs.mScratchSize;
+
+		if (mHeapScratch.empty())
+			std::memcpy(mInlineScratch, rhs.mInlineScratch, mScratchSize);
+
+		rhs.clear();
+
+		return *this;
+	}
+
+	// Note: A referenced piece has to stay alive and unchanged until it's been written, flattened or cleared
+	iovec_builder &append(const std::string_view &piece)
+	{
+		if (piece.size() <= copy_threshold)
+			return append_copy(piece);
+
+		if (mSegments.size() > mFront)
+		{
+			segment &last = mSegments.back();
+
+			// Neighbouring slices of the same buffer become one entry
+			if (last.data && last.data + last.size == piece.data())
+			{
+				last.size += piece.size();
+				mSize += piece.size();
+				return *this;
+			}
+		}
+
+		mSegments.push_back({ piece.data(), 0, piece.size() });
+		mSize += piece.size();
+
+		return *this;
+	}
+
+	iovec_builder &append(const char *str) { return append(std::string_view(str)); }
+	iovec_builder &append(const string &str) { return append(str.view()); }
+	iovec_builder &append(const std::string &str) { return append(std::string_view(str)); }
+
+	// Keeps the string alive inside the builder instead of copying it
+	iovec_builder &append(string &&str)
+	{
+		if (str.size() <= copy_threshold)
+			return append_copy(str.view());
+
+		mOwned.push_back(std::move(str));
+		return append(mOwned.back().view());
+	}
+
+	iovec_builder &append(std::string &&str) { return append_copy(str); }
+
+	iovec_builder &append(char ch) { return append_copy(std::string_view(&ch, 1)); }
+
+	// Copies the piece into the builder no matter how big it is
+	iovec_builder &append_copy(const std::string_view &piece)
+	{
+		if (piece.empty())
+			return *this;
+
+		const size_type offset = mScratchSize;
+		grow_scratch(piece.size());
+		std::memcpy(scratch() + offset, piece.data(), piece.size());
+
+		mSize += piece.size();
+
+		// Note: Scratch is only ever appended to, so a scratch segment at the back always ends where this begins
+		if (mSegments.size() > mFront && !mSegments.back().data)
+		{
+			mSegments.back().size += piece.size();
+			return *this;
+		}
+
+		mSegments.push_back({ nullptr, offset, piece.size() });
+
+		return *this;
+	}
+
+	template <typename T>
+	iovec_builder &operator<<(T &&piece)
+	{
+		return append(std::forward<T>(piece));
+	}
+
+	// Bytes left to write
+	size_type size() const noexcept { return mSize; }
+	bool empty() const noexcept { return mSize == 0; }
+
+	// iovec entries left to write
+	size_type segment_count() const noexcept { return mSegments.size() - mFront; }
+
+	void clear() noexcept
+	{
+		mSegments.clear();
+		mOwned.clear();
+		mHeapScratch.clear();
+		mScratchSize = 0;
+		mFront = 0;
+		mFrontOffset = 0;
+		mSize = 0;
+	}
+
+	// Calls f with a std::string_view of each piece left to write, in order
+	template <typename F>
+	void for_each_segment(F &&f) const
+	{
+		for (size_type i = mFront; i < mSegments.size(); ++i)
+			f(piece(i));
+	}
+
+	// Everything left to write as one string, with a single allocation
+	string flatten() const
+	{
+		string result(mSize, string::uninitialized_t{});
+		char *out = result.data();
+
+		for_each_segment([&out](const std::string_view &piece)
+		{
+			std::memcpy(out, piece.data(), piece.size());
+			out += piece.size();
+		});
+
+		return result;
+	}
+
+	// Makes one writev() call with up to IOV_MAX entries and drops whatever it wrote from the front.
+	// Returns the number of bytes written, which is 0 if fd is non-blocking and can't take more right now.
+	// Throws std::system_error if the write fails.
+	size_type write_some(int fd)
+	{
+		if (empty())
+			return 0;
+
+#if defined(_WIN32)
+		// Note: No writev() here, so this goes one piece at a time
+		const std::string_view front = piece(mFront);
+		const int written = ::_write(fd, front.data(), static_cast<unsigned int>(std::min<size_type>(front.size(), INT_MAX)));
+
+		if (written < 0)
+			throw std::system_error(errno, std::generic_category(), "write failed");
+
+		consume(static_cast<size_type>(written));
+		return static_cast<size_type>(written);
+#else
+		iovec vectors[detail::iovec_batch];
+		const size_type count = std::min(segment_count(), detail::iovec_batch);
+
+		for (size_type i = 0; i < count; ++i)
+		{
+			const std::string_view bytes = piece(mFront + i);
+
+			vectors[i].iov_base = const_cast<char*>(bytes.data());
+			vectors[i].iov_len = bytes.size();
+		}
+
+		for (;;)
+		{
+			const ssize_t written = ::writev(fd, vectors, static_cast<int>(count));
+
+			if (written >= 0)
+			{
+				consume(static_cast<size_type>(written));
+				return static_cast<size_type>(written);
+			}
+
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+
+			throw std::system_error(errno, std::generic_category(), "writev failed");
+		}
+#endif
+	}
+
+	// Writes everything, picking up after partial writes and waiting on non-blocking descriptors when they're full.
+	// Returns the number of bytes written and leaves the builder empty.
+	size_type write(int fd)
+	{
+		size_type total = 0;
+
+		while (!empty())
+		{
+			const size_type written = write_some(fd);
+			total += written;
+
+#if !defined(_WIN32)
+			if (written == 0)
+			{
+				pollfd request = { fd, POLLOUT, 0 };
+
+				while (::poll(&request, 1, -1) < 0)
+				{
+					if (errno != EINTR)
+						throw std::system_error(errno, std::generic_category(), "poll failed");
+				}
+			}
+#endif
+		}
+
+		return total;
+	}
+
+private:
+
+	// Points at the referenced bytes, or at offset into scratch when data is nullptr
+	struct segment
+	{
+		const char *data;
+		size_type offset;
+		size_type size;
+	};
+
+	// What's left of segment i
+	std::string_view piece(size_type i) const noexcept
+	{
+		const segment &s = mSegments[i];
+		const size_type skip = i == mFront ? mFrontOffset : 0;
+
+		return std::string_view((s.data ? s.data : scratch() + s.offset) + skip, s.size - skip);
+	}
+
+	char *scratch() noexcept { return mHeapScratch.empty() ? mInlineScratch : mHeapScratch.data(); }
+	const char *scratch() const noexcept { return mHeapScratch.empty() ? mInlineScratch : mHeapScratch.data(); }
+
+	void grow_scratch(size_type count)
+	{
+		const size_type needed = mScratchSize + count;
+		const size_type capacity = mHeapScratch.empty() ? inline_scratch : mHeapScratch.size();
+
+		if (needed > capacity)
+		{
+			const bool was_inline = mHeapScratch.empty();
+			mHeapScratch.resize(std::max(needed, capacity * 2));
+
+			if (was_inline)
+				std::memcpy(mHeapScratch.data(), mInlineScratch, mScratchSize);
+		}
+
+		mScratchSize = needed;
+	}
+
+	void consume(size_type count) noexcept
+	{
+		mSize -= count;
+
+		while (count)
+		{
+			const size_type left = mSegments[mFront].size - mFrontOffset;
+
+			if (count < left)
+			{
+				mFrontOffset += count;
+				return;
+			}
+
+			count -= left;
+			++mFront;
+			mFrontOffset = 0;
+		}
+
+		if (mFront == mSegments.size())
+			clear();
+	}
+
+	std::vector<segment> mSegments;
+	size_type mFront = 0;          // First segment not fully written
+	size_type mFrontOffset = 0;    // Bytes of it already written
+	size_type mSize = 0;
+
+	// Note: A deque never moves its elements, so the strings' buffers stay where the segments point
+	std::deque<string> mOwned;
+
+	char mInlineScratch[inline_scratch];
+	std::vector<char> mHeapScratch;
+	size_type mScratchSize = 0;
+};
+
+}
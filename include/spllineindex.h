@@ -0,0 +1,374 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+// Where every line of a text starts, for jumping straight to line n or turning a byte offset into a line and column.
+//
+//	spl::line_index lines(log);
+//	std::string_view line = lines.line(41'999);
+//	auto [line, column] = lines.position_of(offset);
+//
+//	log += more;
+//	lines.extend(log);    // Only looks at the new part
+//
+// Lines end at '\n', which isn't part of the line, and neither is a '\r' right before it. A '\n' at the very end
+// of the text doesn't start another line, so "a\nb" and "a\nb\n" both have 2 lines and "" has none.
+//
+// Newlines are found 64 bytes at a time as a bitmask from SIMD compares, the same way splcsv.h finds separators,
+// and count_newlines() just adds up their popcounts.
+//
+// Line starts are kept in groups of 64: a 64-bit offset for the group plus a delta for each line from that offset,
+// 16 bits wide unless the group spans 64 KiB or more, in which case the whole group widens to 32 (or 64) bits.
+// With ordinary line lengths that comes to about 2.25 bytes per line. The index only refers to the text, it doesn't
+// keep a copy, so the text has to outlive it (or be handed to extend() again after it moves).
+
+namespace spl
+{
+
+namespace detail
+{
+
+constexpr std::size_t line_block_size = 64;
+constexpr std::size_t line_chunk_blocks = 256;    // 16 KiB classified per pass, so the masks stay in L1
+constexpr std::size_t line_group_size = 64;
+
+inline void newline_masks_scalar(const char *data, std::size_t blocks, std::uint64_t *masks)
+{
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		const char *block = data + b * line_block_size;
+		std::uint64_t mask = 0;
+
+		for (std::size_t i = 0; i < line_block_size; ++i)
+			mask |= std::uint64_t(block[i] == '\n') << i;
+
+		masks[b] = mask;
+	}
+}
+
+#if defined(SPL_STRING_SSE2)
+inline void newline_masks_sse2(const char *data, std::size_t blocks, std::uint64_t *masks)
+{
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		const char *block = data + b * line_block_size;
+		std::uint64_t mask = 0;
+
+		for (std::size_t i = 0; i < line_block_size; i += 16)
+		{
+			const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+			mask |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(input, newline)))) << i;
+		}
+
+		masks[b] = mask;
+	}
+}
+
+SPL_STRING_TARGET("avx2")
+inline void newline_masks_avx2(const char *data, std::size_t blocks, std::uint64_t *masks)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		const char *block = data + b * line_block_size;
+		const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+		const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+		masks[b] = std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)))) |
+			std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)))) << 32;
+	}
+}
+#endif
+
+// Bit i of masks[b] is set if data[b * 64 + i] is a newline
+inline void newline_masks(const char *data, std::size_t blocks, std::uint64_t *masks)
+{
+#if defined(SPL_STRING_SSE2)
+	if (cpu().avx2)
+		return newline_masks_avx2(data, blocks, masks);
+
+	return newline_masks_sse2(data, blocks, masks);
+#else
+	return newline_masks_scalar(data, blocks, masks);
+#endif
+}
+
+inline unsigned popcount64(std::uint64_t value)
+{
+	return popcount(static_cast<std::uint32_t>(value)) + popcount(static_cast<std::uint32_t>(value >> 32));
+}
+
+// Calls f(mask, offset) for each 64-byte block of text, with the bits past the end of text clear
+template <typename F>
+void for_each_newline_mask(const std::string_view &text, F &&f)
+{
+	std::uint64_t masks[line_chunk_blocks];
+	std::size_t offset = 0;
+
+	while (text.size() - offset >= line_block_size)
+	{
+		const std::size_t blocks = std::min((text.size() - offset) / line_block_size, line_chunk_blocks);
+		newline_masks(text.data() + offset, blocks, masks);
+
+		for (std::size_t b = 0; b < blocks; ++b)
+			f(masks[b], offset + b * line_block_size);
+
+		offset += blocks * line_block_size;
+	}
+
+	if (offset < text.size())
+	{
+		std::uint64_t mask = 0;
+
+		for (std::size_t i = offset; i < text.size(); ++i)
+			mask |= std::uint64_t(text[i] == '\n') << (i - offset);
+
+		f(mask, offset);
+	}
+}
+
+}
+
+// Number of '\n' in text
+inline std::size_t count_newlines(const std::string_view &text)
+{
+	std::size_t count = 0;
+	detail::for_each_newline_mask(text, [&count](std::uint64_t mask, std::size_t) { count += detail::popcount64(mask); });
+	return count;
+}
+
+// A byte offset as a line and the byte offset within that line, both from 0
+struct line_position
+{
+	std::size_t line;
+	std::size_t column;
+};
+
+class line_index
+{
+public:
+
+	using size_type = std::size_t;
+
+	line_index() = default;
+
+	explicit line_index(const std::string_view &text)
+	{
+		const size_type newlines = count_newlines(text);
+
+		mGroups.reserve(newlines / detail::line_group_size + 1);
+		mDeltas.reserve(newlines + 1);
+
+		extend(text);
+	}
+
+	// Picks up text that's been added to the end. text has to be the indexed text plus whatever was appended,
+	// though it's fine if it has moved; only the new part gets scanned.
+	void extend(const std::string_view &text)
+	{
+		if (text.size() < mText.size())
+			throw std::invalid_argument("text is shorter than what was indexed");
+
+		if (!mStarts)
+			add_start(0);
+
+		const size_type scanned = mText.size();
+		mText = text;
+
+		detail::for_each_newline_mask(text.substr(scanned), [this, scanned](std::uint64_t mask, size_type offset)
+		{
+			while (mask)
+			{
+				add_start(scanned + offset + detail::count_trailing_zeros64(mask) + 1);
+				mask &= mask - 1;
+			}
+		});
+	}
+
+	size_type line_count() const noexcept
+	{
+		// Note: The last start is only a line if something comes after it
+		return mStarts && start(mStarts - 1) == mText.size() ? mStarts - 1 : mStarts;
+	}
+
+	// Line n without its line ending
+	std::string_view line(size_type n) const
+	{
+		if (n >= line_count())
+			throw std::out_of_range("invalid line number");
+
+		const size_type begin = start(n);
+
+		// Note: A '\r' at the very end stays, it only belongs to the line ending once a '\n' follows it
+		if (n + 1 == mStarts)
+			return mText.substr(begin);
+
+		size_type end = start(n + 1) - 1;
+
+		if (end > begin && mText[end - 1] == '\r')
+			--end;
+
+		return mText.substr(begin, end - begin);
+	}
+
+	// Offset of the first byte of line n. line_start(line_count()) is the end of the text.
+	size_type line_start(size_type n) const
+	{
+		if (n > line_count())
+			throw std::out_of_range("invalid line number");
+
+		return n < mStarts ? start(n) : mText.size();
+	}
+
+	// The line offset is on, which is the number of newlines before it
+	size_type line_of(size_type offset) const
+	{
+		if (offset > mText.size())
+			throw std::out_of_range("invalid string position");
+
+		if (mGroups.empty())
+			return 0;
+
+		// The last group whose first line starts at or before offset, then the last line in it that does
+		const auto group = std::upper_bound(mGroups.begin(), mGroups.end(), offset, [](size_type value, const line_group &g) { return value < g.base; }) - 1;
+		const size_type first = static_cast<size_type>(group - mGroups.begin()) * detail::line_group_size;
+
+		size_type low = first;
+		size_type high = std::min(first + detail::line_group_size, mStarts);
+
+		while (high - low > 1)
+		{
+			const size_type middle = low + (high - low) / 2;
+
+			if (start(middle) <= offset)
+				low = middle;
+			else
+				high = middle;
+		}
+
+		return low;
+	}
+
+	line_position position_of(size_type offset) const
+	{
+		const size_type line = line_of(offset);
+		return { line, mStarts ? offset - start(line) : 0 };
+	}
+
+	const std::string_view &text() const noexcept { return mText; }
+
+	size_type memory_usage() const noexcept
+	{
+		return mGroups.capacity() * sizeof(line_group) + mDeltas.capacity() * sizeof(std::uint16_t);
+	}
+
+private:
+
+	struct line_group
+	{
+		std::uint64_t base;       // Where the group's first line starts
+		std::uint32_t deltas;     // Index of its first delta
+		std::uint32_t width;      // 16-bit words per delta, 1, 2 or 4
+	};
+
+	static std::uint64_t read_delta(const std::uint16_t *words, std::uint32_t width) noexcept
+	{
+		std::uint64_t value = 0;
+
+		for (std::uint32_t i = 0; i < width; ++i)
+			value |= std::uint64_t(words[i]) << (i * 16);
+
+		return value;
+	}
+
+	static void write_delta(std::uint16_t *words, std::uint32_t width, std::uint64_t value) noexcept
+	{
+		for (std::uint32_t i = 0; i < width; ++i)
+			words[i] = static_cast<std::uint16_t>(value >> (i * 16));
+	}
+
+	size_type start(size_type n) const noexcept
+	{
+		const line_group &group = mGroups[n / detail::line_group_size];
+		const std::uint16_t *words = mDeltas.data() + group.deltas + n % detail::line_group_size * group.width;
+
+		if (group.width == 1)
+			return static_cast<size_type>(group.base + *words);
+
+		return static_cast<size_type>(group.base + read_delta(words, group.width));
+	}
+
+	void add_start(size_type offset)
+	{
+		if (mStarts % detail::line_group_size == 0)
+		{
+			if (mDeltas.size() > std::numeric_limits<std::uint32_t>::max() - 4 * detail::line_group_size)
+				throw std::length_error("too many lines for line_index");
+
+			mGroups.push_back({ offset, static_cast<std::uint32_t>(mDeltas.size()), 1 });
+			mDeltas.push_back(0);
+			++mStarts;
+			return;
+		}
+
+		line_group &group = mGroups.back();
+		const std::uint64_t delta = offset - group.base;
+		const std::uint32_t width = delta <= 0xFFFFu ? 1 : delta <= 0xFFFFFFFFu ? 2 : 4;
+
+		// Note: The group being filled is always the last one, so its deltas are at the end and can be widened in place
+		if (width > group.width)
+		{
+			const size_type count = mStarts % detail::line_group_size;
+			std::vector<std::uint64_t> values(count);
+
+			for (size_type i = 0; i < count; ++i)
+				values[i] = read_delta(mDeltas.data() + group.deltas + i * group.width, group.width);
+
+			mDeltas.resize(group.deltas + count * width);
+
+			for (size_type i = 0; i < count; ++i)
+				write_delta(mDeltas.data() + group.deltas + i * width, width, values[i]);
+
+			group.width = width;
+		}
+
+		const size_type at = mDeltas.size();
+		mDeltas.resize(at + group.width);
+		write_delta(mDeltas.data() + at, group.width, delta);
+		++mStarts;
+	}
+
+	std::string_view mText;
+	std::vector<line_group> mGroups;
+	std::vector<std::uint16_t> mDeltas;
+	size_type mStarts = 0;    // Line starts recorded, including one right at the end of the text after a final '\n'
+};
+
+}
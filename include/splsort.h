@@ -0,0 +1,608 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+#include <atomic>
+#include <iterator>
+#include <thread>
+
+// String sorting that doesn't re-compare common prefixes.
+//
+// sort_strings() sorts pointers to the strings rather than the strings themselves, then moves the elements into
+// place once at the end. Each pointer carries the next 8 bytes of its string as a big-endian integer, so a radix
+// pass or comparison only goes back to string memory every 8 bytes of depth:
+//
+//	- MSD radix sort on one byte at a time while a bucket is large
+//	- multikey quicksort on the whole 8 byte key once it's small
+//	- insertion sort at the bottom
+//
+// Natural ordering ("file2" before "file10") sorts the same way, on keys rewritten so that digit runs compare by
+// value, with a comparison sort only for the rare strings whose keys tie.
+
+namespace spl
+{
+
+struct sort_options
+{
+	bool case_insensitive = false;   // ASCII letters compare as lowercase
+	bool natural = false;            // Runs of digits compare by numeric value
+	bool parallel = false;           // Spread large sorts over threads
+	unsigned threads = 0;            // 0 = std::thread::hardware_concurrency()
+};
+
+namespace detail
+{
+
+struct sort_entry
+{
+	const char *data;
+	std::size_t size;
+	std::uint64_t key;
+	std::size_t index;
+};
+
+constexpr std::size_t sort_radix_threshold = 64;
+constexpr std::size_t sort_insertion_threshold = 12;
+constexpr std::size_t sort_parallel_threshold = 1 << 16;
+
+// ASCII lowercase on all 8 bytes of a word at once
+constexpr std::uint64_t fold_ascii_word(std::uint64_t word) noexcept
+{
+	constexpr std::uint64_t ones = 0x0101010101010101ull;
+	constexpr std::uint64_t high = 0x8080808080808080ull;
+
+	const std::uint64_t low7 = word & ~high;
+	const std::uint64_t at_least_a = low7 + (0x80 - 'A') * ones;
+	const std::uint64_t above_z = low7 + (0x80 - 'Z' - 1) * ones;
+	const std::uint64_t upper = (at_least_a ^ above_z) & ~word & high;
+
+	return word | (upper >> 2);
+}
+
+inline std::size_t sort_key_length(const sort_entry &entry, std::size_t depth) noexcept
+{
+	return depth < entry.size ? std::min<std::size_t>(8, entry.size - depth) : 0;
+}
+
+// Bytes [depth, depth + 8) as a big-endian integer, zero padded past the end of the string
+inline std::uint64_t load_sort_key(const sort_entry &entry, std::size_t depth, bool fold) noexcept
+{
+	const std::size_t length = sort_key_length(entry, depth);
+
+	if (length == 0)
+		return 0;
+
+	unsigned char bytes[8] = {};
+	std::memcpy(bytes, entry.data + depth, length);
+
+	std::uint64_t key = 0;
+
+	for (const unsigned char byte : bytes)
+		key = key << 8 | byte;
+
+	return fold ? fold_ascii_word(key) : key;
+}
+
+inline void load_sort_keys(sort_entry *entries, std::size_t count, std::size_t depth, bool fold) noexcept
+{
+	for (std::size_t i = 0; i < count; ++i)
+		entries[i].key = load_sort_key(entries[i], depth, fold);
+}
+
+// Orders by key, then by how many bytes of the key are real, which puts "ab" before "ab\0"
+inline int compare_sort_keys(const sort_entry &lhs, const sort_entry &rhs, std::size_t depth) noexcept
+{
+	if (lhs.key != rhs.key)
+		return lhs.key < rhs.key ? -1 : 1;
+
+	const std::size_t lhs_length = sort_key_length(lhs, depth);
+	const std::size_t rhs_length = sort_key_length(rhs, depth);
+
+	return lhs_length == rhs_length ? 0 : (lhs_length < rhs_length ? -1 : 1);
+}
+
+// Full comparison from depth on, for entries whose keys are loaded at depth
+inline bool sort_entry_less(const sort_entry &lhs, const sort_entry &rhs, std::size_t depth, bool fold) noexcept
+{
+	if (const int result = compare_sort_keys(lhs, rhs, depth))
+		return result < 0;
+
+	if (sort_key_length(lhs, depth) < 8)
+		return false;
+
+	const std::size_t common = std::min(lhs.size, rhs.size);
+
+	for (std::size_t i = depth + 8; i < common; ++i)
+	{
+		unsigned char a = static_cast<unsigned char>(lhs.data[i]);
+		unsigned char b = static_cast<unsigned char>(rhs.data[i]);
+
+		if (fold)
+		{
+			a = ascii_lower(a);
+			b = ascii_lower(b);
+		}
+
+		if (a != b)
+			return a < b;
+	}
+
+	return lhs.size < rhs.size;
+}
+
+inline void insertion_sort_entries(sort_entry *entries, std::size_t count, std::size_t depth, bool fold) noexcept
+{
+	for (std::size_t i = 1; i < count; ++i)
+	{
+		const sort_entry entry = entries[i];
+		std::size_t j = i;
+
+		for (; j > 0 && sort_entry_less(entry, entries[j - 1], depth, fold); --j)
+			entries[j] = entries[j - 1];
+
+		entries[j] = entry;
+	}
+}
+
+// Multikey quicksort over 8 byte keys already loaded at depth. Entries equal on the whole key move on to the
+// next 8 bytes; entries equal on a partial key are equal strings.
+inline void multikey_quicksort(sort_entry *entries, std::size_t count, std::size_t depth, bool fold) noexcept
+{
+	while (count > sort_insertion_threshold)
+	{
+		// Median of three
+		sort_entry *a = &entries[0];
+		sort_entry *b = &entries[count / 2];
+		sort_entry *c = &entries[count - 1];
+
+		if (compare_sort_keys(*b, *a, depth) < 0) std::swap(a, b);
+		if (compare_sort_keys(*c, *b, depth) < 0) std::swap(b, c);
+		if (compare_sort_keys(*b, *a, depth) < 0) std::swap(a, b);
+
+		const sort_entry pivot = *b;
+
+		// Dijkstra three-way partition: [0, lt) less, [lt, i) equal, [gt, count) greater
+		std::size_t lt = 0;
+		std::size_t i = 0;
+		std::size_t gt = count;
+
+		while (i < gt)
+		{
+			const int result = compare_sort_keys(entries[i], pivot, depth);
+
+			if (result < 0)
+				std::swap(entries[lt++], entries[i++]);
+			else if (result > 0)
+				std::swap(entries[i], entries[--gt]);
+			else
+				++i;
+		}
+
+		multikey_quicksort(entries, lt, depth, fold);
+		multikey_quicksort(entries + gt, count - gt, depth, fold);
+
+		if (sort_key_length(pivot, depth) < 8)
+			return;
+
+		entries += lt;
+		count = gt - lt;
+		depth += 8;
+
+		load_sort_keys(entries, count, depth, fold);
+	}
+
+	insertion_sort_entries(entries, count, depth, fold);
+}
+
+// 0 for strings that end before depth, otherwise the byte plus one, read from the key loaded at base
+inline std::size_t radix_digit(const sort_entry &entry, std::size_t depth, std::size_t base) noexcept
+{
+	if (depth >= entry.size)
+		return 0;
+
+	return ((entry.key >> (56 - 8 * (depth - base))) & 0xFF) + 1;
+}
+
+struct radix_task
+{
+	sort_entry *entries;
+	std::size_t count;
+	std::size_t depth;
+	std::size_t base;
+};
+
+// One counting pass at task.depth. Appends the buckets that still need sorting to out and returns true,
+// or returns false if every entry had the same digit, in which case the task just moves one byte deeper.
+inline bool radix_split(radix_task &task, sort_entry *scratch, bool fold, std::vector<radix_task> &out)
+{
+	if (task.depth - task.base == 8)
+	{
+		load_sort_keys(task.entries, task.count, task.depth, fold);
+		task.base = task.depth;
+	}
+
+	std::size_t counts[257] = {};
+
+	for (std::size_t i = 0; i < task.count; ++i)
+		++counts[radix_digit(task.entries[i], task.depth, task.base)];
+
+	for (std::size_t digit = 0; digit < 257; ++digit)
+	{
+		if (counts[digit] == task.count)
+		{
+			if (digit == 0)
+				task.count = 0;
+
+			++task.depth;
+			return false;
+		}
+	}
+
+	std::size_t starts[257];
+	std::size_t offset = 0;
+
+	for (std::size_t digit = 0; digit < 257; ++digit)
+	{
+		starts[digit] = offset;
+		offset += counts[digit];
+	}
+
+	for (std::size_t i = 0; i < task.count; ++i)
+		scratch[starts[radix_digit(task.entries[i], task.depth, task.base)]++] = task.entries[i];
+
+	std::memcpy(task.entries, scratch, task.count * sizeof(sort_entry));
+
+	// Bucket 0 is strings that ended here, which are all equal
+	offset = counts[0];
+
+	for (std::size_t digit = 1; digit < 257; ++digit)
+	{
+		if (counts[digit] > 1)
+			out.push_back({ task.entries + offset, counts[digit], task.depth + 1, task.base });
+
+		offset += counts[digit];
+	}
+
+	return true;
+}
+
+inline void radix_sort_entries(radix_task task, sort_entry *scratch, bool fold)
+{
+	std::vector<radix_task> pending { task };
+
+	while (!pending.empty())
+	{
+		radix_task current = pending.back();
+		pending.pop_back();
+
+		while (current.count >= sort_radix_threshold)
+		{
+			if (radix_split(current, scratch + (current.entries - task.entries), fold, pending))
+			{
+				current.count = 0;
+				break;
+			}
+		}
+
+		if (current.count > 1)
+		{
+			if (current.depth != current.base)
+				load_sort_keys(current.entries, current.count, current.depth, fold);
+
+			multikey_quicksort(current.entries, current.count, current.depth, fold);
+		}
+	}
+}
+
+inline unsigned sort_thread_count(const sort_options &options) noexcept
+{
+	const unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+	return std::max(1u, threads);
+}
+
+// Runs work(i) for every i in [0, count) on up to threads threads, taking indices in order
+template <typename Work>
+void parallel_for_each_index(std::size_t count, unsigned threads, Work work)
+{
+	std::atomic<std::size_t> next { 0 };
+
+	const auto worker = [&]
+	{
+		for (std::size_t i = next++; i < count; i = next++)
+			work(i);
+	};
+
+	std::vector<std::thread> pool;
+
+	for (unsigned i = 1; i < std::min<std::size_t>(threads, count); ++i)
+		pool.emplace_back(worker);
+
+	worker();
+
+	for (std::thread &thread : pool)
+		thread.join();
+}
+
+inline void parallel_radix_sort_entries(sort_entry *entries, std::size_t count, sort_entry *scratch, bool fold, unsigned threads)
+{
+	// Split sequentially until every piece is small enough to share out evenly, then sort the pieces in parallel
+	const std::size_t piece_size = std::max<std::size_t>(sort_parallel_threshold / 4, count / (threads * 8));
+
+	std::vector<radix_task> pieces;
+	std::vector<radix_task> splitting { { entries, count, 0, 0 } };
+
+	while (!splitting.empty())
+	{
+		radix_task task = splitting.back();
+		splitting.pop_back();
+
+		if (task.count < piece_size)
+		{
+			if (task.count > 1)
+				pieces.push_back(task);
+
+			continue;
+		}
+
+		while (task.count > 0 && !radix_split(task, scratch + (task.entries - entries), fold, splitting))
+		{
+		}
+	}
+
+	// Largest first so one big piece doesn't start last
+	std::sort(pieces.begin(), pieces.end(), [](const radix_task &lhs, const radix_task &rhs) { return lhs.count > rhs.count; });
+
+	parallel_for_each_index(pieces.size(), threads, [&](std::size_t i)
+	{
+		radix_sort_entries(pieces[i], scratch + (pieces[i].entries - entries), fold);
+	});
+}
+
+// "file2" < "file10": digit runs compare by value, ignoring leading zeros, and everything else byte by byte.
+// Strings that only differ in leading zeros or (when folding) case fall back to plain order so the result is total.
+inline bool natural_less(const std::string_view &lhs, const std::string_view &rhs, bool fold) noexcept
+{
+	const auto is_digit = [](char ch) { return ch >= '0' && ch <= '9'; };
+
+	// Skip the identical part, backing up to the start of a digit run so it's still compared as a number
+	const std::size_t common = std::min(lhs.size(), rhs.size());
+	std::size_t same = 0;
+
+	if (fold)
+	{
+		while (same < common && ascii_lower(lhs[same]) == ascii_lower(rhs[same]))
+			++same;
+	}
+	else
+	{
+		same = static_cast<std::size_t>(std::mismatch(lhs.begin(), lhs.begin() + common, rhs.begin()).first - lhs.begin());
+	}
+
+	while (same > 0 && is_digit(lhs[same - 1]))
+		--same;
+
+	std::size_t i = same;
+	std::size_t j = same;
+
+	while (i < lhs.size() && j < rhs.size())
+	{
+		if (is_digit(lhs[i]) && is_digit(rhs[j]))
+		{
+			while (i < lhs.size() && lhs[i] == '0') ++i;
+			while (j < rhs.size() && rhs[j] == '0') ++j;
+
+			std::size_t lhs_end = i;
+			std::size_t rhs_end = j;
+
+			while (lhs_end < lhs.size() && is_digit(lhs[lhs_end])) ++lhs_end;
+			while (rhs_end < rhs.size() && is_digit(rhs[rhs_end])) ++rhs_end;
+
+			if (lhs_end - i != rhs_end - j)
+				return lhs_end - i < rhs_end - j;
+
+			if (const int result = lhs.substr(i, lhs_end - i).compare(rhs.substr(j, rhs_end - j)))
+				return result < 0;
+
+			i = lhs_end;
+			j = rhs_end;
+			continue;
+		}
+
+		unsigned char a = static_cast<unsigned char>(lhs[i]);
+		unsigned char b = static_cast<unsigned char>(rhs[j]);
+
+		if (fold)
+		{
+			a = ascii_lower(a);
+			b = ascii_lower(b);
+		}
+
+		if (a != b)
+			return a < b;
+
+		++i;
+		++j;
+	}
+
+	if (lhs.size() - i != rhs.size() - j)
+		return lhs.size() - i < rhs.size() - j;
+
+	return lhs < rhs;
+}
+
+inline void sort_entries(sort_entry *entries, std::size_t count, bool fold, unsigned threads)
+{
+	std::vector<sort_entry> scratch(count);
+	load_sort_keys(entries, count, 0, fold);
+
+	if (threads > 1 && count >= sort_parallel_threshold)
+		parallel_radix_sort_entries(entries, count, scratch.data(), fold, threads);
+	else
+		radix_sort_entries({ entries, count, 0, 0 }, scratch.data(), fold);
+}
+
+// Rewrites str so plain byte order on the result is natural order. Each digit run becomes '0', the number of
+// significant digits, then the digits without leading zeros. A '0' can't appear anywhere else, and compares
+// against any other byte the same way the run's first digit would.
+inline void append_natural_key(std::string &out, const std::string_view &str, bool fold)
+{
+	const auto is_digit = [](char ch) { return ch >= '0' && ch <= '9'; };
+
+	for (std::size_t i = 0; i < str.size();)
+	{
+		if (!is_digit(str[i]))
+		{
+			out.push_back(fold ? ascii_lower(str[i]) : str[i]);
+			++i;
+			continue;
+		}
+
+		std::size_t end = i;
+		std::size_t significant = i;
+
+		while (end < str.size() && is_digit(str[end]))
+			++end;
+
+		while (significant < end && str[significant] == '0')
+			++significant;
+
+		const std::size_t digits = end - significant;
+
+		// Order preserving length: one byte below 255, otherwise 255 and 8 big-endian bytes
+		out.push_back('0');
+
+		if (digits < 255)
+		{
+			out.push_back(static_cast<char>(digits));
+		}
+		else
+		{
+			out.push_back(static_cast<char>(255));
+
+			for (int shift = 56; shift >= 0; shift -= 8)
+				out.push_back(static_cast<char>(static_cast<std::uint64_t>(digits) >> shift));
+		}
+
+		out.append(str.substr(significant, digits));
+		i = end;
+	}
+}
+
+// Radix sorts the natural keys, then orders strings whose keys tie (leading zeros, or case when folding)
+// with natural_less() on the originals
+inline void natural_sort_entries(sort_entry *entries, std::size_t count, bool fold, unsigned threads)
+{
+	std::vector<std::string_view> originals(count);
+	std::vector<std::size_t> key_offsets(count + 1);
+	std::string keys;
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		originals[entries[i].index] = std::string_view(entries[i].data, entries[i].size);
+		key_offsets[i] = keys.size();
+		append_natural_key(keys, originals[entries[i].index], fold);
+	}
+
+	key_offsets[count] = keys.size();
+
+	// Note: Pointers are only taken once the keys are done growing
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		entries[i].data = keys.data() + key_offsets[i];
+		entries[i].size = key_offsets[i + 1] - key_offsets[i];
+	}
+
+	sort_entries(entries, count, false, threads);
+
+	const auto key_of = [](const sort_entry &entry) { return std::string_view(entry.data, entry.size); };
+
+	for (std::size_t i = 0; i < count;)
+	{
+		std::size_t j = i + 1;
+
+		while (j < count && key_of(entries[j]) == key_of(entries[i]))
+			++j;
+
+		if (j - i > 1)
+		{
+			std::sort(entries + i, entries + j, [&](const sort_entry &lhs, const sort_entry &rhs)
+			{
+				return natural_less(originals[lhs.index], originals[rhs.index], fold);
+			});
+		}
+
+		i = j;
+	}
+}
+
+}
+
+// Sorts a random access range of anything convertible to std::string_view: spl::string, std::string,
+// std::string_view, spl::compact_string and so on. Orders by unsigned bytes like std::string_view's operator<
+// unless options say otherwise. Not stable.
+template <typename RandomIt>
+void sort_strings(RandomIt first, RandomIt last, const sort_options &options = {})
+{
+	using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+	const std::size_t count = static_cast<std::size_t>(std::distance(first, last));
+
+	if (count < 2)
+		return;
+
+	std::vector<detail::sort_entry> entries(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const std::string_view view = first[i];
+		entries[i] = { view.data(), view.size(), 0, i };
+	}
+
+	const unsigned threads = options.parallel ? detail::sort_thread_count(options) : 1;
+
+	if (options.natural)
+		detail::natural_sort_entries(entries.data(), count, options.case_insensitive, threads);
+	else
+		detail::sort_entries(entries.data(), count, options.case_insensitive, threads);
+
+	// Note: The entries point into the elements, so nothing can move until the order is final
+	std::vector<value_type> sorted;
+	sorted.reserve(count);
+
+	for (const detail::sort_entry &entry : entries)
+		sorted.push_back(std::move(first[entry.index]));
+
+	std::move(sorted.begin(), sorted.end(), first);
+}
+
+template <typename Range>
+void sort_strings(Range &range, const sort_options &options = {})
+{
+	sort_strings(std::begin(range), std::end(range), options);
+}
+
+}
@@ -0,0 +1,508 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+// Lookup tables for a fixed set of keys, built at compile time with a minimal perfect hash.
+//
+//	constexpr auto methods = spl::make_keyword_switch({ "GET", "HEAD", "POST", "PUT" });
+//
+//	switch (methods(name))
+//	{
+//	case methods("GET"): ...
+//	case methods("POST"): ...
+//	}
+//
+//	constexpr auto headers = spl::make_static_map_icase<int>({ { "Content-Length", 1 }, { "Host", 2 } });
+//	const int *id = headers.find("content-length");
+//
+// Every key gets its own slot in a table exactly as big as the key set, so a lookup is one hash, one table read
+// and one compare against the only key that could match. The hash splits keys into buckets of a few keys each,
+// and each bucket stores a displacement (d0, d1) that places its keys at (f1 + d0 * f2 + d1) % N, where f1 and f2
+// come from the same hash (CHD, Belazzougui et al.). Building places the biggest buckets first while the table is
+// still empty, and buckets with one key go straight into whatever slot is left.
+//
+// The keys are held as std::string_views, so they should be string literals or otherwise outlive the table.
+// Case-insensitive tables fold ASCII only.
+
+namespace spl
+{
+
+namespace detail
+{
+
+// std::to_array() from C++20
+template <typename T, std::size_t N, std::size_t... I>
+constexpr std::array<T, N> to_array(const T (&items)[N], std::index_sequence<I...>)
+{
+	return { { items[I]... } };
+}
+
+template <typename T, std::size_t N>
+constexpr std::array<T, N> to_array(const T (&items)[N])
+{
+	return to_array(items, std::make_index_sequence<N>());
+}
+
+// count bytes (at most 8) as a little-endian word
+constexpr std::uint64_t load_bytes(const char *str, std::size_t count) noexcept
+{
+	std::uint64_t word = 0;
+
+	for (std::size_t i = 0; i < count; ++i)
+		word |= std::uint64_t(static_cast<unsigned char>(str[i])) << (i * 8);
+
+	return word;
+}
+
+// Same as load_bytes(), but with at most two loads at runtime instead of a loop
+constexpr std::uint64_t load_word(const char *str, std::size_t count) noexcept
+{
+	if (count >= 8)
+	{
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+		if (!is_constant_evaluated())
+		{
+			std::uint64_t word = 0;
+			std::memcpy(&word, str, 8);
+			return word;
+		}
+#endif
+		return load_bytes(str, 8);
+	}
+
+	// Note: The two halves overlap for 5 to 7 bytes, and the overlapping bytes are the same in both
+	if (count >= 4)
+		return load_bytes(str, 4) | load_bytes(str + count - 4, 4) << ((count - 4) * 8);
+
+	if (count > 0)
+		return load_bytes(str, 1) | load_bytes(str + count / 2, 1) << (count / 2 * 8) | load_bytes(str + count - 1, 1) << ((count - 1) * 8);
+
+	return 0;
+}
+
+// ASCII lowercase of 8 bytes at once, leaving everything else alone
+constexpr std::uint64_t ascii_lower_word(std::uint64_t word) noexcept
+{
+	constexpr std::uint64_t ones = 0x0101010101010101ull;
+
+	const std::uint64_t ascii = word & (0x7F * ones);
+	const std::uint64_t at_least_a = ascii + (0x80 - 'A') * ones;
+	const std::uint64_t past_z = ascii + (0x80 - 'Z' - 1) * ones;
+	const std::uint64_t upper = at_least_a & ~past_z & ~word & (0x80 * ones);
+
+	return word | (upper >> 2);
+}
+
+constexpr std::uint64_t mix64(std::uint64_t hash) noexcept
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+template <bool CaseInsensitive>
+constexpr std::uint64_t keyword_word(const char *str, std::size_t count) noexcept
+{
+	const std::uint64_t word = load_word(str, count);
+	return CaseInsensitive ? ascii_lower_word(word) : word;
+}
+
+template <bool CaseInsensitive>
+constexpr std::uint64_t keyword_hash(const std::string_view &key, std::uint64_t seed) noexcept
+{
+	std::uint64_t hash = seed ^ (key.size() * 0x9E3779B97F4A7C15ull);
+	std::size_t i = 0;
+
+	for (; i + 8 <= key.size(); i += 8)
+		hash = (hash ^ keyword_word<CaseInsensitive>(key.data() + i, 8)) * 0x87C37B91114253D5ull;
+
+	// Note: The length is already mixed in, so zero padding can't make two keys collide
+	if (i < key.size())
+		hash = (hash ^ keyword_word<CaseInsensitive>(key.data() + i, key.size() - i)) * 0x87C37B91114253D5ull;
+
+	return mix64(hash);
+}
+
+template <bool CaseInsensitive>
+constexpr bool keyword_equal(const std::string_view &lhs, const std::string_view &rhs) noexcept
+{
+	if constexpr (!CaseInsensitive)
+	{
+		return lhs == rhs;
+	}
+	else
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+
+		for (std::size_t i = 0; i < lhs.size(); i += 8)
+		{
+			const std::size_t count = std::min<std::size_t>(8, lhs.size() - i);
+
+			if (keyword_word<true>(lhs.data() + i, count) != keyword_word<true>(rhs.data() + i, count))
+				return false;
+		}
+
+		return true;
+	}
+}
+
+}
+
+template <std::size_t N, bool CaseInsensitive = false>
+class keyword_switch
+{
+public:
+
+	using size_type = std::size_t;
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+	// Throws std::invalid_argument on duplicate keys, which is a compile error when built in a constant expression
+	constexpr explicit keyword_switch(const std::array<std::string_view, N> &keys)
+	{
+		build(keys);
+	}
+
+	// Index of key in the list the switch was built from, or npos
+	constexpr size_type find(const std::string_view &key) const noexcept
+	{
+		const size_type slot = slot_of(key);
+		return slot == npos ? npos : mIndices[slot];
+	}
+
+	constexpr size_type operator()(const std::string_view &key) const noexcept { return find(key); }
+
+	constexpr bool contains(const std::string_view &key) const noexcept { return slot_of(key) != npos; }
+
+	constexpr static size_type size() noexcept { return N; }
+	constexpr static bool case_insensitive() noexcept { return CaseInsensitive; }
+
+	// The key at index in the original list
+	constexpr std::string_view key(size_type index) const { return mKeys[mSlots[index]]; }
+
+	// Slot key lives in, or npos. Slots run from 0 to size() - 1, in no particular order.
+	constexpr size_type slot_of(const std::string_view &key) const noexcept
+	{
+		if constexpr (N == 0)
+		{
+			return npos;
+		}
+		else
+		{
+			const std::uint64_t hash = detail::keyword_hash<CaseInsensitive>(key, mSeed);
+			const displacement &d = mDisplacements[bucket(hash)];
+			const size_type slot = position(hash, d.d0, d.d1);
+
+			return detail::keyword_equal<CaseInsensitive>(mKeys[slot], key) ? slot : npos;
+		}
+	}
+
+	// Index in the original list of the key in slot
+	constexpr size_type index_of_slot(size_type slot) const { return mIndices[slot]; }
+
+private:
+
+	// About four keys per bucket keeps the displacement table small without making the search slow
+	constexpr static size_type bucket_count = N / 4 + 1;
+
+	// How many displacements a bucket tries per seed before the whole build starts over with the next one
+	constexpr static size_type max_d0 = 32;
+	constexpr static size_type max_seeds = 64;
+
+	struct displacement
+	{
+		std::uint32_t d0 = 0;
+		std::uint32_t d1 = 0;
+	};
+
+	constexpr static size_type bucket(std::uint64_t hash) noexcept
+	{
+		// Note: Multiply-shift instead of % spreads the top 32 bits over the buckets without a division
+		return static_cast<size_type>(((hash >> 32) * bucket_count) >> 32);
+	}
+
+	constexpr static std::uint64_t f1(std::uint64_t hash) noexcept { return static_cast<std::uint32_t>(hash); }
+	constexpr static std::uint64_t f2(std::uint64_t hash) noexcept { return (hash * 0x9E3779B97F4A7C15ull) >> 32; }
+
+	constexpr static size_type position(std::uint64_t hash, std::uint64_t d0, std::uint64_t d1) noexcept
+	{
+		return static_cast<size_type>((f1(hash) + d0 * f2(hash) + d1) % N);
+	}
+
+	constexpr void build(const std::array<std::string_view, N> &keys)
+	{
+		if constexpr (N > 0)
+		{
+			for (size_type attempt = 0; attempt < max_seeds; ++attempt)
+			{
+				if (try_build(keys, detail::mix64(attempt + 1)))
+					return;
+			}
+
+			throw std::logic_error("couldn't build a perfect hash for these keys");
+		}
+	}
+
+	constexpr bool try_build(const std::array<std::string_view, N> &keys, std::uint64_t seed)
+	{
+		std::array<std::uint64_t, N> hashes = {};
+		std::array<size_type, bucket_count + 1> starts = {};
+
+		for (size_type i = 0; i < N; ++i)
+		{
+			hashes[i] = detail::keyword_hash<CaseInsensitive>(keys[i], seed);
+			++starts[bucket(hashes[i]) + 1];
+		}
+
+		for (size_type b = 0; b < bucket_count; ++b)
+			starts[b + 1] += starts[b];
+
+		// Keys grouped by bucket
+		std::array<size_type, N> members = {};
+		std::array<size_type, bucket_count> filled = {};
+
+		for (size_type i = 0; i < N; ++i)
+		{
+			const size_type b = bucket(hashes[i]);
+			members[starts[b] + filled[b]++] = i;
+		}
+
+		// Buckets from biggest to smallest, by counting sort on size
+		size_type largest = 0;
+
+		for (size_type b = 0; b < bucket_count; ++b)
+			largest = std::max(largest, filled[b]);
+
+		std::array<size_type, bucket_count> order = {};
+		size_type ordered = 0;
+
+		for (size_type size = largest; size > 0; --size)
+		{
+			for (size_type b = 0; b < bucket_count; ++b)
+			{
+				if (filled[b] == size)
+					order[ordered++] = b;
+			}
+		}
+
+		std::array<bool, N> taken = {};
+		std::array<displacement, bucket_count> displacements = {};
+		size_type next_free = 0;
+
+		for (size_type o = 0; o < ordered; ++o)
+		{
+			const size_type b = order[o];
+			const size_type first = starts[b];
+			const size_type count = filled[b];
+
+			if (count == 1)
+			{
+				// Note: With d0 = 0, d1 alone can put a single key anywhere
+				while (taken[next_free])
+					++next_free;
+
+				const std::uint64_t h = hashes[members[first]];
+
+				displacements[b] = { 0, static_cast<std::uint32_t>((next_free + N - f1(h) % N) % N) };
+				taken[next_free] = true;
+				continue;
+			}
+
+			bool placed = false;
+
+			for (std::uint64_t d0 = 0; d0 < max_d0 && !placed; ++d0)
+			{
+				for (std::uint64_t d1 = 0; d1 < N && !placed; ++d1)
+				{
+					placed = true;
+
+					for (size_type i = 0; i < count && placed; ++i)
+					{
+						const size_type slot = position(hashes[members[first + i]], d0, d1);
+
+						if (taken[slot])
+						{
+							placed = false;
+						}
+						else
+						{
+							for (size_type j = 0; j < i; ++j)
+							{
+								if (position(hashes[members[first + j]], d0, d1) == slot)
+								{
+									placed = false;
+									break;
+								}
+							}
+						}
+					}
+
+					if (placed)
+					{
+						displacements[b] = { static_cast<std::uint32_t>(d0), static_cast<std::uint32_t>(d1) };
+
+						for (size_type i = 0; i < count; ++i)
+							taken[position(hashes[members[first + i]], d0, d1)] = true;
+					}
+				}
+			}
+
+			if (!placed)
+			{
+				// Two keys that hash the same can never be separated, and if they're equal no seed will help
+				for (size_type i = 0; i < count; ++i)
+				{
+					for (size_type j = 0; j < i; ++j)
+					{
+						if (detail::keyword_equal<CaseInsensitive>(keys[members[first + i]], keys[members[first + j]]))
+							throw std::invalid_argument("duplicate key");
+					}
+				}
+
+				return false;
+			}
+		}
+
+		mSeed = seed;
+		mDisplacements = displacements;
+
+		for (size_type i = 0; i < N; ++i)
+		{
+			const std::uint64_t h = hashes[i];
+			const displacement &d = displacements[bucket(h)];
+			const size_type slot = position(h, d.d0, d.d1);
+
+			mKeys[slot] = keys[i];
+			mIndices[slot] = i;
+			mSlots[i] = slot;
+		}
+
+		return true;
+	}
+
+	std::uint64_t mSeed = 0;
+	std::array<displacement, bucket_count> mDisplacements = {};
+	std::array<std::string_view, N> mKeys = {};    // By slot
+	std::array<size_type, N> mIndices = {};        // Original index of the key in each slot
+	std::array<size_type, N> mSlots = {};          // Slot of each original index
+};
+
+// Maps a fixed set of keys to values, with a keyword_switch to find the slot. V has to be default constructible.
+template <typename V, std::size_t N, bool CaseInsensitive = false>
+class static_map
+{
+public:
+
+	using size_type = std::size_t;
+	using value_type = V;
+
+	constexpr explicit static_map(const std::array<std::pair<std::string_view, V>, N> &entries) :
+		mSwitch(keys_of(entries))
+	{
+		for (size_type i = 0; i < N; ++i)
+			mValues[mSwitch.slot_of(entries[i].first)] = entries[i].second;
+	}
+
+	// The value for key, or nullptr
+	constexpr const V *find(const std::string_view &key) const noexcept
+	{
+		const size_type slot = mSwitch.slot_of(key);
+		return slot == keyword_switch<N, CaseInsensitive>::npos ? nullptr : &mValues[slot];
+	}
+
+	constexpr const V &at(const std::string_view &key) const
+	{
+		const V *value = find(key);
+
+		if (!value)
+			throw std::out_of_range("invalid key");
+
+		return *value;
+	}
+
+	constexpr V value_or(const std::string_view &key, const V &fallback) const
+	{
+		const V *value = find(key);
+		return value ? *value : fallback;
+	}
+
+	constexpr bool contains(const std::string_view &key) const noexcept { return mSwitch.contains(key); }
+
+	constexpr static size_type size() noexcept { return N; }
+	constexpr static bool case_insensitive() noexcept { return CaseInsensitive; }
+
+	// Index of key in the list the map was built from, or keyword_switch::npos
+	constexpr size_type index_of(const std::string_view &key) const noexcept { return mSwitch.find(key); }
+
+	constexpr const keyword_switch<N, CaseInsensitive> &keys() const noexcept { return mSwitch; }
+
+private:
+
+	constexpr static std::array<std::string_view, N> keys_of(const std::array<std::pair<std::string_view, V>, N> &entries)
+	{
+		std::array<std::string_view, N> keys = {};
+
+		for (size_type i = 0; i < N; ++i)
+			keys[i] = entries[i].first;
+
+		return keys;
+	}
+
+	keyword_switch<N, CaseInsensitive> mSwitch;
+	std::array<V, N> mValues = {};    // By slot
+};
+
+template <std::size_t N>
+constexpr keyword_switch<N> make_keyword_switch(const std::string_view (&keys)[N])
+{
+	return keyword_switch<N>(detail::to_array(keys));
+}
+
+template <std::size_t N>
+constexpr keyword_switch<N, true> make_keyword_switch_icase(const std::string_view (&keys)[N])
+{
+	return keyword_switch<N, true>(detail::to_array(keys));
+}
+
+template <typename V, std::size_t N>
+constexpr static_map<V, N> make_static_map(const std::pair<std::string_view, V> (&entries)[N])
+{
+	return static_map<V, N>(detail::to_array(entries));
+}
+
+template <typename V, std::size_t N>
+constexpr static_map<V, N, true> make_static_map_icase(const std::pair<std::string_view, V> (&entries)[N])
+{
+	return static_map<V, N, true>(detail::to_array(entries));
+}
+
+}
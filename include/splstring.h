@@ -32,17 +32,59 @@
 #include <cstring>
 #include <charconv>
 #include <vector>
+#include <iterator>
+#include <initializer_list>
 #include <array>
 #include <limits>
 #include <filesystem>
 #include <type_traits>
+#include <utility>
+#include <cstdint>
+
+#include "splcasetables.h"
+
+#if defined(SPL_STRING_POOLED_STORAGE)
+	#include "splbufferpool.h"
+#endif
+
+#if defined(__AVX2__)
+	#define SPL_STRING_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SPL_STRING_SSE2 1
+	#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+#if defined(__cpp_lib_is_constant_evaluated)
+	#define SPL_STRING_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__has_builtin)
+	#if __has_builtin(__builtin_is_constant_evaluated)
+		#define SPL_STRING_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+	#endif
+#endif
+
+#if !defined(SPL_STRING_IS_CONSTANT_EVALUATED) && defined(_MSC_VER) && _MSC_VER >= 1925
+	#define SPL_STRING_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+// Lets a function use instructions beyond the compiler's baseline so it can be picked at runtime
+#if defined(SPL_STRING_SSE2) && (defined(__GNUC__) || defined(__clang__))
+	#define SPL_STRING_TARGET(isa) __attribute__((target(isa)))
+#else
+	#define SPL_STRING_TARGET(isa)
+#endif
 
 namespace spl
 {
 
 // Note: When searching for substrings, this can be significantly faster than
 // std::char_traits<char>::compare() on optimized/release builds, but slower on debug builds.
-inline bool compare_equal(const char *str1, const char *str2, std::size_t size)
+constexpr bool compare_equal(const char *str1, const char *str2, std::size_t size)
 {
 	for (std::size_t i = 0; i < size; ++i)
 	{
@@ -53,1103 +95,2863 @@ inline bool compare_equal(const char *str1, const char *str2, std::size_t size)
 	return true;
 }
 
-class string
+namespace detail
 {
-	struct buffer_deleter
-	{
-		void operator()(char memory[])
-		{
-			std::free(memory);
-		}
-	};
 
-public:
+// True while being evaluated at compile time, so constexpr functions can switch to their SIMD or libc paths at runtime.
+// Without compiler support this is always true and the constexpr-friendly path is used everywhere.
+constexpr bool is_constant_evaluated() noexcept
+{
+#if defined(SPL_STRING_IS_CONSTANT_EVALUATED)
+	return SPL_STRING_IS_CONSTANT_EVALUATED();
+#else
+	return true;
+#endif
+}
 
-	enum struct split_side
-	{
-		left,
-		right
-	};
+inline unsigned count_trailing_zeros(std::uint32_t mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
 
-	struct iterator_base
+inline unsigned count_trailing_zeros64(std::uint64_t mask)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return index;
+#elif defined(_MSC_VER)
+	const std::uint32_t low = static_cast<std::uint32_t>(mask);
+	return low ? count_trailing_zeros(low) : 32 + count_trailing_zeros(static_cast<std::uint32_t>(mask >> 32));
+#else
+	return __builtin_ctzll(mask);
+#endif
+}
+
+inline unsigned count_leading_zeros(std::uint32_t mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return 31 - index;
+#else
+	return __builtin_clz(mask);
+#endif
+}
+
+// A set of bytes for trimming and similar scans. Small sets are also kept as a list
+// so blocks of input can be tested with one SIMD compare per member.
+struct char_set
+{
+	static constexpr std::size_t max_simd_chars = 8;
+
+	constexpr explicit char_set(const std::string_view &chars)
 	{
-		using iterator_category = std::input_iterator_tag;
-		using value_type = char;
-		using difference_type = ptrdiff_t;
-		using pointer = char*;
-		using reference = char&;
+		for (const char ch : chars)
+		{
+			const unsigned char uch = static_cast<unsigned char>(ch);
 
-		iterator_base(char *begin) noexcept : mCurrent(begin) {}
-		iterator_base(const iterator_base &it) noexcept : mCurrent(it.mCurrent) {}
+			if (contains(ch))
+				continue;
 
-		bool operator==(const iterator_base &rhs) const noexcept { return mCurrent == rhs.mCurrent; }
-		bool operator!=(const iterator_base &rhs) const noexcept { return mCurrent != rhs.mCurrent; }
+			bits[uch / 64] |= std::uint64_t(1) << (uch % 64);
 
-		char &operator*() { return *mCurrent; }
-		const char &operator*() const { return *mCurrent; }
+			if (list_size < max_simd_chars)
+				list[list_size] = ch;
 
-	protected:
-		char *mCurrent;
-	};
+			++list_size;
+		}
+	}
 
-	struct iterator : iterator_base
+	constexpr bool contains(char ch) const noexcept
 	{
-		using iterator_base::iterator_base;
+		const unsigned char uch = static_cast<unsigned char>(ch);
+		return (bits[uch / 64] >> (uch % 64)) & 1;
+	}
 
-		iterator &operator++() noexcept
-		{
-			++mCurrent;
-			return *this;
-		}
+	constexpr bool simd_friendly() const noexcept { return list_size <= max_simd_chars; }
 
-		iterator &operator--() noexcept
-		{
-			--mCurrent;
-			return *this;
-		}
+	std::uint64_t bits[4] = {};
+	char list[max_simd_chars] = {};
+	std::size_t list_size = 0;
+};
 
-		iterator operator++(int)
-		{
-			iterator retval = *this;
-			++(*this);
+// Note: Matches std::isspace() in the "C" locale
+inline constexpr std::string_view whitespace_chars = " \t\n\v\f\r";
 
-			return retval;
-		}
+inline const char_set &whitespace_set()
+{
+	static const char_set set(whitespace_chars);
+	return set;
+}
 
-		iterator operator--(int)
-		{
-			iterator retval = *this;
-			--(*this);
+#if defined(SPL_STRING_AVX2)
+inline std::uint32_t char_set_mask(__m256i block, const char_set &set)
+{
+	__m256i matches = _mm256_setzero_si256();
 
-			return retval;
-		}
+	for (std::size_t i = 0; i < set.list_size; ++i)
+		matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(set.list[i])));
 
-		friend iterator operator+(const iterator &lhs, difference_type count)
-		{
-			iterator retval = lhs;
-			retval.mCurrent += count;
+	return static_cast<std::uint32_t>(_mm256_movemask_epi8(matches));
+}
+#endif
 
-			return retval;
-		}
+#if defined(SPL_STRING_SSE2)
+inline std::uint32_t char_set_mask(__m128i block, const char_set &set)
+{
+	__m128i matches = _mm_setzero_si128();
 
-		friend iterator operator-(const iterator &lhs, difference_type count)
-		{
-			iterator retval = lhs;
-			retval.mCurrent -= count;
+	for (std::size_t i = 0; i < set.list_size; ++i)
+		matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(set.list[i])));
 
-			return retval;
-		}
+	return static_cast<std::uint32_t>(_mm_movemask_epi8(matches));
+}
+#endif
 
-		bool operator<(const iterator &rhs) const noexcept { return mCurrent < rhs.mCurrent; }
-		bool operator<=(const iterator &rhs) const noexcept { return mCurrent <= rhs.mCurrent; }
-		bool operator>(const iterator &rhs) const noexcept { return mCurrent > rhs.mCurrent; }
-		bool operator>=(const iterator &rhs) const noexcept { return mCurrent >= rhs.mCurrent; }
-	};
+// Number of leading bytes of str that are in set
+inline std::size_t span_of(const char *str, std::size_t size, const char_set &set)
+{
+	std::size_t i = 0;
 
-	struct reverse_iterator : iterator_base
+	if (set.simd_friendly())
 	{
-		using iterator_base::iterator_base;
-
-		reverse_iterator &operator++() noexcept
+#if defined(SPL_STRING_AVX2)
+		for (; i + 32 <= size; i += 32)
 		{
-			--mCurrent;
-			return *this;
-		}
+			const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+			const std::uint32_t mask = char_set_mask(block, set);
 
-		reverse_iterator &operator--() noexcept
-		{
-			++mCurrent;
-			return *this;
+			if (mask != 0xFFFFFFFFu)
+				return i + count_trailing_zeros(~mask);
 		}
-
-		reverse_iterator operator++(int)
+#endif
+#if defined(SPL_STRING_SSE2)
+		for (; i + 16 <= size; i += 16)
 		{
-			reverse_iterator retval = *this;
-			++(*this);
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+			const std::uint32_t mask = char_set_mask(block, set);
 
-			return retval;
+			if (mask != 0xFFFFu)
+				return i + count_trailing_zeros(~mask & 0xFFFFu);
 		}
+#endif
+	}
 
-		reverse_iterator operator--(int)
-		{
-			reverse_iterator retval = *this;
-			--(*this);
+	for (; i < size; ++i)
+	{
+		if (!set.contains(str[i]))
+			return i;
+	}
 
-			return retval;
-		}
+	return size;
+}
 
-		friend reverse_iterator operator+(const reverse_iterator &lhs, difference_type count)
+// Number of trailing bytes of str that are in set
+inline std::size_t rspan_of(const char *str, std::size_t size, const char_set &set)
+{
+	std::size_t remaining = size;
+
+	if (set.simd_friendly())
+	{
+#if defined(SPL_STRING_AVX2)
+		for (; remaining >= 32; remaining -= 32)
 		{
-			reverse_iterator retval = lhs;
-			retval.mCurrent -= count;
+			const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + remaining - 32));
+			const std::uint32_t mask = char_set_mask(block, set);
 
-			return retval;
+			if (mask != 0xFFFFFFFFu)
+				return size - remaining + count_leading_zeros(~mask);
 		}
-
-		friend reverse_iterator operator-(const reverse_iterator &lhs, difference_type count)
+#endif
+#if defined(SPL_STRING_SSE2)
+		for (; remaining >= 16; remaining -= 16)
 		{
-			reverse_iterator retval = lhs;
-			retval.mCurrent += count;
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + remaining - 16));
+			const std::uint32_t mask = char_set_mask(block, set);
 
-			return retval;
+			if (mask != 0xFFFFu)
+				return size - remaining + count_leading_zeros((~mask & 0xFFFFu) << 16);
 		}
+#endif
+	}
 
-		bool operator<(const reverse_iterator &rhs) const noexcept { return mCurrent > rhs.mCurrent; }
-		bool operator<=(const reverse_iterator &rhs) const noexcept { return mCurrent >= rhs.mCurrent; }
-		bool operator>(const reverse_iterator &rhs) const noexcept { return mCurrent < rhs.mCurrent; }
-		bool operator>=(const reverse_iterator &rhs) const noexcept { return mCurrent <= rhs.mCurrent; }
-	};
+	for (; remaining > 0; --remaining)
+	{
+		if (!set.contains(str[remaining - 1]))
+			return size - remaining;
+	}
 
-	using const_iterator = iterator;
-	using const_reverse_iterator = reverse_iterator;
+	return size;
+}
 
-	using reference = char&;
-	using const_reference = const char&;
+constexpr std::string_view trimmed_view(const std::string_view &view, const char_set &set, bool left, bool right)
+{
+	std::size_t first = 0;
+	std::size_t last = view.size();
 
-	using size_type = std::size_t;
+	if (is_constant_evaluated())
+	{
+		while (left && first < last && set.contains(view[first]))
+			++first;
 
-	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+		while (right && first < last && set.contains(view[last - 1]))
+			--last;
+	}
+	else
+	{
+		if (left)
+			first = span_of(view.data(), view.size(), set);
 
-	inline string();
+		if (right && first < last)
+			last -= rspan_of(view.data() + first, last - first, set);
+	}
 
-	inline string(size_type count, char ch);
+	return view.substr(first, last - first);
+}
 
-	inline string(string &&other) noexcept;
-	inline string(const string &other);
-	inline string(const std::string &str);
-	inline string(const std::string_view &sv);
-	inline string(const char *str);
-	inline string(const char *str, size_type count);
+constexpr std::string_view whitespace_trimmed_view(const std::string_view &view, bool left, bool right)
+{
+	if (is_constant_evaluated())
+		return trimmed_view(view, char_set(whitespace_chars), left, right);
 
-	inline string(const std::string_view &sv, size_type pos, size_type n);
+	return trimmed_view(view, whitespace_set(), left, right);
+}
 
-private:
+}
 
-	void allocate(size_type new_size)
-	{
-		mBuffer.reset((char*)std::malloc(new_size));
-	}
+namespace detail
+{
 
-	void reallocate(size_type new_size)
-	{
-		mBuffer.reset((char*)std::realloc(mBuffer.release(), new_size));
-	}
+inline unsigned popcount(std::uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcount(value);
+#else
+	value = value - ((value >> 1) & 0x55555555u);
+	value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+	return (((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+#endif
+}
 
-public:
+#if defined(SPL_STRING_SSE2)
+struct cpu_features
+{
+	bool ssse3 = false;
+	bool avx2 = false;
+};
 
-	string &operator=(const string &rhs)
-	{
-		if (&rhs == this)
-			return *this;
+inline cpu_features detect_cpu_features()
+{
+	cpu_features features;
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+	features.ssse3 = (info[2] & (1 << 9)) != 0;
 
-		mLength = rhs.mLength;
-		
-		reallocate(mLength + 1);
-		mBuffer[mLength] = '\0';
+	// Note: AVX2 also needs the OS to save the YMM registers on context switches
+	const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
 
-		std::memcpy(mBuffer.get(), rhs.data(), mLength);
+	__cpuidex(info, 7, 0);
+	features.avx2 = os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+	features.ssse3 = __builtin_cpu_supports("ssse3");
+	features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+	return features;
+}
 
-		return *this;
-	}
+inline const cpu_features &cpu()
+{
+	static const cpu_features features = detect_cpu_features();
+	return features;
+}
+#endif
 
-	string &operator=(string &&rhs) noexcept
+// Decodes one code point, or returns U+FFFD and a length of 1 for an invalid sequence
+inline char32_t decode_utf8(const char *str, std::size_t size, std::size_t &length)
+{
+	constexpr char32_t replacement = 0xFFFD;
+	const auto byte = [str](std::size_t i) { return static_cast<unsigned char>(str[i]); };
+	const auto continuation = [&](std::size_t i) { return i < size && (byte(i) & 0xC0) == 0x80; };
+
+	length = 1;
+	const unsigned char lead = byte(0);
+
+	if (lead < 0x80)
+		return lead;
+
+	if (lead >= 0xC2 && lead <= 0xDF)
 	{
-		mLength = std::exchange(rhs.mLength, 0);
-		mBuffer = std::move(rhs.mBuffer);
+		if (!continuation(1))
+			return replacement;
 
-		return *this;
+		length = 2;
+		return (char32_t(lead & 0x1F) << 6) | (byte(1) & 0x3F);
 	}
 
-	reference at(size_type pos)
+	if (lead >= 0xE0 && lead <= 0xEF)
 	{
-		if (pos >= size())
-			throw std::out_of_range("invalid string position");
+		if (!continuation(1) || !continuation(2))
+			return replacement;
 
-		return mBuffer[pos];
+		const char32_t cp = (char32_t(lead & 0x0F) << 12) | (char32_t(byte(1) & 0x3F) << 6) | (byte(2) & 0x3F);
+
+		// Overlong encodings and UTF-16 surrogates
+		if (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))
+			return replacement;
+
+		length = 3;
+		return cp;
 	}
 
-	const_reference at(size_type pos) const
+	if (lead >= 0xF0 && lead <= 0xF4)
 	{
-		if (pos >= size())
-			throw std::out_of_range("invalid string position");
+		if (!continuation(1) || !continuation(2) || !continuation(3))
+			return replacement;
 
-		return mBuffer[pos];
+		const char32_t cp = (char32_t(lead & 0x07) << 18) | (char32_t(byte(1) & 0x3F) << 12) |
+			(char32_t(byte(2) & 0x3F) << 6) | (byte(3) & 0x3F);
+
+		if (cp < 0x10000 || cp > 0x10FFFF)
+			return replacement;
+
+		length = 4;
+		return cp;
 	}
 
-	reference operator[](size_type pos)
+	return replacement;
+}
+
+inline bool is_ascii_scalar(const char *str, std::size_t size)
+{
+	std::size_t i = 0;
+
+	for (; i + 8 <= size; i += 8)
 	{
-		return mBuffer[pos];
+		std::uint64_t word;
+		std::memcpy(&word, str + i, sizeof(word));
+
+		if (word & 0x8080808080808080ull)
+			return false;
 	}
 
-	const_reference operator[](size_type pos) const
+	for (; i < size; ++i)
 	{
-		return mBuffer[pos];
+		if (static_cast<unsigned char>(str[i]) & 0x80)
+			return false;
 	}
 
-	char &front()
-	{
-		return mBuffer[0];
-	}
-
-	const char &front() const
-	{
-		return mBuffer[0];
-	}
-
-	char &back()
-	{
-		return mBuffer[size() - 1];
-	}
+	return true;
+}
 
-	const char &back() const
-	{
-		return mBuffer[size() - 1];
-	}
+inline bool validate_utf8_scalar(const char *str, std::size_t size)
+{
+	std::size_t i = 0;
 
-	bool operator==(const string &rhs) const noexcept
+	while (i < size)
 	{
-		const size_type lhs_sz = size();
-		const size_type rhs_sz = rhs.size();
+		// Skip ASCII a word at a time
+		if (i + 8 <= size && is_ascii_scalar(str + i, 8))
+		{
+			i += 8;
+			continue;
+		}
 
-		if (lhs_sz != rhs_sz)
+		std::size_t length;
+		if (decode_utf8(str + i, size - i, length) == 0xFFFD && length == 1)
+		{
+			// Note: A literal U+FFFD is three bytes long, so a length of 1 always means an error
 			return false;
+		}
 
-		return std::char_traits<char>::compare(data(), rhs.data(), size()) == 0;
+		i += length;
 	}
 
-	bool operator==(const std::string &rhs) const noexcept
-	{
-		const size_type lhs_sz = size();
-		const size_type rhs_sz = rhs.size();
-
-		if (lhs_sz != rhs_sz)
-			return false;
-
-		return std::char_traits<char>::compare(data(), rhs.data(), size()) == 0;
-	}
+	return true;
+}
 
-	friend bool operator==(const std::string &lhs, const string &rhs)
-	{
-		const size_type lhs_sz = lhs.size();
-		const size_type rhs_sz = rhs.size();
+#if defined(SPL_STRING_SSE2)
 
-		if (lhs_sz != rhs_sz)
-			return false;
+// Vectorized validation after Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+// Each byte is classified by the high nibble of its predecessor, the low nibble of its predecessor and its own
+// high nibble; the AND of three table lookups is non-zero only for invalid 2-byte windows.
+namespace utf8_error
+{
+	constexpr std::uint8_t too_short = 1 << 0;
+	constexpr std::uint8_t too_long = 1 << 1;
+	constexpr std::uint8_t overlong_3 = 1 << 2;
+	constexpr std::uint8_t too_large = 1 << 3;
+	constexpr std::uint8_t surrogate = 1 << 4;
+	constexpr std::uint8_t overlong_2 = 1 << 5;
+	constexpr std::uint8_t too_large_1000 = 1 << 6;
+	constexpr std::uint8_t overlong_4 = 1 << 6;
+	constexpr std::uint8_t two_conts = 1 << 7;
+	constexpr std::uint8_t carry = too_short | too_long | two_conts;
+}
 
-		return std::char_traits<char>::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
-	}
+inline constexpr std::uint8_t utf8_byte_1_high[16] = {
+	utf8_error::too_long, utf8_error::too_long, utf8_error::too_long, utf8_error::too_long,
+	utf8_error::too_long, utf8_error::too_long, utf8_error::too_long, utf8_error::too_long,
+	utf8_error::two_conts, utf8_error::two_conts, utf8_error::two_conts, utf8_error::two_conts,
+	utf8_error::too_short | utf8_error::overlong_2,
+	utf8_error::too_short,
+	utf8_error::too_short | utf8_error::overlong_3 | utf8_error::surrogate,
+	utf8_error::too_short | utf8_error::too_large | utf8_error::too_large_1000 | utf8_error::overlong_4
+};
 
-	bool operator==(const std::string_view &rhs) const noexcept
-	{
-		const size_type lhs_sz = size();
-		const size_type rhs_sz = rhs.size();
+inline constexpr std::uint8_t utf8_byte_1_low[16] = {
+	utf8_error::carry | utf8_error::overlong_3 | utf8_error::overlong_2 | utf8_error::overlong_4,
+	utf8_error::carry | utf8_error::overlong_2,
+	utf8_error::carry,
+	utf8_error::carry,
+	utf8_error::carry | utf8_error::too_large,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000 | utf8_error::surrogate,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+	utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000
+};
 
-		if (lhs_sz != rhs_sz)
-			return false;
+inline constexpr std::uint8_t utf8_byte_2_high[16] = {
+	utf8_error::too_short, utf8_error::too_short, utf8_error::too_short, utf8_error::too_short,
+	utf8_error::too_short, utf8_error::too_short, utf8_error::too_short, utf8_error::too_short,
+	utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::overlong_3 | utf8_error::too_large_1000 | utf8_error::overlong_4,
+	utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::overlong_3 | utf8_error::too_large,
+	utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::surrogate | utf8_error::too_large,
+	utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::surrogate | utf8_error::too_large,
+	utf8_error::too_short, utf8_error::too_short, utf8_error::too_short, utf8_error::too_short
+};
 
-		return std::char_traits<char>::compare(data(), rhs.data(), size()) == 0;
-	}
+SPL_STRING_TARGET("ssse3")
+inline __m128i utf8_block_errors_ssse3(__m128i input, __m128i prev_input)
+{
+	const __m128i byte_1_high_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_high));
+	const __m128i byte_1_low_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_low));
+	const __m128i byte_2_high_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8_byte_2_high));
+	const __m128i low_nibble = _mm_set1_epi8(0x0F);
+
+	const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+	const __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+	const __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, low_nibble));
+	const __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+	const __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+	// Bytes two or three positions after a 3 or 4 byte lead must be continuations
+	const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+	const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+	const __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xE0 - 0x80)));
+	const __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xF0 - 0x80)));
+	const __m128i must_be_continuation = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(char(0x80)));
+
+	return _mm_xor_si128(must_be_continuation, special_cases);
+}
 
-	friend bool operator==(const std::string_view &lhs, const string &rhs)
-	{
-		const size_type lhs_sz = lhs.size();
-		const size_type rhs_sz = rhs.size();
+SPL_STRING_TARGET("ssse3")
+inline bool validate_utf8_ssse3(const char *str, std::size_t size)
+{
+	// Non-zero if the block ends in the middle of a multi-byte sequence
+	const __m128i incomplete_max = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
 
-		if (lhs_sz != rhs_sz)
-			return false;
+	__m128i error = _mm_setzero_si128();
+	__m128i prev_input = _mm_setzero_si128();
+	__m128i prev_incomplete = _mm_setzero_si128();
 
-		return std::char_traits<char>::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
-	}
+	std::size_t i = 0;
+	char tail[16];
 
-	bool operator==(const char *rhs) const noexcept
+	while (i < size)
 	{
-		const size_type lhs_sz = size();
-		const size_type rhs_sz = std::char_traits<char>::length(rhs);
+		__m128i input;
 
-		if (lhs_sz != rhs_sz)
-			return false;
+		if (i + 16 <= size)
+		{
+			input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+		}
+		else
+		{
+			std::memset(tail, 0, sizeof(tail));
+			std::memcpy(tail, str + i, size - i);
+			input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+		}
 
-		return std::char_traits<char>::compare(data(), rhs, size()) == 0;
-	}
+		if (_mm_movemask_epi8(input) == 0)
+		{
+			// Pure ASCII block, only a sequence left open by the previous block can be wrong
+			error = _mm_or_si128(error, prev_incomplete);
+			prev_incomplete = _mm_setzero_si128();
+		}
+		else
+		{
+			error = _mm_or_si128(error, utf8_block_errors_ssse3(input, prev_input));
+			prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+		}
 
-#if _MSVC_LANG > 201703L || __cplusplus > 201703L
-	auto operator<=>(const string &rhs) const noexcept
-	{
-		return compare(rhs) <=> 0;
-	}
-#else
-	bool operator<(const string &rhs) const noexcept
-	{
-		return compare(rhs) < 0;
+		prev_input = input;
+		i += 16;
 	}
 
-	bool operator<=(const string &rhs) const noexcept
-	{
-		return compare(rhs) <= 0;
-	}
+	error = _mm_or_si128(error, prev_incomplete);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
 
-	bool operator>(const string &rhs) const noexcept
-	{
-		return compare(rhs) > 0;
-	}
+SPL_STRING_TARGET("avx2")
+inline __m256i utf8_prev_avx2(__m256i input, __m256i prev_input, int n)
+{
+	const __m256i shifted_in = _mm256_permute2x128_si256(prev_input, input, 0x21);
 
-	bool operator>=(const string &rhs) const noexcept
+	switch (n)
 	{
-		return compare(rhs) >= 0;
+	case 1: return _mm256_alignr_epi8(input, shifted_in, 15);
+	case 2: return _mm256_alignr_epi8(input, shifted_in, 14);
+	default: return _mm256_alignr_epi8(input, shifted_in, 13);
 	}
-#endif
+}
 
-	string &operator+=(const std::string_view &str)
-	{
-		return append(str);
-	}
+SPL_STRING_TARGET("avx2")
+inline __m256i utf8_block_errors_avx2(__m256i input, __m256i prev_input)
+{
+	const __m256i byte_1_high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_high)));
+	const __m256i byte_1_low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_low)));
+	const __m256i byte_2_high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8_byte_2_high)));
+	const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+
+	const __m256i prev1 = utf8_prev_avx2(input, prev_input, 1);
+	const __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+	const __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, low_nibble));
+	const __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+	const __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+	const __m256i prev2 = utf8_prev_avx2(input, prev_input, 2);
+	const __m256i prev3 = utf8_prev_avx2(input, prev_input, 3);
+	const __m256i is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(char(0xE0 - 0x80)));
+	const __m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(char(0xF0 - 0x80)));
+	const __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8(char(0x80)));
+
+	return _mm256_xor_si256(must_be_continuation, special_cases);
+}
 
-	string &operator+=(const string &str)
-	{
-		return append(str);
-	}
+SPL_STRING_TARGET("avx2")
+inline bool validate_utf8_avx2(const char *str, std::size_t size)
+{
+	const __m256i incomplete_max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
 
-	string &operator+=(char ch)
-	{
-		return append(1, ch);
-	}
+	__m256i error = _mm256_setzero_si256();
+	__m256i prev_input = _mm256_setzero_si256();
+	__m256i prev_incomplete = _mm256_setzero_si256();
 
-	string &operator+=(const char *str)
-	{
-		return operator+=(std::string_view(str));
-	}
+	std::size_t i = 0;
+	char tail[32];
 
-	int compare(const string &str) const noexcept
+	while (i < size)
 	{
-		const size_type lhs_sz = size();
-		const size_type rhs_sz = str.size();
+		__m256i input;
 
-		const int result = std::char_traits<char>::compare(data(), str.data(), std::min(lhs_sz, rhs_sz));
+		if (i + 32 <= size)
+		{
+			input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+		}
+		else
+		{
+			std::memset(tail, 0, sizeof(tail));
+			std::memcpy(tail, str + i, size - i);
+			input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail));
+		}
 
-		if (result != 0)
-			return result;
-		if (lhs_sz < rhs_sz)
-			return -1;
-		if (lhs_sz > rhs_sz)
-			return 1;
+		if (_mm256_movemask_epi8(input) == 0)
+		{
+			error = _mm256_or_si256(error, prev_incomplete);
+			prev_incomplete = _mm256_setzero_si256();
+		}
+		else
+		{
+			error = _mm256_or_si256(error, utf8_block_errors_avx2(input, prev_input));
+			prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+		}
 
-		return 0;
+		prev_input = input;
+		i += 32;
 	}
 
-private:
+	error = _mm256_or_si256(error, prev_incomplete);
+	return _mm256_testz_si256(error, error) != 0;
+}
 
-	template <typename T>
-	bool contains_string_like(const T &str) const
-	{
-		return find(str) != npos;
-	}
 
-public:
+#endif
 
-	bool contains(const string &str) const
-	{
-		return contains_string_like(str);
-	}
+inline bool validate_utf8(const char *str, std::size_t size)
+{
+#if defined(SPL_STRING_SSE2)
+	if (cpu().avx2)
+		return validate_utf8_avx2(str, size);
 
-	bool contains(const std::string &str) const
-	{
-		return contains_string_like(str);
-	}
+	if (cpu().ssse3)
+		return validate_utf8_ssse3(str, size);
+#endif
 
-	bool contains(const std::string_view &str) const
-	{
-		return contains_string_like(str);
-	}
+	return validate_utf8_scalar(str, size);
+}
 
-	bool contains(const char *str) const
-	{
-		return contains(std::string_view(str));
-	}
+inline bool is_utf8_lead(char ch)
+{
+	return (static_cast<unsigned char>(ch) & 0xC0) != 0x80;
+}
 
-	bool contains(char ch) const
-	{
-		return find(ch) != npos;
-	}
+// Counts every byte that isn't a continuation byte, which is the number of code points in valid UTF-8
+inline std::size_t count_utf8_leads(const char *str, std::size_t size)
+{
+	std::size_t count = 0;
+	std::size_t i = 0;
 
-	void resize(size_type count)
-	{
-		return resize(count, char());
-	}
+#if defined(SPL_STRING_SSE2)
+	const __m128i continuation_max = _mm_set1_epi8(char(0xBF));
 
-	void resize(size_type count, char ch)
+	while (i + 16 <= size)
 	{
-		if (count > max_size())
-			throw std::length_error("string too long");
+		// Per-byte counters are folded into the total before they can overflow
+		__m128i counters = _mm_setzero_si128();
+		const std::size_t blocks = std::min<std::size_t>((size - i) / 16, 255);
 
-		if (count <= mLength)
+		for (std::size_t block = 0; block < blocks; ++block, i += 16)
 		{
-			mLength = count;
-			mBuffer[mLength] = '\0';
+			const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+			counters = _mm_sub_epi8(counters, _mm_cmpgt_epi8(input, continuation_max));
 		}
-		else
-		{
-			reallocate(count + 1);
-			mBuffer[count] = '\0';
 
-			std::fill_n(&mBuffer[mLength], count - mLength, ch);
-			mLength = count;
-		}
+		const __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+		count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) + static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
 	}
+#endif
 
-private:
+	for (; i < size; ++i)
+		count += is_utf8_lead(str[i]);
 
-	template <typename T>
-	size_type find_string_like(const T &str, size_type pos = 0) const
-	{
-		if (str.empty())
-			return pos <= size() ? pos : npos;
+	return count;
+}
 
-		if (pos >= size())
-			return npos;
+// Byte offset of the code point that comes after skipping count code points
+inline std::size_t utf8_advance(const char *str, std::size_t size, std::size_t count)
+{
+	std::size_t i = 0;
 
-		if (str.size() > size() - pos)
-			return npos;
+#if defined(SPL_STRING_SSE2)
+	const __m128i continuation_max = _mm_set1_epi8(char(0xBF));
 
-		const size_type end = size() - str.size();
+	for (; i + 16 <= size; i += 16)
+	{
+		const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+		const unsigned leads = popcount(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(input, continuation_max))));
 
-		for (size_type i = pos; i <= end; ++i)
-		{
-			if (compare_equal(&mBuffer[i], str.data(), str.size()))
-				return i;
-		}
+		if (leads > count)
+			break;
 
-		return npos;
+		count -= leads;
 	}
+#endif
 
-	template <typename T>
-	size_type rfind_string_like(const T &str, size_type pos = npos) const
+	for (; i < size; ++i)
 	{
-		if (str.empty())
-			return pos > size() ? size() : pos;
-
-		if (empty())
-			return npos;
-
-		if (str.size() > size())
-			return npos;
-
-		pos = std::min(pos, size() - str.size());
-
-		const char *cur = &mBuffer[pos];
-		const char *end = mBuffer.get() - 1;
-
-		for (;cur != end; --cur)
+		if (is_utf8_lead(str[i]))
 		{
-			if (compare_equal(cur, str.data(), str.size()))
-				return cur - mBuffer.get();
-		}
+			if (count == 0)
+				return i;
 
-		return npos;
+			--count;
+		}
 	}
 
-public:
+	return size;
+}
 
-	size_type find(const string &str, size_type pos = 0) const
-	{
-		return find_string_like(str, pos);
-	}
 
-	size_type find(const std::string &str, size_type pos = 0) const
-	{
-		return find_string_like(str, pos);
-	}
+// Length of the leading run of ASCII bytes
+inline std::size_t ascii_prefix_length(const char *str, std::size_t size)
+{
+	std::size_t i = 0;
 
-	size_type find(const char *str, size_type pos, size_type count) const
+#if defined(SPL_STRING_SSE2)
+	for (; i + 16 <= size; i += 16)
 	{
-		return find(std::string_view(str, count), pos);
-	}
+		const std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i))));
 
-	size_type find(const char *str, size_type pos = 0) const
-	{
-		return find(std::string_view(str), pos);
+		if (mask != 0)
+			return i + count_trailing_zeros(mask);
 	}
+#endif
 
-	size_type find(char ch, size_type pos = 0) const
+	for (; i < size; ++i)
 	{
-		if (pos >= size())
-			return npos;
+		if (static_cast<unsigned char>(str[i]) & 0x80)
+			return i;
+	}
 
-		for (size_type i = pos; i < size(); ++i)
-		{
-			if (mBuffer[i] == ch)
-				return i;
-		}
+	return size;
+}
 
-		return npos;
-	}
+inline std::size_t utf8_encoded_size(char32_t cp)
+{
+	return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
 
-	size_type find(const std::string_view &sv, size_type pos = 0) const
+inline char *encode_utf8(char32_t cp, char *out)
+{
+	if (cp < 0x80)
 	{
-		return find_string_like(sv, pos);
+		*out++ = static_cast<char>(cp);
 	}
-
-	size_type rfind(const string &str, size_type pos = npos) const
+	else if (cp < 0x800)
 	{
-		return rfind_string_like(str, pos);
+		*out++ = static_cast<char>(0xC0 | (cp >> 6));
+		*out++ = static_cast<char>(0x80 | (cp & 0x3F));
 	}
-
-	size_type rfind(const std::string &str, size_type pos = npos) const
+	else if (cp < 0x10000)
 	{
-		return rfind_string_like(str, pos);
+		*out++ = static_cast<char>(0xE0 | (cp >> 12));
+		*out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		*out++ = static_cast<char>(0x80 | (cp & 0x3F));
 	}
-
-	size_type rfind(const char *str, size_type pos, size_type count) const
+	else
 	{
-		return rfind(std::string_view(str, count), pos);
+		*out++ = static_cast<char>(0xF0 | (cp >> 18));
+		*out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		*out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		*out++ = static_cast<char>(0x80 | (cp & 0x3F));
 	}
 
-	size_type rfind(const char *str, size_type pos = npos) const
-	{
-		return rfind(std::string_view(str), pos);
-	}
+	return out;
+}
 
-	size_type rfind(char ch, size_type pos = npos) const
-	{
-		if (empty())
-			return npos;
+inline const case_entry &case_lookup(const case_table &table, char32_t cp)
+{
+	if (cp >= table.limit)
+		return table.entries[0];
 
-		pos = std::min(pos, size() - 1);
+	const std::size_t block = table.index[cp >> case_block_shift];
+	const std::size_t offset = cp & ((char32_t(1) << case_block_shift) - 1);
 
-		const char *cur = &mBuffer[pos];
-		const char *end = mBuffer.get() - 1;
+	return table.entries[table.blocks[(block << case_block_shift) | offset]];
+}
 
-		for (;cur != end; --cur)
+// Writes the case mapped string to out, which must hold utf8_case_map_bound() bytes, and returns the new end.
+// Invalid bytes are copied through untouched.
+inline char *utf8_case_map(const char *str, std::size_t size, const case_table &table, bool ascii_upper, char *out)
+{
+	const char ascii_first = ascii_upper ? 'a' : 'A';
+	std::size_t i = 0;
+
+	while (i < size)
+	{
+		if (!(static_cast<unsigned char>(str[i]) & 0x80))
 		{
-			if (*cur == ch)
-				return cur - mBuffer.get();
-		}
+#if defined(SPL_STRING_SSE2)
+			const __m128i range_low = _mm_set1_epi8(ascii_first - 1);
+			const __m128i range_high = _mm_set1_epi8(ascii_first + 26);
+			const __m128i case_bit = _mm_set1_epi8(0x20);
 
-		return npos;
-	}
+			for (; i + 16 <= size; i += 16, out += 16)
+			{
+				const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+
+				if (_mm_movemask_epi8(input) != 0)
+					break;
+
+				// Note: Signed compares are fine here since the whole block is ASCII
+				const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(input, range_low), _mm_cmplt_epi8(input, range_high));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_xor_si128(input, _mm_and_si128(letters, case_bit)));
+			}
+#endif
+
+			// Whatever is left of the ASCII run before the next multi-byte sequence
+			for (; i < size && !(static_cast<unsigned char>(str[i]) & 0x80); ++i)
+			{
+				const char ch = str[i];
+				*out++ = (ch >= ascii_first && ch < ascii_first + 26) ? static_cast<char>(ch ^ 0x20) : ch;
+			}
+
+			continue;
+		}
+
+		std::size_t length;
+		const char32_t cp = decode_utf8(str + i, size - i, length);
+		const case_entry &entry = case_lookup(table, cp);
+
+		if (entry.length == 1)
+		{
+			out = encode_utf8(cp + entry.delta, out);
+		}
+		else if (entry.length > 1)
+		{
+			for (std::size_t j = 0; j < entry.length; ++j)
+				out = encode_utf8(case_expansions[entry.expansion + j], out);
+		}
+		else
+		{
+			for (std::size_t j = 0; j < length; ++j)
+				*out++ = str[i + j];
+		}
+
+		i += length;
+	}
+
+	return out;
+}
+
+// Output size to allocate for utf8_case_map(). Only the part after the leading ASCII run can grow.
+inline std::size_t utf8_case_map_bound(const char *str, std::size_t size)
+{
+	const std::size_t ascii = ascii_prefix_length(str, size);
+
+	if (size - ascii > (std::numeric_limits<std::size_t>::max() - 1 - ascii) / case_max_growth)
+		throw std::length_error("string too long");
+
+	return ascii + (size - ascii) * case_max_growth;
+}
+
+inline std::string utf8_case_mapped(const std::string_view &view, const case_table &table, bool ascii_upper)
+{
+	std::string mapped(utf8_case_map_bound(view.data(), view.size()), char());
+	mapped.resize(utf8_case_map(view.data(), view.size(), table, ascii_upper, mapped.data()) - mapped.data());
+
+	return mapped;
+}
+
+}
+
+// Iterates over the code points of a UTF-8 string. Invalid sequences come out as U+FFFD, one byte at a time.
+class utf8_view
+{
+public:
+
+	struct iterator
+	{
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = char32_t;
+		using difference_type = ptrdiff_t;
+		using pointer = const char32_t*;
+		using reference = char32_t;
+
+		iterator(const char *current, const char *end) noexcept : mCurrent(current), mEnd(end) {}
+
+		bool operator==(const iterator &rhs) const noexcept { return mCurrent == rhs.mCurrent; }
+		bool operator!=(const iterator &rhs) const noexcept { return mCurrent != rhs.mCurrent; }
+
+		char32_t operator*() const
+		{
+			std::size_t length;
+			return detail::decode_utf8(mCurrent, mEnd - mCurrent, length);
+		}
+
+		iterator &operator++()
+		{
+			std::size_t length;
+			detail::decode_utf8(mCurrent, mEnd - mCurrent, length);
+			mCurrent += length;
+
+			return *this;
+		}
+
+		iterator operator++(int)
+		{
+			iterator retval = *this;
+			++(*this);
+
+			return retval;
+		}
+
+		// Byte position of the current code point
+		const char *data() const noexcept { return mCurrent; }
+
+	private:
+		const char *mCurrent;
+		const char *mEnd;
+	};
+
+	using const_iterator = iterator;
+
+	utf8_view() noexcept = default;
+	utf8_view(const std::string_view &view) noexcept : mView(view) {}
+
+	iterator begin() const noexcept { return iterator(mView.data(), mView.data() + mView.size()); }
+	iterator end() const noexcept { return iterator(mView.data() + mView.size(), mView.data() + mView.size()); }
+
+	const std::string_view &view() const noexcept { return mView; }
+
+private:
+	std::string_view mView;
+};
+
+enum struct split_side
+{
+	left,
+	right
+};
+
+class string_ref;
+
+namespace detail
+{
+
+struct string_view_api_tag {};
+
+// What the helpers below return for a piece of the string. string_ref slices are string_refs, so calls chain.
+template <typename Derived>
+struct string_slice
+{
+	using type = std::string_view;
+};
+
+template <>
+struct string_slice<string_ref>
+{
+	using type = string_ref;
+};
+
+// Read-only helpers shared by the string types that can hand out a std::string_view of themselves.
+// Derived only has to provide view(), and everything here is constexpr where std::string_view allows it.
+// Searches go through Derived's find(), so a type can swap in its own (spl::string counts them for stats).
+template <typename Derived>
+class string_view_api : public string_view_api_tag
+{
+public:
+
+	using size_type = std::size_t;
+	using slice_type = typename string_slice<Derived>::type;
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+	constexpr bool empty() const noexcept { return self().empty(); }
+	constexpr size_type size() const noexcept { return self().size(); }
+	constexpr size_type length() const noexcept { return self().size(); }
+
+	constexpr const char &operator[](size_type pos) const { return self().data()[pos]; }
+	constexpr const char &front() const { return self().data()[0]; }
+	constexpr const char &back() const { return self().data()[self().size() - 1]; }
+
+	constexpr int compare(const std::string_view &str) const noexcept
+	{
+		return self().compare(str);
+	}
+
+	constexpr size_type find(const std::string_view &str, size_type pos = 0) const noexcept { return self().find(str, pos); }
+	constexpr size_type find(char ch, size_type pos = 0) const noexcept { return self().find(ch, pos); }
+	constexpr size_type rfind(const std::string_view &str, size_type pos = npos) const noexcept { return self().rfind(str, pos); }
+	constexpr size_type rfind(char ch, size_type pos = npos) const noexcept { return self().rfind(ch, pos); }
+
+	constexpr bool contains(const std::string_view &str) const noexcept { return derived().find(str) != npos; }
+	constexpr bool contains(char ch) const noexcept { return derived().find(ch) != npos; }
+
+	constexpr bool starts_with(const std::string_view &str) const noexcept
+	{
+		return str.size() > size() ? false : self().compare(0, str.size(), str) == 0;
+	}
+
+	constexpr bool starts_with(char ch) const noexcept
+	{
+		return empty() ? false : front() == ch;
+	}
+
+	constexpr bool ends_with(const std::string_view &str) const noexcept
+	{
+		return str.size() > size() ? false : self().compare(size() - str.size(), str.size(), str) == 0;
+	}
+
+	constexpr bool ends_with(char ch) const noexcept
+	{
+		return empty() ? false : back() == ch;
+	}
+
+	constexpr slice_type split(char ch, size_type offset = 0, split_side side = split_side::left) const noexcept
+	{
+		const std::string_view str = self();
+
+		// Note: This also serves as an empty() check
+		if (offset >= str.size())
+			return {};
+
+		const size_type found = str.find(ch, offset);
+
+		if (found == npos)
+			return side == split_side::left ? str.substr(offset) : std::string_view();
+
+		return side == split_side::left ? str.substr(offset, found - offset) : str.substr(found + 1);
+	}
+
+	// T can be anything constructible from a pointer and a length, like spl::string, std::string or std::string_view
+	template <typename T>
+	void split(char ch, std::vector<T> &out, size_type offset = 0) const
+	{
+		const std::string_view str = self();
+
+		// Note: This also serves as an empty() check
+		if (offset >= str.size())
+			return;
+
+		size_type last_split = offset;
+
+		for (size_type found = str.find(ch, offset); found != npos; found = str.find(ch, last_split))
+		{
+			out.emplace_back(T(str.data() + last_split, found - last_split));
+			last_split = found + 1;
+		}
+
+		if (last_split < str.size())
+			out.emplace_back(T(str.data() + last_split, str.size() - last_split));
+	}
+
+	constexpr slice_type rsplit(char ch, size_type roffset = 0, split_side side = split_side::right) const noexcept
+	{
+		const std::string_view str = self();
+
+		// Note: This also serves as an empty() check
+		if (roffset >= str.size())
+			return {};
+
+		const size_type found = str.rfind(ch, str.size() - roffset - 1);
+
+		if (found == npos)
+			return side == split_side::left ? std::string_view() : str.substr(0, str.size() - roffset);
+
+		if (side == split_side::left)
+			return str.substr(0, found);
+
+		return found + 1 == str.size() ? std::string_view() : str.substr(found + 1, str.size() - found - 1 - roffset);
+	}
+
+	template <typename T>
+	T get_as() const
+	{
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			return (bool)get_as<int>();
+		}
+		else
+		{
+			static_assert(std::is_arithmetic_v<T>, "T is not a numeric type");
+
+			const std::string_view str = self();
+			T value = {};
+
+			std::from_chars(str.data(), str.data() + str.size(), value);
+			return value;
+		}
+	}
+
+	constexpr slice_type trimmed_view() const { return whitespace_trimmed_view(self(), true, true); }
+	constexpr slice_type trimmed_view(const std::string_view &chars) const { return detail::trimmed_view(self(), char_set(chars), true, true); }
+
+	constexpr slice_type ltrimmed_view() const { return whitespace_trimmed_view(self(), true, false); }
+	constexpr slice_type ltrimmed_view(const std::string_view &chars) const { return detail::trimmed_view(self(), char_set(chars), true, false); }
+
+	constexpr slice_type rtrimmed_view() const { return whitespace_trimmed_view(self(), false, true); }
+	constexpr slice_type rtrimmed_view(const std::string_view &chars) const { return detail::trimmed_view(self(), char_set(chars), false, true); }
+
+	bool is_valid_utf8() const
+	{
+		const std::string_view str = self();
+		return validate_utf8(str.data(), str.size());
+	}
+
+	// Note: Only meaningful for valid UTF-8, every byte that isn't a continuation byte is counted
+	size_type utf8_length() const
+	{
+		const std::string_view str = self();
+		return count_utf8_leads(str.data(), str.size());
+	}
+
+	spl::utf8_view utf8() const noexcept
+	{
+		return spl::utf8_view(self());
+	}
+
+	// Like substr(), but the offset and count are in code points. The result points into this string.
+	slice_type utf8_substr(size_type cp_offset, size_type cp_count = npos) const
+	{
+		const std::string_view str = self();
+		const size_type first = utf8_advance(str.data(), str.size(), cp_offset);
+		const size_type count = cp_count == npos ? str.size() - first : utf8_advance(str.data() + first, str.size() - first, cp_count);
+
+		return str.substr(first, count);
+	}
+
+	// Any string-like type on the right, including another string_view_api type
+	template <typename T, typename = std::enable_if_t<std::is_convertible_v<const T&, std::string_view>>>
+	friend constexpr bool operator==(const Derived &lhs, const T &rhs) noexcept
+	{
+		return lhs.view() == std::string_view(rhs);
+	}
+
+	template <typename T, typename = std::enable_if_t<std::is_convertible_v<const T&, std::string_view>>>
+	friend constexpr bool operator!=(const Derived &lhs, const T &rhs) noexcept
+	{
+		return lhs.view() != std::string_view(rhs);
+	}
+
+	// Other string-like types on the left, which is the only way to get here for spl::string and std::string
+	template <typename T, typename = std::enable_if_t<std::is_convertible_v<const T&, std::string_view> &&
+		!std::is_base_of_v<string_view_api_tag, T>>>
+	friend constexpr bool operator==(const T &lhs, const Derived &rhs) noexcept
+	{
+		return std::string_view(lhs) == rhs.view();
+	}
+
+	template <typename T, typename = std::enable_if_t<std::is_convertible_v<const T&, std::string_view> &&
+		!std::is_base_of_v<string_view_api_tag, T>>>
+	friend constexpr bool operator!=(const T &lhs, const Derived &rhs) noexcept
+	{
+		return std::string_view(lhs) != rhs.view();
+	}
+
+#if _MSVC_LANG > 201703L || __cplusplus > 201703L
+	friend constexpr auto operator<=>(const Derived &lhs, const Derived &rhs) noexcept
+	{
+		return lhs.view() <=> rhs.view();
+	}
+#else
+	friend constexpr bool operator<(const Derived &lhs, const Derived &rhs) noexcept
+	{
+		return lhs.view() < rhs.view();
+	}
+
+	friend constexpr bool operator<=(const Derived &lhs, const Derived &rhs) noexcept
+	{
+		return lhs.view() <= rhs.view();
+	}
+
+	friend constexpr bool operator>(const Derived &lhs, const Derived &rhs) noexcept
+	{
+		return lhs.view() > rhs.view();
+	}
+
+	friend constexpr bool operator>=(const Derived &lhs, const Derived &rhs) noexcept
+	{
+		return lhs.view() >= rhs.view();
+	}
+#endif
+
+	friend std::ostream &operator<<(std::ostream &os, const Derived &str)
+	{
+		return os << str.view();
+	}
+
+private:
+
+	constexpr const Derived &derived() const noexcept
+	{
+		return static_cast<const Derived&>(*this);
+	}
+
+	constexpr std::string_view self() const noexcept
+	{
+		return derived().view();
+	}
+};
+
+}
+
+// Per-thread counters for spl::string's allocations, copies and searches, compiled in with SPL_STRING_STATS.
+// Without it the recording macros expand to nothing and string_stats_snapshot() always returns zeros.
+struct string_stats
+{
+	std::uint64_t allocations = 0;
+	std::uint64_t reallocations = 0;
+	std::uint64_t frees = 0;
+	std::uint64_t allocated_bytes = 0;   // Sum of the sizes passed to malloc and realloc
+	std::uint64_t copies = 0;
+	std::uint64_t moves = 0;
+	std::uint64_t searches = 0;
+	std::uint64_t scanned_bytes = 0;     // Bytes find()/rfind() looked at before returning
+};
+
+enum struct string_stats_event
+{
+	allocate,
+	reallocate,
+	free,
+	copy,
+	move,
+	search
+};
+
+// Called on the recording thread after each event. bytes is the allocation size, the length of the string copied
+// or moved, the bytes scanned by a search, or 0 for frees.
+using string_stats_callback = void (*)(string_stats_event event, std::size_t bytes, void *user_data);
+
+#if defined(SPL_STRING_STATS)
+
+constexpr bool string_stats_enabled = true;
+
+namespace detail
+{
+
+struct string_stats_state
+{
+	string_stats counters;
+	string_stats_callback callback = nullptr;
+	void *user_data = nullptr;
+};
+
+inline thread_local string_stats_state stats_state;
+
+inline void record_string_stat(string_stats_event event, std::size_t bytes) noexcept
+{
+	string_stats &counters = stats_state.counters;
+
+	switch (event)
+	{
+	case string_stats_event::allocate: ++counters.allocations; counters.allocated_bytes += bytes; break;
+	case string_stats_event::reallocate: ++counters.reallocations; counters.allocated_bytes += bytes; break;
+	case string_stats_event::free: ++counters.frees; break;
+	case string_stats_event::copy: ++counters.copies; break;
+	case string_stats_event::move: ++counters.moves; break;
+	case string_stats_event::search: ++counters.searches; counters.scanned_bytes += bytes; break;
+	}
+
+	if (stats_state.callback)
+		stats_state.callback(event, bytes, stats_state.user_data);
+}
+
+}
+
+#define SPL_STRING_RECORD_STAT(event, bytes) ::spl::detail::record_string_stat(::spl::string_stats_event::event, (bytes))
+
+inline string_stats string_stats_snapshot() noexcept
+{
+	return detail::stats_state.counters;
+}
+
+inline void reset_string_stats() noexcept
+{
+	detail::stats_state.counters = string_stats();
+}
+
+// Pass nullptr to remove the callback. Only affects the calling thread.
+inline void set_string_stats_callback(string_stats_callback callback, void *user_data = nullptr) noexcept
+{
+	detail::stats_state.callback = callback;
+	detail::stats_state.user_data = user_data;
+}
+
+#else
+
+constexpr bool string_stats_enabled = false;
+
+#define SPL_STRING_RECORD_STAT(event, bytes) ((void)0)
+
+inline string_stats string_stats_snapshot() noexcept { return string_stats(); }
+inline void reset_string_stats() noexcept {}
+inline void set_string_stats_callback(string_stats_callback, void * = nullptr) noexcept {}
+
+#endif
+
+namespace detail
+{
+
+// Where spl::string and the other owning string types get their buffers from
+inline char *storage_allocate(std::size_t size) noexcept
+{
+#if defined(SPL_STRING_POOLED_STORAGE)
+	return static_cast<char*>(buffer_pool::allocate(size));
+#else
+	return static_cast<char*>(std::malloc(size));
+#endif
+}
+
+inline char *storage_reallocate(char *memory, std::size_t size) noexcept
+{
+#if defined(SPL_STRING_POOLED_STORAGE)
+	return static_cast<char*>(buffer_pool::reallocate(memory, size));
+#else
+	return static_cast<char*>(std::realloc(memory, size));
+#endif
+}
+
+inline void storage_free(char *memory) noexcept
+{
+#if defined(SPL_STRING_POOLED_STORAGE)
+	buffer_pool::deallocate(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+}
+
+// Many short strings packed into one byte blob plus an offsets array, so a column of a million fields is two
+// allocations instead of a million. Entries are read back as string_views into the blob, which stay valid until
+// the table is modified. Copying is two memcpys.
+class string_table
+{
+public:
+
+	using size_type = std::size_t;
+
+	class const_iterator
+	{
+	public:
+
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::string_view;
+
+		const_iterator() = default;
+
+		std::string_view operator*() const noexcept { return (*mTable)[mIndex]; }
+		std::string_view operator[](difference_type n) const noexcept { return (*mTable)[mIndex + n]; }
+
+		const_iterator &operator++() noexcept { ++mIndex; return *this; }
+		const_iterator operator++(int) noexcept { const_iterator it = *this; ++mIndex; return it; }
+		const_iterator &operator--() noexcept { --mIndex; return *this; }
+		const_iterator operator--(int) noexcept { const_iterator it = *this; --mIndex; return it; }
+
+		const_iterator &operator+=(difference_type n) noexcept { mIndex += n; return *this; }
+		const_iterator &operator-=(difference_type n) noexcept { mIndex -= n; return *this; }
+		const_iterator operator+(difference_type n) const noexcept { return const_iterator(mTable, mIndex + n); }
+		const_iterator operator-(difference_type n) const noexcept { return const_iterator(mTable, mIndex - n); }
+		difference_type operator-(const const_iterator &rhs) const noexcept { return difference_type(mIndex - rhs.mIndex); }
+
+		bool operator==(const const_iterator &rhs) const noexcept { return mIndex == rhs.mIndex; }
+		bool operator!=(const const_iterator &rhs) const noexcept { return mIndex != rhs.mIndex; }
+		bool operator<(const const_iterator &rhs) const noexcept { return mIndex < rhs.mIndex; }
+
+	private:
+
+		friend class string_table;
+
+		const_iterator(const string_table *table, size_type index) noexcept : mTable(table), mIndex(index) {}
+
+		const string_table *mTable = nullptr;
+		size_type mIndex = 0;
+	};
+
+	using iterator = const_iterator;
+
+	string_table() : mOffsets(1, 0) {}
+
+	string_table(std::initializer_list<std::string_view> strings) : string_table()
+	{
+		for (const std::string_view &str : strings)
+			push_back(str);
+	}
+
+	void push_back(const std::string_view &str)
+	{
+		mBlob.insert(mBlob.end(), str.begin(), str.end());
+		mOffsets.push_back(mBlob.size());
+	}
+
+	void pop_back() noexcept
+	{
+		mOffsets.pop_back();
+		mBlob.resize(mOffsets.back());
+	}
+
+	std::string_view operator[](size_type index) const noexcept
+	{
+		return std::string_view(mBlob.data() + mOffsets[index], mOffsets[index + 1] - mOffsets[index]);
+	}
+
+	std::string_view at(size_type index) const
+	{
+		if (index >= size())
+			throw std::out_of_range("invalid string table index");
+
+		return (*this)[index];
+	}
+
+	std::string_view front() const noexcept { return (*this)[0]; }
+	std::string_view back() const noexcept { return (*this)[size() - 1]; }
+
+	const_iterator begin() const noexcept { return const_iterator(this, 0); }
+	const_iterator end() const noexcept { return const_iterator(this, size()); }
+
+	size_type size() const noexcept { return mOffsets.size() - 1; }
+	bool empty() const noexcept { return mOffsets.size() == 1; }
+
+	// Total bytes of all strings
+	size_type bytes() const noexcept { return mBlob.size(); }
+
+	// The packed strings back to back, and size() + 1 offsets into them where string i is [offsets[i], offsets[i + 1])
+	std::string_view blob() const noexcept { return std::string_view(mBlob.data(), mBlob.size()); }
+	const size_type *offsets() const noexcept { return mOffsets.data(); }
+
+	void reserve(size_type count, size_type bytes = 0)
+	{
+		mOffsets.reserve(count + 1);
+		mBlob.reserve(bytes);
+	}
+
+	void clear() noexcept
+	{
+		mBlob.clear();
+		mOffsets.resize(1);
+	}
+
+	void shrink_to_fit()
+	{
+		mBlob.shrink_to_fit();
+		mOffsets.shrink_to_fit();
+	}
+
+	bool operator==(const string_table &rhs) const noexcept { return mOffsets == rhs.mOffsets && mBlob == rhs.mBlob; }
+	bool operator!=(const string_table &rhs) const noexcept { return !(*this == rhs); }
+
+private:
+
+	friend void split_into(const std::string_view &view, char ch, string_table &out, std::size_t offset);
+
+	std::vector<char> mBlob;
+	std::vector<size_type> mOffsets;
+};
+
+// Appends the pieces of view split on ch to out, with the same pieces as split() into a vector.
+// The delimiters are dropped, so the blob grows by at most the size of the text being split.
+inline void split_into(const std::string_view &view, char ch, string_table &out, std::size_t offset = 0)
+{
+	// Note: This also serves as an empty() check
+	if (offset >= view.size())
+		return;
+
+	const char *cur = view.data() + offset;
+	const char *end = view.data() + view.size();
+
+	// Note: Grows at least geometrically, so appending many small rows one call at a time stays linear
+	const std::size_t needed = out.mBlob.size() + (end - cur);
+
+	if (needed > out.mBlob.capacity())
+		out.mBlob.reserve(std::max(needed, 2 * out.mBlob.capacity()));
+
+	while (cur != end)
+	{
+		const char *found = static_cast<const char*>(std::memchr(cur, ch, end - cur));
+		const char *piece_end = found ? found : end;
+
+		out.mBlob.insert(out.mBlob.end(), cur, piece_end);
+		out.mOffsets.push_back(out.mBlob.size());
+
+		if (!found)
+			break;
+
+		cur = found + 1;
+	}
+}
+
+class edit_batch;
+class iovec_builder;
+
+// Comparisons, searches, splitting, trimmed views and the other read-only helpers come from detail::string_view_api,
+// the same as for spl::string_ref, fixed_string and literal
+class string : public detail::string_view_api<string>
+{
+	friend class edit_batch;
+	friend class iovec_builder;
+
+	struct buffer_deleter
+	{
+		void operator()(char memory[])
+		{
+			SPL_STRING_RECORD_STAT(free, 0);
+			detail::storage_free(memory);
+		}
+	};
+
+public:
+
+	using split_side = spl::split_side;
+
+	struct iterator_base
+	{
+		using iterator_category = std::input_iterator_tag;
+		using value_type = char;
+		using difference_type = ptrdiff_t;
+		using pointer = char*;
+		using reference = char&;
+
+		iterator_base(char *begin) noexcept : mCurrent(begin) {}
+		iterator_base(const iterator_base &it) noexcept : mCurrent(it.mCurrent) {}
+
+		bool operator==(const iterator_base &rhs) const noexcept { return mCurrent == rhs.mCurrent; }
+		bool operator!=(const iterator_base &rhs) const noexcept { return mCurrent != rhs.mCurrent; }
+
+		char &operator*() { return *mCurrent; }
+		const char &operator*() const { return *mCurrent; }
+
+	protected:
+		char *mCurrent;
+	};
+
+	struct iterator : iterator_base
+	{
+		using iterator_base::iterator_base;
+
+		iterator &operator++() noexcept
+		{
+			++mCurrent;
+			return *this;
+		}
+
+		iterator &operator--() noexcept
+		{
+			--mCurrent;
+			return *this;
+		}
+
+		iterator operator++(int)
+		{
+			iterator retval = *this;
+			++(*this);
+
+			return retval;
+		}
+
+		iterator operator--(int)
+		{
+			iterator retval = *this;
+			--(*this);
+
+			return retval;
+		}
+
+		friend iterator operator+(const iterator &lhs, difference_type count)
+		{
+			iterator retval = lhs;
+			retval.mCurrent += count;
+
+			return retval;
+		}
+
+		friend iterator operator-(const iterator &lhs, difference_type count)
+		{
+			iterator retval = lhs;
+			retval.mCurrent -= count;
+
+			return retval;
+		}
+
+		bool operator<(const iterator &rhs) const noexcept { return mCurrent < rhs.mCurrent; }
+		bool operator<=(const iterator &rhs) const noexcept { return mCurrent <= rhs.mCurrent; }
+		bool operator>(const iterator &rhs) const noexcept { return mCurrent > rhs.mCurrent; }
+		bool operator>=(const iterator &rhs) const noexcept { return mCurrent >= rhs.mCurrent; }
+	};
+
+	struct reverse_iterator : iterator_base
+	{
+		using iterator_base::iterator_base;
+
+		reverse_iterator &operator++() noexcept
+		{
+			--mCurrent;
+			return *this;
+		}
+
+		reverse_iterator &operator--() noexcept
+		{
+			++mCurrent;
+			return *this;
+		}
+
+		reverse_iterator operator++(int)
+		{
+			reverse_iterator retval = *this;
+			++(*this);
+
+			return retval;
+		}
+
+		reverse_iterator operator--(int)
+		{
+			reverse_iterator retval = *this;
+			--(*this);
+
+			return retval;
+		}
+
+		friend reverse_iterator operator+(const reverse_iterator &lhs, difference_type count)
+		{
+			reverse_iterator retval = lhs;
+			retval.mCurrent -= count;
+
+			return retval;
+		}
+
+		friend reverse_iterator operator-(const reverse_iterator &lhs, difference_type count)
+		{
+			reverse_iterator retval = lhs;
+			retval.mCurrent += count;
+
+			return retval;
+		}
+
+		bool operator<(const reverse_iterator &rhs) const noexcept { return mCurrent > rhs.mCurrent; }
+		bool operator<=(const reverse_iterator &rhs) const noexcept { return mCurrent >= rhs.mCurrent; }
+		bool operator>(const reverse_iterator &rhs) const noexcept { return mCurrent < rhs.mCurrent; }
+		bool operator>=(const reverse_iterator &rhs) const noexcept { return mCurrent <= rhs.mCurrent; }
+	};
+
+	using const_iterator = iterator;
+	using const_reverse_iterator = reverse_iterator;
+
+	using reference = char&;
+	using const_reference = const char&;
+
+	using size_type = std::size_t;
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+	inline string();
+
+	inline string(size_type count, char ch);
+
+	inline string(string &&other) noexcept;
+	inline string(const string &other);
+	inline string(const std::string &str);
+	inline string(const std::string_view &sv);
+	inline string(const char *str);
+	inline string(const char *str, size_type count);
+
+	inline string(const std::string_view &sv, size_type pos, size_type n);
+
+private:
+
+	// Tag for constructing a string whose contents are written by the caller
+	struct uninitialized_t {};
+
+	inline string(size_type count, uninitialized_t);
+
+	void allocate(size_type new_size)
+	{
+		SPL_STRING_RECORD_STAT(allocate, new_size);
+		mBuffer.reset(detail::storage_allocate(new_size));
+	}
+
+	void reallocate(size_type new_size)
+	{
+		SPL_STRING_RECORD_STAT(reallocate, new_size);
+		mBuffer.reset(detail::storage_reallocate(mBuffer.release(), new_size));
+	}
+
+public:
+
+	string &operator=(const string &rhs)
+	{
+		if (&rhs == this)
+			return *this;
+
+		SPL_STRING_RECORD_STAT(copy, rhs.mLength);
+
+		mLength = rhs.mLength;
+		
+		reallocate(mLength + 1);
+		mBuffer[mLength] = '\0';
+
+		std::memcpy(mBuffer.get(), rhs.data(), mLength);
+
+		return *this;
+	}
+
+	string &operator=(string &&rhs) noexcept
+	{
+		SPL_STRING_RECORD_STAT(move, rhs.mLength);
+
+		mLength = std::exchange(rhs.mLength, 0);
+		mBuffer = std::move(rhs.mBuffer);
+
+		return *this;
+	}
+
+	reference at(size_type pos)
+	{
+		if (pos >= size())
+			throw std::out_of_range("invalid string position");
+
+		return mBuffer[pos];
+	}
+
+	const_reference at(size_type pos) const
+	{
+		if (pos >= size())
+			throw std::out_of_range("invalid string position");
+
+		return mBuffer[pos];
+	}
+
+	reference operator[](size_type pos)
+	{
+		return mBuffer[pos];
+	}
+
+	const_reference operator[](size_type pos) const
+	{
+		return mBuffer[pos];
+	}
+
+	char &front()
+	{
+		return mBuffer[0];
+	}
+
+	const char &front() const
+	{
+		return mBuffer[0];
+	}
+
+	char &back()
+	{
+		return mBuffer[size() - 1];
+	}
+
+	const char &back() const
+	{
+		return mBuffer[size() - 1];
+	}
+
+	string &operator+=(const std::string_view &str)
+	{
+		return append(str);
+	}
+
+	string &operator+=(const string &str)
+	{
+		return append(str);
+	}
+
+	string &operator+=(char ch)
+	{
+		return append(1, ch);
+	}
+
+	string &operator+=(const char *str)
+	{
+		return operator+=(std::string_view(str));
+	}
+
+	void resize(size_type count)
+	{
+		return resize(count, char());
+	}
+
+	void resize(size_type count, char ch)
+	{
+		if (count > max_size())
+			throw std::length_error("string too long");
+
+		if (count <= mLength)
+		{
+			mLength = count;
+			mBuffer[mLength] = '\0';
+		}
+		else
+		{
+			reallocate(count + 1);
+			mBuffer[count] = '\0';
+
+			std::fill_n(&mBuffer[mLength], count - mLength, ch);
+			mLength = count;
+		}
+	}
+
+	// Like std::string::resize_and_overwrite() in C++23: makes room for count characters without initializing the
+	// new ones, calls op(data, count) to write them and keeps as many as it returns. If op throws, the size is left
+	// as it was.
+	template <typename Operation>
+	void resize_and_overwrite(size_type count, Operation op)
+	{
+		if (count > max_size())
+			throw std::length_error("string too long");
+
+		// Note: Moved from strings have no buffer at all
+		if (count > mLength || !mBuffer)
+			reallocate(count + 1);
+
+		try
+		{
+			mLength = static_cast<size_type>(op(mBuffer.get(), count));
+		}
+		catch (...)
+		{
+			mBuffer[mLength] = '\0';
+			throw;
+		}
+
+		mBuffer[mLength] = '\0';
+	}
+
+private:
+
+	template <typename T>
+	size_type find_string_like(const T &str, size_type pos = 0) const
+	{
+		if (str.empty())
+			return pos <= size() ? pos : npos;
+
+		if (pos >= size())
+			return npos;
+
+		if (str.size() > size() - pos)
+			return npos;
+
+		const size_type end = size() - str.size();
+
+		for (size_type i = pos; i <= end; ++i)
+		{
+			if (compare_equal(&mBuffer[i], str.data(), str.size()))
+			{
+				SPL_STRING_RECORD_STAT(search, i - pos + str.size());
+				return i;
+			}
+		}
+
+		SPL_STRING_RECORD_STAT(search, size() - pos);
+		return npos;
+	}
+
+	template <typename T>
+	size_type rfind_string_like(const T &str, size_type pos = npos) const
+	{
+		if (str.empty())
+			return pos > size() ? size() : pos;
+
+		if (empty())
+			return npos;
+
+		if (str.size() > size())
+			return npos;
+
+		pos = std::min(pos, size() - str.size());
+
+		const char *cur = &mBuffer[pos];
+		const char *end = mBuffer.get() - 1;
+
+		for (;cur != end; --cur)
+		{
+			if (compare_equal(cur, str.data(), str.size()))
+			{
+				SPL_STRING_RECORD_STAT(search, &mBuffer[pos] - cur + str.size());
+				return cur - mBuffer.get();
+			}
+		}
+
+		SPL_STRING_RECORD_STAT(search, pos + str.size());
+		return npos;
+	}
+
+public:
+
+	size_type find(const string &str, size_type pos = 0) const
+	{
+		return find_string_like(str, pos);
+	}
+
+	size_type find(const std::string &str, size_type pos = 0) const
+	{
+		return find_string_like(str, pos);
+	}
+
+	size_type find(const char *str, size_type pos, size_type count) const
+	{
+		return find(std::string_view(str, count), pos);
+	}
+
+	size_type find(const char *str, size_type pos = 0) const
+	{
+		return find(std::string_view(str), pos);
+	}
+
+	size_type find(char ch, size_type pos = 0) const
+	{
+		if (pos >= size())
+			return npos;
+
+		for (size_type i = pos; i < size(); ++i)
+		{
+			if (mBuffer[i] == ch)
+			{
+				SPL_STRING_RECORD_STAT(search, i - pos + 1);
+				return i;
+			}
+		}
+
+		SPL_STRING_RECORD_STAT(search, size() - pos);
+		return npos;
+	}
+
+	size_type find(const std::string_view &sv, size_type pos = 0) const
+	{
+		return find_string_like(sv, pos);
+	}
+
+	size_type rfind(const string &str, size_type pos = npos) const
+	{
+		return rfind_string_like(str, pos);
+	}
+
+	size_type rfind(const std::string &str, size_type pos = npos) const
+	{
+		return rfind_string_like(str, pos);
+	}
+
+	size_type rfind(const char *str, size_type pos, size_type count) const
+	{
+		return rfind(std::string_view(str, count), pos);
+	}
+
+	size_type rfind(const char *str, size_type pos = npos) const
+	{
+		return rfind(std::string_view(str), pos);
+	}
+
+	size_type rfind(char ch, size_type pos = npos) const
+	{
+		if (empty())
+			return npos;
+
+		pos = std::min(pos, size() - 1);
+
+		const char *cur = &mBuffer[pos];
+		const char *end = mBuffer.get() - 1;
+
+		for (;cur != end; --cur)
+		{
+			if (*cur == ch)
+			{
+				SPL_STRING_RECORD_STAT(search, &mBuffer[pos] - cur + 1);
+				return cur - mBuffer.get();
+			}
+		}
+
+		SPL_STRING_RECORD_STAT(search, pos + 1);
+		return npos;
+	}
+
+	size_type rfind(const std::string_view &sv, size_type pos = npos) const
+	{
+		return rfind_string_like(sv, pos);
+	}
+
+private:
+
+	size_type index_of(const_iterator it) const noexcept
+	{
+		return &*it - data();
+	}
+
+public:
+
+	iterator begin() noexcept { return iterator(mBuffer.get()); }
+	iterator end() noexcept { return iterator(mBuffer.get() + mLength); }
+
+	const_iterator begin() const noexcept { return const_iterator(mBuffer.get()); }
+	const_iterator end() const noexcept { return const_iterator(mBuffer.get() + mLength); }
+
+	const_iterator cbegin() const noexcept { return const_iterator(mBuffer.get()); }
+	const_iterator cend() const noexcept { return const_iterator(mBuffer.get() + mLength); }
+
+	reverse_iterator rbegin() noexcept { return reverse_iterator(mBuffer.get() + mLength - 1); }
+	reverse_iterator rend() noexcept { return reverse_iterator(mBuffer.get() - 1); }
+
+	const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(mBuffer.get() + mLength - 1); }
+	const_reverse_iterator rend() const noexcept { return const_reverse_iterator(mBuffer.get() - 1); }
+
+	const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(mBuffer.get() + mLength - 1); }
+	const_reverse_iterator crend() const noexcept { return const_reverse_iterator(mBuffer.get() - 1); }
+
+	operator std::string() const { return std_string(); }
+	operator std::string_view() const noexcept { return view(); }
+	operator std::filesystem::path() const { return { view() }; }
+
+	char *data() { return &mBuffer[0]; }
+	const char *data() const { return &mBuffer[0]; }
+	const char *c_str() const { return &mBuffer[0]; }
+
+	std::string_view view() const noexcept { return { data(), size() }; }
+	std::string std_string() const { return { data(), size() }; }
+
+	bool empty() const noexcept { return mLength == 0; }
+	size_type size() const noexcept { return mLength; }
+	size_type length() const noexcept { return mLength; }
+	size_type max_size() const noexcept { return std::numeric_limits<size_type>::max() - 1; } // -1 for null terminator or npos
+
+	void clear()
+	{
+		mLength = 0;
+		reallocate(1);
+
+		mBuffer[mLength] = '\0';
+	}
+
+	string &erase(size_type index, size_type count = npos)
+	{
+		// Note: According to cppreference, std::string throws only if > size()
+		// Erasing at an index of size() should make the count 0 and erase nothing
+		// But this is still stupid IMHO
+		if (index > size())
+			throw std::out_of_range("invalid string position");
+
+		count = std::min(count, size() - index);
+		const size_type end = index + count;
+
+		std::memmove(&mBuffer[index], &mBuffer[end], size() - end);
+
+		mLength -= count;
+		mBuffer[mLength] = '\0';
+
+		return *this;
+	}
+
+	iterator erase(const_iterator position)
+	{
+		if (position == cend())
+			return end();
+
+		erase(index_of(position), 1);
+
+		return empty() ? end() : position;
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		erase(index_of(first), index_of(last) - index_of(first));
+
+		return empty() ? end() : first;
+	}
+
+	string &insert(size_type index, const std::string_view &str)
+	{
+		if (index > size())
+			throw std::out_of_range("invalid string position");
 
-	size_type rfind(const std::string_view &sv, size_type pos = npos) const
+		if (str.empty())
+			return *this;
+
+		if (str.size() > max_size() - size())
+			throw std::length_error("string too long");
+
+		// Note: Inserting a piece of ourselves would read from a buffer that realloc may have moved
+		if (str.data() >= data() && str.data() <= data() + size())
+			return insert(index, string(str));
+
+		const size_type old_size = size();
+		reallocate(old_size + str.size() + 1);
+
+		std::memmove(&mBuffer[index + str.size()], &mBuffer[index], old_size - index);
+		std::memcpy(&mBuffer[index], str.data(), str.size());
+
+		mLength = old_size + str.size();
+		mBuffer[mLength] = '\0';
+
+		return *this;
+	}
+
+	string &insert(size_type index, const string &str)
 	{
-		return rfind_string_like(sv, pos);
+		return insert(index, str.view());
 	}
 
-	iterator begin() noexcept { return iterator(mBuffer.get()); }
-	iterator end() noexcept { return iterator(mBuffer.get() + mLength); }
+	string &insert(size_type index, const std::string &str)
+	{
+		return insert(index, std::string_view(str));
+	}
 
-	const_iterator begin() const noexcept { return const_iterator(mBuffer.get()); }
-	const_iterator end() const noexcept { return const_iterator(mBuffer.get() + mLength); }
+	string &insert(size_type index, const char *str)
+	{
+		return insert(index, std::string_view(str));
+	}
 
-	const_iterator cbegin() const noexcept { return const_iterator(mBuffer.get()); }
-	const_iterator cend() const noexcept { return const_iterator(mBuffer.get() + mLength); }
+	string &insert(size_type index, const char *str, size_type count)
+	{
+		return insert(index, std::string_view(str, count));
+	}
 
-	reverse_iterator rbegin() noexcept { return reverse_iterator(mBuffer.get() + mLength - 1); }
-	reverse_iterator rend() noexcept { return reverse_iterator(mBuffer.get() - 1); }
+	string &insert(size_type index, size_type count, char ch)
+	{
+		if (index > size())
+			throw std::out_of_range("invalid string position");
 
-	const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(mBuffer.get() + mLength - 1); }
-	const_reverse_iterator rend() const noexcept { return const_reverse_iterator(mBuffer.get() - 1); }
+		if (count == 0)
+			return *this;
 
-	const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(mBuffer.get() + mLength - 1); }
-	const_reverse_iterator crend() const noexcept { return const_reverse_iterator(mBuffer.get() - 1); }
+		if (count > max_size() - size())
+			throw std::length_error("string too long");
 
-	operator std::string() const { return std_string(); }
-	operator std::string_view() const noexcept { return view(); }
-	operator std::filesystem::path() const { return { view() }; }
+		const size_type old_size = size();
+		reallocate(old_size + count + 1);
 
-	char *data() { return &mBuffer[0]; }
-	const char *data() const { return &mBuffer[0]; }
-	const char *c_str() const { return &mBuffer[0]; }
+		std::memmove(&mBuffer[index + count], &mBuffer[index], old_size - index);
+		std::memset(&mBuffer[index], ch, count);
 
-	std::string_view view() const noexcept { return { data(), size() }; }
-	std::string std_string() const { return { data(), size() }; }
+		mLength = old_size + count;
+		mBuffer[mLength] = '\0';
+
+		return *this;
+	}
+
+	iterator insert(const_iterator position, char ch)
+	{
+		return insert(position, 1, ch);
+	}
+
+	iterator insert(const_iterator position, size_type count, char ch)
+	{
+		// Note: The iterator is invalidated by the reallocation, so hold on to the index instead
+		const size_type index = index_of(position);
+		insert(index, count, ch);
+
+		return begin() + index;
+	}
+
+	void pop_back()
+	{
+		if (!empty())
+		{
+			--mLength;
+			mBuffer[mLength] = '\0';
+		}
+	}
+
+	void push_back(char ch)
+	{
+		resize(size() + 1, ch);
+	}
+
+	string &append(size_type count, char ch)
+	{
+		resize(size() + count, ch);
+		return *this;
+	}
+
+	string &append(const std::string_view &str)
+	{
+		if (!str.empty())
+		{
+			const size_type old_size = size();
+			resize(old_size + str.size());
+
+			std::memcpy(&mBuffer[old_size], str.data(), str.size());
+		}
+
+		return *this;
+	}
+
+	string &append(const string &str)
+	{
+		if (!str.empty())
+		{
+			const size_type old_size = size();
+			resize(old_size + str.size());
+
+			std::memcpy(&mBuffer[old_size], str.data(), str.size());
+		}
+		
+		return *this;
+	}
+
+	string &lowered()
+	{
+		std::transform(cbegin(), cend(), begin(), ::tolower);
+		return *this;
+	}
+
+	string lower() const
+	{
+		string low = *this;
+		std::transform(low.cbegin(), low.cend(), low.begin(), ::tolower);
+
+		return low;
+	}
+
+	string &uppered()
+	{
+		std::transform(cbegin(), cend(), begin(), ::toupper);
+		return *this;
+	}
+
+	string upper() const
+	{
+		string up = *this;
+
+		std::transform(up.cbegin(), up.cend(), up.begin(), ::toupper);
+		return up;
+	}
+
+	string &reversed()
+	{
+		if (size() > 1)
+		{
+			const size_type even = size() % 2;
+
+			for (size_type i = 0; i < size(); ++i)
+			{
+				const size_type back_index = size() - i - 1;
+				std::swap(mBuffer[i], mBuffer[back_index]);
+
+				if (i + 1 == back_index - even)
+					break;
+			}
+		}
+
+		return *this;
+	}
+
+	string reverse() const
+	{
+		if (empty())
+			return {};
+
+		string str(size(), char());
+
+		for (size_type i = 0; i < size(); ++i)
+			str[i] = mBuffer[size() - i - 1];
+
+		return str;
+	}
+
+private:
+
+	string &trim_with(const detail::char_set &set, bool left, bool right)
+	{
+		const std::string_view kept = detail::trimmed_view(view(), set, left, right);
+
+		// Note: Trimming never grows the string, so the contents are shifted down in the same buffer
+		std::memmove(data(), kept.data(), kept.size());
+
+		mLength = kept.size();
+		mBuffer[mLength] = '\0';
+
+		return *this;
+	}
+
+public:
+
+	string &trim() { return trim_with(detail::whitespace_set(), true, true); }
+	string &trim(const std::string_view &chars) { return trim_with(detail::char_set(chars), true, true); }
+
+	string &ltrim() { return trim_with(detail::whitespace_set(), true, false); }
+	string &ltrim(const std::string_view &chars) { return trim_with(detail::char_set(chars), true, false); }
+
+	string &rtrim() { return trim_with(detail::whitespace_set(), false, true); }
+	string &rtrim(const std::string_view &chars) { return trim_with(detail::char_set(chars), false, true); }
+
+private:
+
+	string utf8_case_mapped(const detail::case_table &table, bool ascii_upper) const
+	{
+		// Note: Sized for the worst case expansion and shrunk afterwards, which realloc does in place.
+		// Counting the exact size first costs a second pass over the input, which measured slower on non-ASCII text.
+		string mapped(detail::utf8_case_map_bound(data(), size()), uninitialized_t{});
+
+		mapped.mLength = detail::utf8_case_map(data(), size(), table, ascii_upper, mapped.data()) - mapped.data();
+		mapped.reallocate(mapped.mLength + 1);
+		mapped.mBuffer[mapped.mLength] = '\0';
+
+		return mapped;
+	}
+
+public:
+
+	// Unicode aware versions of lower() and upper(). Mappings that expand (like U+00DF to "SS") are applied,
+	// context sensitive ones (like final sigma) are not.
+	string utf8_lower() const { return utf8_case_mapped(detail::case_lower_table, false); }
+	string utf8_upper() const { return utf8_case_mapped(detail::case_upper_table, true); }
+	string utf8_casefold() const { return utf8_case_mapped(detail::case_fold_table, false); }
+
+	string &utf8_lowered() { return *this = utf8_lower(); }
+	string &utf8_uppered() { return *this = utf8_upper(); }
+	string &utf8_casefolded() { return *this = utf8_casefold(); }
+
+	void split_into(char ch, string_table &out, size_type offset = 0) const
+	{
+		spl::split_into(view(), ch, out, offset);
+	}
+
+	friend spl::string operator+(const std::string_view &lhs, const std::string_view &rhs)
+	{
+		string str(lhs.size() + rhs.size(), char());
+
+		std::memcpy(str.data(), lhs.data(), lhs.size());
+		std::memcpy(str.data() + lhs.size(), rhs.data(), rhs.size());
+
+		return str;
+	}
+
+	friend spl::string operator+(const std::string_view &lhs, char rhs)
+	{
+		string str(lhs.size() + 1, char());
+
+		std::memcpy(str.data(), lhs.data(), lhs.size());
+		std::memcpy(str.data() + lhs.size(), &rhs, sizeof(rhs));
+
+		return str;
+	}
+
+private:
+	size_type mLength = 0;
+	std::unique_ptr<char[], buffer_deleter> mBuffer;
+};
+
+inline string::string()
+{
+	allocate(1);
+	mBuffer[mLength] = '\0';
+}
+
+inline string::string(size_type count, char ch)
+{
+	mLength = count;
+
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
+
+	std::fill_n(&mBuffer[0], mLength, ch);
+}
+
+inline string::string(string &&other) noexcept :
+	mLength(std::exchange(other.mLength, 0)),
+	mBuffer(std::move(other.mBuffer))
+{
+	SPL_STRING_RECORD_STAT(move, mLength);
+}
+
+inline string::string(const string &other)
+{
+	SPL_STRING_RECORD_STAT(copy, other.size());
+
+	mLength = other.size();
+
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
+
+	std::memcpy(&mBuffer[0], other.data(), mLength);
+}
+
+inline string::string(const std::string &str)
+{
+	mLength = str.size();
 
-	bool empty() const noexcept { return mLength == 0; }
-	size_type size() const noexcept { return mLength; }
-	size_type length() const noexcept { return mLength; }
-	size_type max_size() const noexcept { return std::numeric_limits<size_type>::max() - 1; } // -1 for null terminator or npos
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
 
-	void clear()
-	{
-		mLength = 0;
-		reallocate(1);
+	std::memcpy(&mBuffer[0], str.data(), mLength);
+}
 
-		mBuffer[mLength] = '\0';
-	}
+inline string::string(const std::string_view &sv)
+{
+	mLength = sv.size();
 
-	string &erase(size_type index, size_type count = npos)
-	{
-		// Note: According to cppreference, std::string throws only if > size()
-		// Erasing at an index of size() should make the count 0 and erase nothing
-		// But this is still stupid IMHO
-		if (index > size())
-			throw std::out_of_range("invalid string position");
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
 
-		count = std::min(count, size() - index);
-		const size_type end = index + count;
+	std::memcpy(&mBuffer[0], sv.data(), mLength);
+}
 
-		for (size_type i = end; i < size(); ++i)
-			mBuffer[i - count] = mBuffer[i];
+inline string::string(const char *str)
+{
+	mLength = std::char_traits<char>::length(str);
 
-		mLength -= count;
-		mBuffer[mLength] = '\0';
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
 
-		return *this;
-	}
+	std::memcpy(&mBuffer[0], str, mLength);
+}
 
-	iterator erase(const_iterator position)
-	{
-		if (position == cend())
-			return end();
+inline string::string(const char *str, size_type count)
+{
+	mLength = count;
 
-		iterator current = position;
-		iterator next = position + 1;
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
 
-		for (;next != end(); ++next, ++current)
-			*current = *next;
+	std::memcpy(&mBuffer[0], str, mLength);
+}
 
-		mLength -= 1;
-		mBuffer[mLength] = '\0';
+// TODO: Safety?
+inline string::string(const std::string_view &sv, size_type pos, size_type n)
+{
+	mLength = n;
 
-		return empty() ? end() : position;
-	}
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
 
-	iterator erase(const_iterator first, const_iterator last)
-	{
-		const auto range = std::distance(first, last);
+	std::memcpy(&mBuffer[0], &sv[pos], n);
+}
 
-		iterator current = first;
-		iterator next = last;
+inline string::string(size_type count, uninitialized_t)
+{
+	mLength = count;
 
-		for (;next != end(); ++next, ++current)
-			*current = *next;
+	allocate(mLength + 1);
+	mBuffer[mLength] = '\0';
+}
 
-		mLength -= range;
-		mBuffer[mLength] = '\0';
+// Records inserts, erases and replaces by their offset in the original string and applies them all at once.
+// Applying walks the source left to right and builds the result with a single allocation,
+// instead of shifting the tail of the string on every edit.
+class edit_batch
+{
+public:
 
-		return empty() ? end() : first;
-	}
+	using size_type = std::size_t;
 
-	void pop_back()
+	edit_batch &insert(size_type pos, const std::string_view &str)
 	{
-		if (!empty())
-		{
-			--mLength;
-			mBuffer[mLength] = '\0';
-		}
+		return replace(pos, 0, str);
 	}
 
-	void push_back(char ch)
+	edit_batch &erase(size_type pos, size_type count)
 	{
-		resize(size() + 1, ch);
+		return replace(pos, count, {});
 	}
 
-	string &append(size_type count, char ch)
+	edit_batch &replace(size_type pos, size_type count, const std::string_view &str)
 	{
-		resize(size() + count, ch);
+		// Note: Inserted text is copied in so the caller doesn't have to keep it alive until apply()
+		mEdits.push_back({ pos, count, mText.size(), str.size(), mEdits.size() });
+		mText.append(str);
+		mSorted = false;
+
 		return *this;
 	}
 
-	string &append(const std::string_view &str)
+	void reserve(size_type edits, size_type text_bytes = 0)
 	{
-		if (!str.empty())
-		{
-			const size_type old_size = size();
-			resize(old_size + str.size());
-
-			std::memcpy(&mBuffer[old_size], str.data(), str.size());
-		}
+		mEdits.reserve(edits);
+		mText.reserve(text_bytes);
+	}
 
-		return *this;
+	void clear() noexcept
+	{
+		mEdits.clear();
+		mText.clear();
+		mSorted = true;
 	}
 
-	string &append(const string &str)
+	bool empty() const noexcept { return mEdits.empty(); }
+	size_type size() const noexcept { return mEdits.size(); }
+
+	// Edits at the same offset are applied in the order they were recorded, with inserts going before erases.
+	// Throws std::invalid_argument if two edits overlap and std::out_of_range if an edit runs past the end.
+	string apply(const std::string_view &source)
 	{
-		if (!str.empty())
+		sort();
+
+		size_type new_size = source.size();
+		size_type cursor = 0;
+
+		for (const edit &e : mEdits)
 		{
-			const size_type old_size = size();
-			resize(old_size + str.size());
+			if (e.pos > source.size() || e.count > source.size() - e.pos)
+				throw std::out_of_range("invalid string position");
 
-			std::memcpy(&mBuffer[old_size], str.data(), str.size());
+			if (e.pos < cursor)
+				throw std::invalid_argument("overlapping edits");
+
+			cursor = e.pos + e.count;
+			new_size = new_size - e.count + e.text_size;
 		}
-		
-		return *this;
-	}
 
-private:
-	template <typename T>
-	bool starts_with_string_like(const T &str) const noexcept
-	{
-		return str.size() > size() ? false :
-			std::char_traits<char>::compare(data(), str.data(), str.size()) == 0;
-	}
+		string result(new_size, string::uninitialized_t{});
+		char *out = result.data();
 
-public:
+		cursor = 0;
 
-	bool starts_with(const string &str) const noexcept
-	{
-		return starts_with_string_like(str);
-	}
+		for (const edit &e : mEdits)
+		{
+			std::memcpy(out, source.data() + cursor, e.pos - cursor);
+			out += e.pos - cursor;
 
-	bool starts_with(const std::string &str) const noexcept
-	{
-		return starts_with_string_like(str);
-	}
+			std::memcpy(out, mText.data() + e.text_offset, e.text_size);
+			out += e.text_size;
 
-	bool starts_with(const std::string_view &sv) const noexcept
-	{
-		return starts_with_string_like(sv);
-	}
+			cursor = e.pos + e.count;
+		}
 
-	bool starts_with(char c) const noexcept
-	{
-		return empty() ? false : mBuffer[0] == c;
+		std::memcpy(out, source.data() + cursor, source.size() - cursor);
+
+		return result;
 	}
 
-	bool starts_with(const char *str) const noexcept
+	void apply(string &str)
 	{
-		return starts_with(std::string_view(str));
+		if (!empty())
+			str = apply(str.view());
 	}
 
 private:
 
-	template <typename T>
-	bool ends_with_string_like(const T &str) const noexcept
+	struct edit
 	{
-		return str.size() > size() ? false :
-			std::char_traits<char>::compare(&mBuffer[size()] - str.size(), str.data(), str.size()) == 0;
-	}
-
-public:
+		size_type pos;
+		size_type count;
+		size_type text_offset;
+		size_type text_size;
+		size_type sequence;
+	};
 
-	bool ends_with(const string &str) const noexcept
+	void sort()
 	{
-		return ends_with_string_like(str);
-	}
+		if (mSorted)
+			return;
 
-	bool ends_with(const std::string &str) const noexcept
-	{
-		return ends_with_string_like(str);
-	}
+		std::sort(mEdits.begin(), mEdits.end(), [](const edit &lhs, const edit &rhs)
+		{
+			if (lhs.pos != rhs.pos)
+				return lhs.pos < rhs.pos;
 
-	bool ends_with(const std::string_view &sv) const noexcept
-	{
-		return ends_with_string_like(sv);
-	}
+			// Pure inserts at an offset come before anything that consumes characters there
+			if ((lhs.count == 0) != (rhs.count == 0))
+				return lhs.count == 0;
 
-	bool ends_with(char c) const noexcept
-	{
-		return empty() ? false : mBuffer[size() - 1] == c;
-	}
+			return lhs.sequence < rhs.sequence;
+		});
 
-	bool ends_with(const char *str) const
-	{
-		return ends_with(std::string_view(str));
+		mSorted = true;
 	}
 
-	string &lowered()
-	{
-		std::transform(cbegin(), cend(), begin(), ::tolower);
-		return *this;
-	}
+	std::vector<edit> mEdits;
+	std::string mText;
+	bool mSorted = true;
+};
 
-	string lower() const
-	{
-		string low = *this;
-		std::transform(low.cbegin(), low.cend(), low.begin(), ::tolower);
+namespace detail
+{
 
-		return low;
-	}
+constexpr char ascii_lower(char ch) noexcept
+{
+	return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+}
 
-	string &uppered()
-	{
-		std::transform(cbegin(), cend(), begin(), ::toupper);
-		return *this;
-	}
+constexpr char ascii_upper(char ch) noexcept
+{
+	return (ch >= 'a' && ch <= 'z') ? static_cast<char>(ch - ('a' - 'A')) : ch;
+}
 
-	string upper() const
-	{
-		string up = *this;
+}
 
-		std::transform(up.cbegin(), up.cend(), up.begin(), ::toupper);
-		return up;
-	}
+// A string stored inline with room for N characters. It never allocates and can be used in constant expressions.
+template <std::size_t N>
+class fixed_string : public detail::string_view_api<fixed_string<N>>
+{
+public:
 
-	string &reversed()
-	{
-		if (size() > 1)
-		{
-			const size_type even = size() % 2;
+	using size_type = std::size_t;
+	using iterator = char*;
+	using const_iterator = const char*;
 
-			for (size_type i = 0; i < size(); ++i)
-			{
-				const size_type back_index = size() - i - 1;
-				std::swap(mBuffer[i], mBuffer[back_index]);
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
 
-				if (i + 1 == back_index - even)
-					break;
-			}
-		}
+	constexpr fixed_string() noexcept = default;
 
-		return *this;
+	template <std::size_t M>
+	constexpr fixed_string(const char (&str)[M]) noexcept
+	{
+		static_assert(M - 1 <= N, "string literal is too long for this fixed_string");
+		assign(std::string_view(str, M - 1));
 	}
 
-	string reverse() const
+	constexpr explicit fixed_string(const std::string_view &sv)
 	{
-		if (empty())
-			return {};
-
-		string str(size(), char());
-
-		for (size_type i = 0; i < size(); ++i)
-			str[i] = mBuffer[size() - i - 1];
+		assign(sv);
+	}
 
-		return str;
+	constexpr fixed_string(size_type count, char ch)
+	{
+		resize(count, ch);
 	}
 
-	std::string_view split(char ch, size_type offset = 0, split_side side = split_side::left) const
+	constexpr fixed_string &assign(const std::string_view &sv)
 	{
-		// Note: This also serves as an empty() check
-		if (offset >= size())
-			return {};
+		if (sv.size() > N)
+			throw std::length_error("string too long");
 
-		for (size_type i = offset; i < size(); ++i)
-		{
-			if (mBuffer[i] == ch)
-			{
-				switch (side)
-				{
-				case split_side::left:
-					return std::string_view(&mBuffer[offset], i - offset);
-				case split_side::right:
-					if (++i < size())
-						return std::string_view(&mBuffer[i], size() - i);
-					else
-						return {};
-				}
-			}
-		}
+		for (size_type i = 0; i < sv.size(); ++i)
+			mBuffer[i] = sv[i];
 
-		switch (side)
-		{
-		case split_side::left:
-			return std::string_view(&mBuffer[offset], size() - offset);
-		case split_side::right:
-			return {}; // Hit the end, nothing to return on the right
-		}
+		mLength = sv.size();
+		mBuffer[mLength] = '\0';
 
-		return {};
+		return *this;
 	}
 
-private:
+	constexpr char &operator[](size_type pos) { return mBuffer[pos]; }
+	constexpr const char &operator[](size_type pos) const { return mBuffer[pos]; }
 
-	template<typename T>
-	void split_into_vector(char ch, std::vector<T> &out, size_type offset = 0) const
-	{
-		// Note: This also serves as an empty() check
-		if (offset >= size())
-			return;
+	constexpr char *data() noexcept { return mBuffer; }
+	constexpr const char *data() const noexcept { return mBuffer; }
+	constexpr const char *c_str() const noexcept { return mBuffer; }
 
-		size_type last_split = offset;
+	constexpr iterator begin() noexcept { return mBuffer; }
+	constexpr iterator end() noexcept { return mBuffer + mLength; }
+	constexpr const_iterator begin() const noexcept { return mBuffer; }
+	constexpr const_iterator end() const noexcept { return mBuffer + mLength; }
 
-		for (size_type i = offset; i < size(); ++i)
-		{
-			if (mBuffer[i] == ch)
-			{
-				out.emplace_back(T(&mBuffer[last_split], i - last_split));
-				last_split = i + 1;
-			}
-		}
+	constexpr bool empty() const noexcept { return mLength == 0; }
+	constexpr size_type size() const noexcept { return mLength; }
+	constexpr size_type length() const noexcept { return mLength; }
+	constexpr static size_type capacity() noexcept { return N; }
+	constexpr static size_type max_size() noexcept { return N; }
 
-		if (last_split < size())
-			out.emplace_back(T(&mBuffer[last_split], size() - last_split));
-	}
+	constexpr std::string_view view() const noexcept { return { mBuffer, mLength }; }
+	constexpr operator std::string_view() const noexcept { return view(); }
 
-public:
-	void split(char ch, std::vector<string> &out, size_type offset = 0) const
+	std::string std_string() const { return { mBuffer, mLength }; }
+	explicit operator spl::string() const { return spl::string(mBuffer, mLength); }
+
+	constexpr void clear() noexcept
 	{
-		return split_into_vector(ch, out, offset);
+		mLength = 0;
+		mBuffer[0] = '\0';
 	}
 
-	void split(char ch, std::vector<std::string> &out, size_type offset = 0) const
+	constexpr void resize(size_type count, char ch = char())
 	{
-		return split_into_vector(ch, out, offset);
+		if (count > N)
+			throw std::length_error("string too long");
+
+		for (size_type i = mLength; i < count; ++i)
+			mBuffer[i] = ch;
+
+		mLength = count;
+		mBuffer[mLength] = '\0';
 	}
 
-	void split(char ch, std::vector<std::string_view> &out, size_type offset = 0) const
+	constexpr void push_back(char ch)
 	{
-		return split_into_vector(ch, out, offset);
+		resize(mLength + 1, ch);
 	}
 
-	std::string_view rsplit(char ch, size_type roffset = 0, split_side side = split_side::right) const
+	constexpr void pop_back() noexcept
 	{
-		// Note: This also serves as an empty() check
-		if (roffset >= size())
-			return {};
-
-		for (size_type i = size() - roffset; i > 0; --i)
-		{
-			const size_type real_index = i - 1;
-
-			if (mBuffer[real_index] == ch)
-			{
-				switch (side)
-				{
-				case split_side::left:
-					if (--i > 0)
-						return std::string_view(&mBuffer[0], real_index);
-					else
-						return {};
-				case split_side::right:
-					if (i == size())
-						return {};
-
-					return std::string_view(&mBuffer[i], size() - i - roffset);
-				}
-			}
-		}
-
-		switch (side)
-		{
-		case split_side::left:
-			return {}; // Hit the end, nothing to return on the left
-		case split_side::right:
-			return std::string_view(&mBuffer[0], size() - roffset);
-		}
-
-		return {};
+		if (!empty())
+			mBuffer[--mLength] = '\0';
 	}
 
-	template <typename T>
-	T get_as() const
-	{
-		if constexpr (std::is_same_v<T, bool>)
-		{
-			return (bool)get_as<int>();
-		}
-		else
-		{
-			static_assert(std::is_arithmetic_v<T>, "T is not a numeric type");
+	constexpr fixed_string &append(const std::string_view &str)
+	{
+		if (str.size() > N - mLength)
+			throw std::length_error("string too long");
 
-			T value = {};
+		for (size_type i = 0; i < str.size(); ++i)
+			mBuffer[mLength + i] = str[i];
 
-			// Note: Using data() + mLength here because using &mBuffer[mLength] feels wrong even though it's fine.
-			if (data())
-				std::from_chars(data(), data() + mLength, value);
+		mLength += str.size();
+		mBuffer[mLength] = '\0';
 
-			return value;
-		}
+		return *this;
 	}
 
-	friend std::ostream &operator<<(std::ostream &os, const string &str)
+	constexpr fixed_string &operator+=(const std::string_view &str) { return append(str); }
+	constexpr fixed_string &operator+=(char ch) { push_back(ch); return *this; }
+
+	constexpr fixed_string &lowered() noexcept
 	{
-		return os << str.view();
+		for (size_type i = 0; i < mLength; ++i)
+			mBuffer[i] = detail::ascii_lower(mBuffer[i]);
+
+		return *this;
 	}
 
-	friend spl::string operator+(const std::string_view &lhs, const std::string_view &rhs)
+	constexpr fixed_string lower() const noexcept
 	{
-		string str(lhs.size() + rhs.size(), char());
+		fixed_string low = *this;
+		return low.lowered();
+	}
 
-		std::memcpy(str.data(), lhs.data(), lhs.size());
-		std::memcpy(str.data() + lhs.size(), rhs.data(), rhs.size());
+	constexpr fixed_string &uppered() noexcept
+	{
+		for (size_type i = 0; i < mLength; ++i)
+			mBuffer[i] = detail::ascii_upper(mBuffer[i]);
 
-		return str;
+		return *this;
 	}
 
-	friend spl::string operator+(const std::string_view &lhs, char rhs)
+	constexpr fixed_string upper() const noexcept
 	{
-		string str(lhs.size() + 1, char());
+		fixed_string up = *this;
+		return up.uppered();
+	}
 
-		std::memcpy(str.data(), lhs.data(), lhs.size());
-		std::memcpy(str.data() + lhs.size(), &rhs, sizeof(rhs));
+	constexpr fixed_string &reversed() noexcept
+	{
+		for (size_type i = 0; i < mLength / 2; ++i)
+		{
+			const char ch = mBuffer[i];
+			mBuffer[i] = mBuffer[mLength - i - 1];
+			mBuffer[mLength - i - 1] = ch;
+		}
 
-		return str;
+		return *this;
+	}
+
+	constexpr fixed_string reverse() const noexcept
+	{
+		fixed_string str = *this;
+		return str.reversed();
 	}
 
 private:
+	char mBuffer[N + 1] = {};
 	size_type mLength = 0;
-	std::unique_ptr<char[], buffer_deleter> mBuffer;
 };
 
-inline string::string()
+template <std::size_t M>
+fixed_string(const char (&)[M]) -> fixed_string<M - 1>;
+
+class literal;
+
+inline namespace literals
 {
-	allocate(1);
-	mBuffer[mLength] = '\0';
+	constexpr literal operator""_spl(const char *str, std::size_t length) noexcept;
 }
 
-inline string::string(size_type count, char ch)
+// A non-owning reference to a string literal. Only the _spl literal operator makes these, which
+// guarantees the characters have static storage and a null terminator.
+class literal : public detail::string_view_api<literal>
 {
-	mLength = count;
+public:
 
-	allocate(mLength + 1);
-	mBuffer[mLength] = '\0';
+	using size_type = std::size_t;
+	using const_iterator = const char*;
 
-	std::fill_n(&mBuffer[0], mLength, ch);
-}
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
 
-inline string::string(string &&other) noexcept :
-	mLength(std::exchange(other.mLength, 0)),
-	mBuffer(std::move(other.mBuffer))
+	constexpr literal() noexcept = default;
+
+	constexpr const char *data() const noexcept { return mStr; }
+	constexpr const char *c_str() const noexcept { return mStr; }
+
+	constexpr const_iterator begin() const noexcept { return mStr; }
+	constexpr const_iterator end() const noexcept { return mStr + mLength; }
+
+	constexpr bool empty() const noexcept { return mLength == 0; }
+	constexpr size_type size() const noexcept { return mLength; }
+	constexpr size_type length() const noexcept { return mLength; }
+
+	constexpr std::string_view view() const noexcept { return { mStr, mLength }; }
+	constexpr operator std::string_view() const noexcept { return view(); }
+
+	std::string std_string() const { return { mStr, mLength }; }
+
+	// Note: The length is already known, so this is a single allocation and memcpy with no strlen()
+	explicit operator spl::string() const { return spl::string(mStr, mLength); }
+
+	// Note: lowered() and friends return a reference, so without the move the result would be copied
+	spl::string lower() const { return std::move(spl::string(mStr, mLength).lowered()); }
+	spl::string upper() const { return std::move(spl::string(mStr, mLength).uppered()); }
+	spl::string reverse() const { return std::move(spl::string(mStr, mLength).reversed()); }
+
+private:
+
+	friend constexpr literal literals::operator""_spl(const char *str, std::size_t length) noexcept;
+
+	constexpr literal(const char *str, size_type length) noexcept : mStr(str), mLength(length) {}
+
+	const char *mStr = "";
+	size_type mLength = 0;
+};
+
+inline namespace literals
 {
+	constexpr literal operator""_spl(const char *str, std::size_t length) noexcept
+	{
+		return literal(str, length);
+	}
 }
 
-inline string::string(const string &other)
+// A non-owning reference to characters that live somewhere else, like a slice of a receive buffer, with the same
+// read-only API as spl::string. Nothing is copied until you ask for an owning string, and everything that picks out
+// part of the text hands back a view into the same characters. Like std::string_view, the characters have to outlive
+// the string_ref and there's no null terminator.
+class string_ref : public detail::string_view_api<string_ref>
 {
-	mLength = other.size();
+public:
 
-	allocate(mLength + 1);
-	mBuffer[mLength] = '\0';
+	using size_type = std::size_t;
+	using const_iterator = const char*;
 
-	std::memcpy(&mBuffer[0], other.data(), mLength);
-}
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
 
-inline string::string(const std::string &str)
-{
-	mLength = str.size();
+	constexpr string_ref() noexcept = default;
+	constexpr string_ref(const char *str, size_type length) noexcept : mStr(str), mLength(length) {}
+	constexpr string_ref(const char *str) noexcept : string_ref(std::string_view(str)) {}
+	constexpr string_ref(const std::string_view &sv) noexcept : mStr(sv.data()), mLength(sv.size()) {}
+	string_ref(const std::string &str) noexcept : mStr(str.data()), mLength(str.size()) {}
 
-	allocate(mLength + 1);
-	mBuffer[mLength] = '\0';
+	// spl::string, fixed_string, literal and anything else built on the same helpers
+	template <typename T, typename = std::enable_if_t<std::is_base_of_v<detail::string_view_api_tag, T>>>
+	constexpr string_ref(const T &str) noexcept : string_ref(str.view()) {}
 
-	std::memcpy(&mBuffer[0], str.data(), mLength);
-}
+	constexpr const char *data() const noexcept { return mStr; }
 
-inline string::string(const std::string_view &sv)
-{
-	mLength = sv.size();
+	constexpr const_iterator begin() const noexcept { return mStr; }
+	constexpr const_iterator end() const noexcept { return mStr + mLength; }
 
-	allocate(mLength + 1);
-	mBuffer[mLength] = '\0';
+	constexpr bool empty() const noexcept { return mLength == 0; }
+	constexpr size_type size() const noexcept { return mLength; }
+	constexpr size_type length() const noexcept { return mLength; }
 
-	std::memcpy(&mBuffer[0], sv.data(), mLength);
-}
+	constexpr std::string_view view() const noexcept { return { mStr, mLength }; }
+	constexpr operator std::string_view() const noexcept { return view(); }
 
-inline string::string(const char *str)
-{
-	mLength = std::char_traits<char>::length(str);
+	constexpr const char &at(size_type pos) const
+	{
+		if (pos >= mLength)
+			throw std::out_of_range("invalid string position");
 
-	allocate(mLength + 1);
-	mBuffer[mLength] = '\0';
+		return mStr[pos];
+	}
 
-	std::memcpy(&mBuffer[0], str, mLength);
-}
+	constexpr string_ref substr(size_type pos = 0, size_type count = npos) const
+	{
+		if (pos > mLength)
+			throw std::out_of_range("invalid string position");
 
-inline string::string(const char *str, size_type count)
-{
-	mLength = count;
+		return string_ref(mStr + pos, std::min(count, mLength - pos));
+	}
 
-	allocate(mLength + 1);
-	mBuffer[mLength] = '\0';
+	constexpr void remove_prefix(size_type count) noexcept
+	{
+		mStr += count;
+		mLength -= count;
+	}
 
-	std::memcpy(&mBuffer[0], str, mLength);
-}
+	constexpr void remove_suffix(size_type count) noexcept
+	{
+		mLength -= count;
+	}
 
-// TODO: Safety?
-inline string::string(const std::string_view &sv, size_type pos, size_type n)
-{
-	mLength = n;
+	std::string std_string() const { return { mStr, mLength }; }
+	explicit operator spl::string() const { return spl::string(mStr, mLength); }
 
-	allocate(mLength + 1);
-	mBuffer[mLength] = '\0';
+	// Note: These have to make a string anyway, so it's one allocation that's then changed in place
+	spl::string lower() const { return std::move(spl::string(mStr, mLength).lowered()); }
+	spl::string upper() const { return std::move(spl::string(mStr, mLength).uppered()); }
+	spl::string reverse() const { return std::move(spl::string(mStr, mLength).reversed()); }
 
-	std::memcpy(&mBuffer[0], &sv[pos], n);
-}
+	void split_into(char ch, string_table &out, size_type offset = 0) const
+	{
+		spl::split_into(view(), ch, out, offset);
+	}
+
+private:
+
+	const char *mStr = "";
+	size_type mLength = 0;
+};
 
 template<typename T>
 string to_string(T value)
@@ -1163,7 +2965,7 @@ string to_string(T value)
 
 // Extra logic for standard strings
 
-inline bool contains(const std::string_view &str, const std::string_view &substring)
+constexpr bool contains(const std::string_view &str, const std::string_view &substring)
 {
 	if (substring.size() > str.size())
 		return false;
@@ -1174,10 +2976,32 @@ inline bool contains(const std::string_view &str, const std::string_view &substr
 
 	const std::size_t difference = str.size() - substring.size();
 
-	for (std::size_t i = 0; i <= difference; ++i)
+	if (detail::is_constant_evaluated())
+	{
+		for (std::size_t i = 0; i <= difference; ++i)
+		{
+			if (compare_equal(&str[i], substring.data(), substring.size()))
+				return true;
+		}
+
+		return false;
+	}
+
+	// Let memchr() find candidates for the first character, it's vectorized in every libc worth using
+	const char *current = str.data();
+	const char *last = str.data() + difference;
+
+	while (current <= last)
 	{
-		if (compare_equal(&str[i], substring.data(), substring.size()))
+		current = static_cast<const char*>(std::memchr(current, substring[0], last - current + 1));
+
+		if (!current)
+			return false;
+
+		if (compare_equal(current + 1, substring.data() + 1, substring.size() - 1))
 			return true;
+
+		++current;
 	}
 
 	return false;
@@ -1243,6 +3067,73 @@ inline std::string reverse(const std::string_view &view)
 	return str;
 }
 
+inline bool is_valid_utf8(const std::string_view &view)
+{
+	return detail::validate_utf8(view.data(), view.size());
+}
+
+inline std::size_t utf8_length(const std::string_view &view)
+{
+	return detail::count_utf8_leads(view.data(), view.size());
+}
+
+inline std::string_view utf8_substr(const std::string_view &view, std::size_t cp_offset, std::size_t cp_count = string::npos)
+{
+	const std::size_t first = detail::utf8_advance(view.data(), view.size(), cp_offset);
+	const std::size_t count = cp_count == string::npos ? view.size() - first : detail::utf8_advance(view.data() + first, view.size() - first, cp_count);
+
+	return view.substr(first, count);
+}
+
+inline std::string utf8_lower(const std::string_view &view)
+{
+	return detail::utf8_case_mapped(view, detail::case_lower_table, false);
+}
+
+inline std::string utf8_upper(const std::string_view &view)
+{
+	return detail::utf8_case_mapped(view, detail::case_upper_table, true);
+}
+
+inline std::string utf8_casefold(const std::string_view &view)
+{
+	return detail::utf8_case_mapped(view, detail::case_fold_table, false);
+}
+
+constexpr std::string_view trimmed_view(const std::string_view &view) { return detail::whitespace_trimmed_view(view, true, true); }
+constexpr std::string_view trimmed_view(const std::string_view &view, const std::string_view &chars) { return detail::trimmed_view(view, detail::char_set(chars), true, true); }
+
+constexpr std::string_view ltrimmed_view(const std::string_view &view) { return detail::whitespace_trimmed_view(view, true, false); }
+constexpr std::string_view ltrimmed_view(const std::string_view &view, const std::string_view &chars) { return detail::trimmed_view(view, detail::char_set(chars), true, false); }
+
+constexpr std::string_view rtrimmed_view(const std::string_view &view) { return detail::whitespace_trimmed_view(view, false, true); }
+constexpr std::string_view rtrimmed_view(const std::string_view &view, const std::string_view &chars) { return detail::trimmed_view(view, detail::char_set(chars), false, true); }
+
+namespace detail
+{
+
+inline std::string &trim_with(std::string &str, const char_set &set, bool left, bool right)
+{
+	const std::string_view kept = trimmed_view(str, set, left, right);
+	const std::size_t first = kept.data() - str.data();
+
+	str.erase(first + kept.size());
+	str.erase(0, first);
+
+	return str;
+}
+
+}
+
+inline std::string &trim(std::string &str) { return detail::trim_with(str, detail::whitespace_set(), true, true); }
+inline std::string &trim(std::string &str, const std::string_view &chars) { return detail::trim_with(str, detail::char_set(chars), true, true); }
+
+inline std::string &ltrim(std::string &str) { return detail::trim_with(str, detail::whitespace_set(), true, false); }
+inline std::string &ltrim(std::string &str, const std::string_view &chars) { return detail::trim_with(str, detail::char_set(chars), true, false); }
+
+inline std::string &rtrim(std::string &str) { return detail::trim_with(str, detail::whitespace_set(), false, true); }
+inline std::string &rtrim(std::string &str, const std::string_view &chars) { return detail::trim_with(str, detail::char_set(chars), false, true); }
+
 inline void split(const std::string_view &view, char ch, std::vector<std::string_view> &out, std::size_t offset = 0)
 {
 	// Note: This also serves as an empty() check
@@ -1264,6 +3155,118 @@ inline void split(const std::string_view &view, char ch, std::vector<std::string
 		out.emplace_back(std::string_view(&view[last_split], view.size() - last_split));
 }
 
+
+// Number of pieces split() would produce, usable at compile time to size a split_array()
+constexpr std::size_t split_count(const std::string_view &view, char ch, std::size_t offset = 0) noexcept
+{
+	// Note: This also serves as an empty() check
+	if (offset >= view.size())
+		return 0;
+
+	std::size_t count = 0;
+	std::size_t last_split = offset;
+
+	for (std::size_t i = offset; i < view.size(); ++i)
+	{
+		if (view[i] == ch)
+		{
+			++count;
+			last_split = i + 1;
+		}
+	}
+
+	return last_split < view.size() ? count + 1 : count;
+}
+
+// Like split(), but into a std::array so it can be done at compile time. N has to match split_count().
+template <std::size_t N>
+constexpr std::array<std::string_view, N> split_array(const std::string_view &view, char ch, std::size_t offset = 0)
+{
+	if (split_count(view, ch, offset) != N)
+		throw std::length_error("split count does not match the array size");
+
+	std::array<std::string_view, N> out = {};
+	std::size_t count = 0;
+	std::size_t last_split = offset;
+
+	for (std::size_t i = offset; i < view.size(); ++i)
+	{
+		if (view[i] == ch)
+		{
+			out[count++] = view.substr(last_split, i - last_split);
+			last_split = i + 1;
+		}
+	}
+
+	if (last_split < view.size())
+		out[count] = view.substr(last_split);
+
+	return out;
+}
+
+// 64-bit FNV-1a. Unlike std::hash, it is constexpr and gives the same value on every platform and run.
+// Passing the previous result as hash continues it, so data can be hashed in pieces.
+constexpr std::uint64_t hash_fnv1a(const std::string_view &view, std::uint64_t hash = 0xCBF29CE484222325ull) noexcept
+{
+	for (const char ch : view)
+	{
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
+
+// A list of strings split and hashed at compile time, for things like header or method name tables.
+// The views point into the source literal, so a constexpr list lives entirely in read-only data.
+//
+//	inline constexpr char methods_text[] = "GET,HEAD,POST,PUT";
+//	constexpr auto methods = spl::make_string_list<spl::split_count(methods_text, ',')>(methods_text, ',');
+//	static_assert(methods.find("POST") == 2);
+template <std::size_t N>
+struct static_string_list
+{
+	constexpr static std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+	std::array<std::string_view, N> strings = {};
+	std::array<std::uint64_t, N> hashes = {};
+
+	constexpr std::size_t size() const noexcept { return N; }
+	constexpr const std::string_view &operator[](std::size_t index) const { return strings[index]; }
+
+	constexpr auto begin() const noexcept { return strings.begin(); }
+	constexpr auto end() const noexcept { return strings.end(); }
+
+	constexpr std::size_t find(const std::string_view &str) const noexcept
+	{
+		const std::uint64_t hash = hash_fnv1a(str);
+
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			if (hashes[i] == hash && strings[i] == str)
+				return i;
+		}
+
+		return npos;
+	}
+
+	constexpr bool contains(const std::string_view &str) const noexcept
+	{
+		return find(str) != npos;
+	}
+};
+
+template <std::size_t N>
+constexpr static_string_list<N> make_string_list(const std::string_view &text, char ch)
+{
+	static_string_list<N> list;
+	list.strings = split_array<N>(text, ch);
+
+	for (std::size_t i = 0; i < N; ++i)
+		list.hashes[i] = hash_fnv1a(list.strings[i]);
+
+	return list;
+}
 }
 
 // Hashing so spl::string can be used in containers like std::unordered_map
@@ -1278,4 +3281,28 @@ namespace std
 			return std::hash<std::string_view>{}(str);
 		}
 	};
+
+	template<std::size_t N> struct hash<spl::fixed_string<N>>
+	{
+		std::size_t operator()(const spl::fixed_string<N> &str) const noexcept
+		{
+			return std::hash<std::string_view>{}(str.view());
+		}
+	};
+
+	template<> struct hash<spl::literal>
+	{
+		std::size_t operator()(const spl::literal &str) const noexcept
+		{
+			return std::hash<std::string_view>{}(str.view());
+		}
+	};
+
+	template<> struct hash<spl::string_ref>
+	{
+		std::size_t operator()(const spl::string_ref &str) const noexcept
+		{
+			return std::hash<std::string_view>{}(str.view());
+		}
+	};
 }
\ No newline at end of file
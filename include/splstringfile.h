@@ -0,0 +1,590 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+#include <fstream>
+#include <system_error>
+
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// A file format for large string collections that can be used straight out of a memory mapping.
+//
+// Layout, all integers in the writer's native byte order (the reader refuses files with a different one):
+//
+//	header        string_table_file_header, 80 bytes
+//	blob          every string back to back
+//	padding       to a multiple of 8
+//	offsets       count + 1 uint64, string i is blob[offsets[i], offsets[i + 1])
+//	index         optional, index_slots uint64 of (hash >> 32) << 32 | (i + 1), linear probing, 0 = empty
+//
+// The checksum is 64-bit FNV-1a over every byte after the header. Opening a file only checks the header, so it
+// takes the same time for ten strings or ten million; call verify() to check the checksum and offsets as well.
+
+namespace spl
+{
+
+struct string_table_file_header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t flags;
+	std::uint32_t byte_order;
+	std::uint32_t reserved;
+	std::uint64_t count;
+	std::uint64_t blob_offset;
+	std::uint64_t blob_size;
+	std::uint64_t offsets_offset;
+	std::uint64_t index_offset;
+	std::uint64_t index_slots;
+	std::uint64_t checksum;
+};
+
+static_assert(sizeof(string_table_file_header) == 80);
+
+namespace detail
+{
+
+inline constexpr char string_table_file_magic[8] = { 'S', 'P', 'L', 'S', 'T', 'R', 'T', '\x1a' };
+constexpr std::uint32_t string_table_file_version = 1;
+constexpr std::uint32_t string_table_file_byte_order = 0x01020304;
+constexpr std::uint32_t string_table_file_has_index = 1;
+
+inline std::uint64_t string_table_index_slots(std::uint64_t count) noexcept
+{
+	// Keeps the load factor at or below one half
+	std::uint64_t slots = 16;
+
+	while (slots < count * 2)
+		slots *= 2;
+
+	return slots;
+}
+
+// A read-only memory mapping of a whole file. what names the kind of file in error messages.
+class mapped_file
+{
+public:
+
+	mapped_file() = default;
+
+	mapped_file(const std::filesystem::path &path, const char *what, std::size_t min_size)
+	{
+#if defined(_WIN32)
+		mFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (mFile == INVALID_HANDLE_VALUE)
+			throw std::filesystem::filesystem_error(std::string("cannot open ") + what, path, std::error_code(GetLastError(), std::system_category()));
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(mFile, &size))
+		{
+			const DWORD error = GetLastError();
+			unmap();
+			throw std::filesystem::filesystem_error(std::string("cannot open ") + what, path, std::error_code(error, std::system_category()));
+		}
+
+		mSize = static_cast<std::size_t>(size.QuadPart);
+
+		if (mSize < min_size)
+		{
+			unmap();
+			throw std::filesystem::filesystem_error(std::string("not a ") + what + " file", path, std::make_error_code(std::errc::invalid_argument));
+		}
+
+		mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		mData = mMapping ? static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+
+		if (!mData)
+		{
+			const DWORD error = GetLastError();
+			unmap();
+			throw std::filesystem::filesystem_error(std::string("cannot map ") + what, path, std::error_code(error, std::system_category()));
+		}
+#else
+		const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+		if (fd < 0)
+			throw std::filesystem::filesystem_error(std::string("cannot open ") + what, path, std::error_code(errno, std::generic_category()));
+
+		struct stat info;
+
+		if (::fstat(fd, &info) != 0)
+		{
+			const int error = errno;
+			::close(fd);
+			throw std::filesystem::filesystem_error(std::string("cannot open ") + what, path, std::error_code(error, std::generic_category()));
+		}
+
+		const std::size_t size = static_cast<std::size_t>(info.st_size);
+
+		if (size < min_size)
+		{
+			::close(fd);
+			throw std::filesystem::filesystem_error(std::string("not a ") + what + " file", path, std::make_error_code(std::errc::invalid_argument));
+		}
+
+		void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		const int error = errno;
+		::close(fd);
+
+		if (data == MAP_FAILED)
+			throw std::filesystem::filesystem_error(std::string("cannot map ") + what, path, std::error_code(error, std::generic_category()));
+
+		mData = static_cast<const char*>(data);
+		mSize = size;
+#endif
+	}
+
+	mapped_file(mapped_file &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	mapped_file &operator=(mapped_file &&rhs) noexcept
+	{
+		if (&rhs == this)
+			return *this;
+
+		unmap();
+
+		mData = std::exchange(rhs.mData, nullptr);
+		mSize = std::exchange(rhs.mSize, 0);
+#if defined(_WIN32)
+		mFile = std::exchange(rhs.mFile, INVALID_HANDLE_VALUE);
+		mMapping = std::exchange(rhs.mMapping, nullptr);
+#endif
+
+		return *this;
+	}
+
+	mapped_file(const mapped_file &) = delete;
+	mapped_file &operator=(const mapped_file &) = delete;
+
+	~mapped_file()
+	{
+		unmap();
+	}
+
+	const char *data() const noexcept { return mData; }
+	std::size_t size() const noexcept { return mSize; }
+
+	void unmap() noexcept
+	{
+#if defined(_WIN32)
+		if (mData)
+			UnmapViewOfFile(mData);
+
+		if (mMapping)
+			CloseHandle(mMapping);
+
+		if (mFile != INVALID_HANDLE_VALUE)
+			CloseHandle(mFile);
+
+		mMapping = nullptr;
+		mFile = INVALID_HANDLE_VALUE;
+#else
+		if (mData)
+			::munmap(const_cast<char*>(mData), mSize);
+#endif
+
+		mData = nullptr;
+		mSize = 0;
+	}
+
+private:
+
+	const char *mData = nullptr;
+	std::size_t mSize = 0;
+
+#if defined(_WIN32)
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+#endif
+};
+
+}
+
+// Writes strings to a file as they come. Only the offsets (and hashes, for the index) are kept in memory,
+// the strings themselves go straight to disk.
+class string_table_writer
+{
+public:
+
+	explicit string_table_writer(const std::filesystem::path &path, bool hash_index = true) :
+		mPath(path),
+		mFile(path, std::ios::binary | std::ios::trunc),
+		mHashIndex(hash_index)
+	{
+		if (!mFile)
+			throw std::filesystem::filesystem_error("cannot create string table", path, std::make_error_code(std::errc::io_error));
+
+		// Filled in by finish() once the sizes are known
+		const string_table_file_header header {};
+		mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+
+	string_table_writer(const string_table_writer &) = delete;
+	string_table_writer &operator=(const string_table_writer &) = delete;
+
+	// Note: Finishes the file if finish() wasn't called, but can't report errors from here
+	~string_table_writer()
+	{
+		if (!mFinished)
+		{
+			try
+			{
+				finish();
+			}
+			catch (...)
+			{
+			}
+		}
+	}
+
+	void push_back(const std::string_view &str)
+	{
+		if (mHashIndex && mOffsets.size() > std::numeric_limits<std::uint32_t>::max() - 1)
+			throw std::length_error("too many strings for a hash index");
+
+		write(str);
+		mOffsets.push_back(mOffsets.back() + str.size());
+
+		if (mHashIndex)
+			mHashes.push_back(hash_fnv1a(str));
+	}
+
+	std::size_t size() const noexcept { return mOffsets.size() - 1; }
+
+	void finish()
+	{
+		if (mFinished)
+			return;
+
+		mFinished = true;
+
+		string_table_file_header header {};
+		std::memcpy(header.magic, detail::string_table_file_magic, sizeof(header.magic));
+		header.version = detail::string_table_file_version;
+		header.byte_order = detail::string_table_file_byte_order;
+		header.count = size();
+		header.blob_offset = sizeof(header);
+		header.blob_size = mOffsets.back();
+
+		const std::uint64_t padding = (8 - (header.blob_offset + header.blob_size) % 8) % 8;
+		write(std::string_view("\0\0\0\0\0\0\0", padding));
+
+		header.offsets_offset = header.blob_offset + header.blob_size + padding;
+		write_words(mOffsets.data(), mOffsets.size());
+
+		if (mHashIndex)
+		{
+			header.flags |= detail::string_table_file_has_index;
+			header.index_offset = header.offsets_offset + mOffsets.size() * sizeof(std::uint64_t);
+			header.index_slots = detail::string_table_index_slots(size());
+
+			std::vector<std::uint64_t> slots(header.index_slots, 0);
+			const std::uint64_t mask = header.index_slots - 1;
+
+			for (std::size_t i = 0; i < mHashes.size(); ++i)
+			{
+				std::uint64_t slot = mHashes[i] & mask;
+
+				while (slots[slot])
+					slot = (slot + 1) & mask;
+
+				slots[slot] = (mHashes[i] >> 32 << 32) | (i + 1);
+			}
+
+			write_words(slots.data(), slots.size());
+		}
+
+		header.checksum = mChecksum;
+
+		mFile.seekp(0);
+		mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		mFile.close();
+
+		if (!mFile)
+			throw std::filesystem::filesystem_error("failed to write string table", mPath, std::make_error_code(std::errc::io_error));
+	}
+
+private:
+
+	void write(const std::string_view &bytes)
+	{
+		mFile.write(bytes.data(), bytes.size());
+		mChecksum = hash_fnv1a(bytes, mChecksum);
+	}
+
+	void write_words(const std::uint64_t *words, std::size_t count)
+	{
+		write(std::string_view(reinterpret_cast<const char*>(words), count * sizeof(std::uint64_t)));
+	}
+
+	std::filesystem::path mPath;
+	std::ofstream mFile;
+	bool mHashIndex;
+	bool mFinished = false;
+	std::uint64_t mChecksum = hash_fnv1a(std::string_view());
+	std::vector<std::uint64_t> mOffsets { 0 };
+	std::vector<std::uint64_t> mHashes;
+};
+
+inline void write_string_table(const std::filesystem::path &path, const string_table &table, bool hash_index = true)
+{
+	string_table_writer writer(path, hash_index);
+
+	for (const std::string_view str : table)
+		writer.push_back(str);
+
+	writer.finish();
+}
+
+// A read-only view of a file written by string_table_writer. Strings are string_views straight into the mapping
+// and stay valid for as long as the mapped_string_table does.
+class mapped_string_table
+{
+public:
+
+	using size_type = std::size_t;
+
+	constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+	mapped_string_table() = default;
+
+	explicit mapped_string_table(const std::filesystem::path &path) :
+		mFile(path, "string table", sizeof(string_table_file_header))
+	{
+		mData = mFile.data();
+		mSize = mFile.size();
+
+		validate_header(path);
+	}
+
+	mapped_string_table(mapped_string_table &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	mapped_string_table &operator=(mapped_string_table &&rhs) noexcept
+	{
+		if (&rhs == this)
+			return *this;
+
+		mFile = std::move(rhs.mFile);
+		mData = std::exchange(rhs.mData, nullptr);
+		mSize = std::exchange(rhs.mSize, 0);
+		mCount = std::exchange(rhs.mCount, 0);
+		mBlob = std::exchange(rhs.mBlob, nullptr);
+		mBlobSize = std::exchange(rhs.mBlobSize, 0);
+		mOffsets = std::exchange(rhs.mOffsets, nullptr);
+		mIndex = std::exchange(rhs.mIndex, nullptr);
+		mIndexSlots = std::exchange(rhs.mIndexSlots, 0);
+
+		return *this;
+	}
+
+	mapped_string_table(const mapped_string_table &) = delete;
+	mapped_string_table &operator=(const mapped_string_table &) = delete;
+
+	size_type size() const noexcept { return mCount; }
+	bool empty() const noexcept { return mCount == 0; }
+
+	// Total bytes of all strings
+	size_type bytes() const noexcept { return mBlobSize; }
+
+	bool has_index() const noexcept { return mIndex != nullptr; }
+
+	std::string_view operator[](size_type index) const noexcept
+	{
+		return std::string_view(mBlob + mOffsets[index], mOffsets[index + 1] - mOffsets[index]);
+	}
+
+	// Also checks the offsets stored in the file, so a corrupt entry throws rather than reading outside the mapping
+	std::string_view at(size_type index) const
+	{
+		if (index >= size())
+			throw std::out_of_range("invalid string table index");
+
+		if (!offsets_valid(index))
+			throw std::runtime_error("corrupt string table offsets");
+
+		return (*this)[index];
+	}
+
+	// Index of the first string equal to key, or npos. Without a hash index this is a linear scan.
+	size_type find(const std::string_view &key) const noexcept
+	{
+		if (!mIndex)
+		{
+			for (size_type i = 0; i < size(); ++i)
+			{
+				if (offsets_valid(i) && (*this)[i] == key)
+					return i;
+			}
+
+			return npos;
+		}
+
+		const std::uint64_t hash = hash_fnv1a(key);
+		const std::uint64_t tag = hash >> 32 << 32;
+		const std::uint64_t mask = mIndexSlots - 1;
+
+		// Note: Bounded by the slot count, and entries are checked like at() does, so a corrupt index or offsets
+		// section is a miss rather than a hang or a read outside the mapping
+		std::uint64_t slot = hash & mask;
+
+		for (std::uint64_t probes = 0; probes < mIndexSlots && mIndex[slot]; ++probes, slot = (slot + 1) & mask)
+		{
+			const std::uint64_t entry = mIndex[slot];
+			const size_type index = static_cast<size_type>(entry & 0xFFFFFFFFull) - 1;
+
+			if ((entry & ~0xFFFFFFFFull) == tag && index < size() && offsets_valid(index) && (*this)[index] == key)
+				return index;
+		}
+
+		return npos;
+	}
+
+	bool contains(const std::string_view &key) const noexcept
+	{
+		return find(key) != npos;
+	}
+
+	// Reads the whole file to check the checksum and that every offset is in range. Linear in the file size.
+	bool verify() const noexcept
+	{
+		if (!mData)
+			return false;
+
+		const string_table_file_header &header = *reinterpret_cast<const string_table_file_header*>(mData);
+		const std::string_view body(mData + sizeof(header), mSize - sizeof(header));
+
+		if (hash_fnv1a(body) != header.checksum)
+			return false;
+
+		if (mOffsets[0] != 0 || mOffsets[mCount] != mBlobSize)
+			return false;
+
+		for (size_type i = 0; i < mCount; ++i)
+		{
+			if (mOffsets[i] > mOffsets[i + 1])
+				return false;
+		}
+
+		return true;
+	}
+
+	void to_table(string_table &out) const
+	{
+		out.reserve(out.size() + size(), out.bytes() + bytes());
+
+		for (size_type i = 0; i < size(); ++i)
+			out.push_back((*this)[i]);
+	}
+
+private:
+
+	// Only looks at the header and section bounds, so opening is constant time
+	void validate_header(const std::filesystem::path &path)
+	{
+		string_table_file_header header;
+		std::memcpy(&header, mData, sizeof(header));
+
+		const auto fail = [&path](const char *what)
+		{
+			throw std::filesystem::filesystem_error(what, path, std::make_error_code(std::errc::invalid_argument));
+		};
+
+		if (std::memcmp(header.magic, detail::string_table_file_magic, sizeof(header.magic)) != 0)
+			fail("not a string table file");
+
+		if (header.version != detail::string_table_file_version)
+			fail("unsupported string table version");
+
+		if (header.byte_order != detail::string_table_file_byte_order)
+			fail("string table was written with a different byte order");
+
+		const std::uint64_t size = mSize;
+		const auto fits = [size](std::uint64_t offset, std::uint64_t count, std::uint64_t element_size)
+		{
+			return offset <= size && count <= (size - offset) / element_size;
+		};
+
+		if (!fits(header.blob_offset, header.blob_size, 1) || header.count >= size / sizeof(std::uint64_t) ||
+			header.offsets_offset % sizeof(std::uint64_t) != 0 || !fits(header.offsets_offset, header.count + 1, sizeof(std::uint64_t)))
+			fail("string table sections are out of bounds");
+
+		if (header.flags & detail::string_table_file_has_index)
+		{
+			if (header.index_offset % sizeof(std::uint64_t) != 0 || header.index_slots == 0 ||
+				(header.index_slots & (header.index_slots - 1)) != 0 || !fits(header.index_offset, header.index_slots, sizeof(std::uint64_t)))
+				fail("string table index is out of bounds");
+
+			mIndex = reinterpret_cast<const std::uint64_t*>(mData + header.index_offset);
+			mIndexSlots = header.index_slots;
+		}
+
+		mCount = static_cast<size_type>(header.count);
+		mBlob = mData + header.blob_offset;
+		mBlobSize = static_cast<size_type>(header.blob_size);
+		mOffsets = reinterpret_cast<const std::uint64_t*>(mData + header.offsets_offset);
+	}
+
+	// The offsets come straight from the file, so they're only trusted once they're in order and inside the blob
+	bool offsets_valid(size_type index) const noexcept
+	{
+		return mOffsets[index] <= mOffsets[index + 1] && mOffsets[index + 1] <= mBlobSize;
+	}
+
+	detail::mapped_file mFile;
+	const char *mData = nullptr;
+	size_type mSize = 0;
+
+	size_type mCount = 0;
+	const char *mBlob = nullptr;
+	size_type mBlobSize = 0;
+	const std::uint64_t *mOffsets = nullptr;
+	const std::uint64_t *mIndex = nullptr;
+	std::uint64_t mIndexSlots = 0;
+};
+
+}
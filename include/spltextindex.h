@@ -0,0 +1,840 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splsort.h"
+#include "splstringfile.h"
+
+// An index over a fixed text for answering lots of substring queries without scanning the text each time.
+//
+//	const spl::text_index index(corpus);
+//	index.count("needle");      // Number of occurrences
+//	index.locate("needle");     // Every position, in order
+//
+// It's built around the suffix array, every suffix of the text in sorted order, which puts all occurrences of
+// a pattern next to each other. The suffix array is built with SA-IS (Nong, Zhang and Chan), in linear time.
+//
+// text_index_mode::suffix_array keeps a copy of the text and the suffix array, 5 bytes per byte of text, and
+// finds a pattern's range of suffixes with a binary search, O(m log n) for a pattern of m bytes.
+//
+// text_index_mode::fm_index keeps the Burrows-Wheeler transform instead (Ferragina and Manzini), plus rank tables
+// and one suffix array entry out of every sample_rate, about 1.5 to 2 bytes per byte of text. count() is O(m) rank
+// queries. locate() steps backwards through the text from each match to the nearest sample, so it costs up to
+// sample_rate steps per occurrence. Rank tables store counts at every 512 rows, and a rank query counts at most
+// 256 bytes of the transform with SIMD, from whichever end is closer.
+//
+// The index is one block of memory laid out exactly like its file, so save() writes it out as-is and open()
+// memory maps a saved index and uses it in place. Like the string table files, integers are in native byte order
+// and opening only checks the header; verify() checks the checksum.
+//
+// Texts must be shorter than 4 GiB - 1 bytes, since positions are stored in 32 bits.
+
+namespace spl
+{
+
+enum class text_index_mode : std::uint32_t
+{
+	suffix_array,
+	fm_index
+};
+
+struct text_index_options
+{
+	text_index_mode mode = text_index_mode::suffix_array;
+	std::uint32_t sample_rate = 32;    // fm_index: keeps the position of every sample_rate-th text offset
+	bool parallel = false;             // Build the fm_index tables on several threads
+	unsigned threads = 0;              // 0 = std::thread::hardware_concurrency()
+};
+
+struct text_index_file_header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t mode;
+	std::uint32_t byte_order;
+	std::uint32_t sample_rate;
+	std::uint64_t text_size;
+	std::uint64_t primary;          // fm_index: the row of the transform that stands for the end of the text
+	std::uint64_t sections[8];      // Offsets of the sections, see text_index_section
+	std::uint64_t checksum;
+};
+
+static_assert(sizeof(text_index_file_header) == 112);
+
+// fm_index: where the suffixes starting with each byte begin, and each byte's column in the rank tables
+struct text_index_alphabet
+{
+	std::uint64_t first[257];       // first[256] is the number of rows
+	std::uint32_t sigma;            // Number of distinct bytes
+	std::uint32_t reserved;
+	std::uint8_t code[256];
+};
+
+namespace detail
+{
+
+inline constexpr char text_index_file_magic[8] = { 'S', 'P', 'L', 'T', 'I', 'D', 'X', '\x1a' };
+constexpr std::uint32_t text_index_file_version = 1;
+constexpr std::uint32_t text_index_file_byte_order = 0x01020304;
+
+constexpr std::uint32_t sais_empty = 0xFFFFFFFFu;
+constexpr std::size_t text_index_max_size = 0xFFFFFFFEu;
+
+constexpr std::size_t text_index_block = 512;                  // Rows between block counts
+constexpr std::size_t text_index_superblock = 65536;           // Rows between superblock counts, so block counts fit in 16 bits
+constexpr std::size_t text_index_blocks_per_superblock = text_index_superblock / text_index_block;
+
+enum text_index_section
+{
+	// suffix_array
+	text_section_text,
+	text_section_suffixes,
+
+	// fm_index
+	text_section_bwt = 0,
+	text_section_alphabet,
+	text_section_superblocks,
+	text_section_blocks,
+	text_section_sampled,
+	text_section_sampled_ranks,
+	text_section_samples
+};
+
+// The text as SA-IS symbols: bytes shifted up by one, with a 0 after the end that sorts before everything
+struct sais_text
+{
+	const unsigned char *text;
+	std::size_t size;
+
+	std::uint32_t operator[](std::size_t i) const noexcept { return i < size ? text[i] + 1u : 0u; }
+};
+
+template <typename Text>
+void sais_buckets(const Text &s, std::size_t n, std::vector<std::uint32_t> &bucket, bool ends)
+{
+	std::fill(bucket.begin(), bucket.end(), 0);
+
+	for (std::size_t i = 0; i < n; ++i)
+		++bucket[s[i]];
+
+	std::uint32_t sum = 0;
+
+	for (std::uint32_t &size : bucket)
+	{
+		sum += size;
+		size = ends ? sum : sum - size;
+	}
+}
+
+template <typename Text>
+void sais_induce(const Text &s, std::uint32_t *sa, std::size_t n, const std::vector<bool> &stype, std::vector<std::uint32_t> &bucket)
+{
+	// L-type suffixes from the left, each right after the suffix one longer than it
+	sais_buckets(s, n, bucket, false);
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		const std::uint32_t j = sa[i];
+
+		if (j != sais_empty && j > 0 && !stype[j - 1])
+			sa[bucket[s[j - 1]]++] = j - 1;
+	}
+
+	// Then S-type suffixes from the right
+	sais_buckets(s, n, bucket, true);
+
+	for (std::size_t i = n; i-- > 0;)
+	{
+		const std::uint32_t j = sa[i];
+
+		if (j != sais_empty && j > 0 && stype[j - 1])
+			sa[--bucket[s[j - 1]]] = j - 1;
+	}
+}
+
+// Suffix array of s[0, n) with symbols in [0, k). s[n - 1] has to be a 0 that appears nowhere else.
+template <typename Text>
+void sais(const Text &s, std::uint32_t *sa, std::size_t n, std::size_t k)
+{
+	if (n == 1)
+	{
+		sa[0] = 0;
+		return;
+	}
+
+	std::vector<bool> stype(n);
+	stype[n - 1] = true;
+
+	for (std::size_t i = n - 1; i-- > 0;)
+		stype[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && stype[i + 1]);
+
+	const auto is_lms = [&stype](std::size_t i) { return i > 0 && stype[i] && !stype[i - 1]; };
+
+	// Sort the LMS substrings by placing them at their bucket ends and inducing
+	std::vector<std::uint32_t> bucket(k);
+	sais_buckets(s, n, bucket, true);
+	std::fill(sa, sa + n, sais_empty);
+
+	for (std::size_t i = 1; i < n; ++i)
+	{
+		if (is_lms(i))
+			sa[--bucket[s[i]]] = static_cast<std::uint32_t>(i);
+	}
+
+	sais_induce(s, sa, n, stype, bucket);
+
+	// Pull the sorted LMS substrings to the front and name them, equal substrings getting equal names
+	std::size_t m = 0;
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		if (is_lms(sa[i]))
+			sa[m++] = sa[i];
+	}
+
+	std::fill(sa + m, sa + n, sais_empty);
+
+	std::uint32_t names = 0;
+	std::size_t previous = sais_empty;
+
+	for (std::size_t i = 0; i < m; ++i)
+	{
+		const std::size_t position = sa[i];
+		bool differs = false;
+
+		// Note: The sentinel is the only LMS substring ending at n - 1 and it's unique, so this stops before the end
+		for (std::size_t d = 0; d < n; ++d)
+		{
+			if (previous == sais_empty || s[position + d] != s[previous + d] || stype[position + d] != stype[previous + d])
+			{
+				differs = true;
+				break;
+			}
+
+			if (d > 0 && (is_lms(position + d) || is_lms(previous + d)))
+				break;
+		}
+
+		if (differs)
+		{
+			++names;
+			previous = position;
+		}
+
+		// Note: LMS positions are at least two apart, so position / 2 doesn't collide
+		sa[m + position / 2] = names - 1;
+	}
+
+	for (std::size_t i = n, j = n; i-- > m;)
+	{
+		if (sa[i] != sais_empty)
+			sa[--j] = sa[i];
+	}
+
+	// Sort the LMS suffixes, recursing on the string of names if any of them repeat
+	std::uint32_t *const reduced = sa + n - m;
+
+	if (names < m)
+		sais(static_cast<const std::uint32_t*>(reduced), sa, m, names);
+	else
+	{
+		for (std::size_t i = 0; i < m; ++i)
+			sa[reduced[i]] = static_cast<std::uint32_t>(i);
+	}
+
+	// Place the sorted LMS suffixes at their bucket ends and induce everything else from them
+	for (std::size_t i = 1, j = 0; i < n; ++i)
+	{
+		if (is_lms(i))
+			reduced[j++] = static_cast<std::uint32_t>(i);
+	}
+
+	for (std::size_t i = 0; i < m; ++i)
+		sa[i] = reduced[sa[i]];
+
+	std::fill(sa + m, sa + n, sais_empty);
+	sais_buckets(s, n, bucket, true);
+
+	for (std::size_t i = m; i-- > 0;)
+	{
+		const std::uint32_t j = sa[i];
+		sa[i] = sais_empty;
+		sa[--bucket[s[j]]] = j;
+	}
+
+	sais_induce(s, sa, n, stype, bucket);
+}
+
+// Occurrences of byte in str[0, size), for size up to 4080
+inline std::size_t count_byte(const char *str, std::size_t size, char byte) noexcept
+{
+	std::size_t count = 0;
+	std::size_t i = 0;
+
+#if defined(SPL_STRING_SSE2)
+	const __m128i needle = _mm_set1_epi8(byte);
+	__m128i counts = _mm_setzero_si128();
+
+	// Note: Each lane counts at most 255 matches before it would wrap, hence the limit on size
+	for (; i + 16 <= size; i += 16)
+		counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i)), needle));
+
+	const __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+	count = static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) + static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+#endif
+
+	for (; i < size; ++i)
+		count += str[i] == byte;
+
+	return count;
+}
+
+inline std::size_t align_section(std::size_t offset) noexcept
+{
+	return (offset + 7) & ~std::size_t(7);
+}
+
+}
+
+class text_index
+{
+public:
+
+	using size_type = std::size_t;
+
+	text_index() = default;
+
+	explicit text_index(std::string_view text, const text_index_options &options = {})
+	{
+		if (text.size() > detail::text_index_max_size - 1)
+			throw std::length_error("text too large for text_index");
+
+		if (options.mode == text_index_mode::fm_index)
+			build_fm_index(text, options);
+		else
+			build_suffix_array(text);
+	}
+
+	// Maps a file written by save() and uses it in place
+	static text_index open(const std::filesystem::path &path)
+	{
+		text_index index;
+		index.mFile = detail::mapped_file(path, "text index", sizeof(text_index_file_header));
+
+		const auto fail = [&path](const char *what)
+		{
+			throw std::filesystem::filesystem_error(what, path, std::make_error_code(std::errc::invalid_argument));
+		};
+
+		text_index_file_header header;
+		std::memcpy(&header, index.mFile.data(), sizeof(header));
+
+		if (std::memcmp(header.magic, detail::text_index_file_magic, sizeof(header.magic)) != 0)
+			fail("not a text index file");
+
+		if (header.version != detail::text_index_file_version)
+			fail("unsupported text index version");
+
+		if (header.byte_order != detail::text_index_file_byte_order)
+			fail("text index was written with a different byte order");
+
+		if (!index.attach(index.mFile.data(), index.mFile.size()))
+			fail("text index sections are out of bounds");
+
+		return index;
+	}
+
+	text_index(text_index &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	text_index &operator=(text_index &&rhs) noexcept
+	{
+		if (&rhs == this)
+			return *this;
+
+		// Note: Moving the vector keeps its buffer where it is, so the section pointers stay valid
+		mStorage = std::move(rhs.mStorage);
+		mFile = std::move(rhs.mFile);
+		mData = std::exchange(rhs.mData, nullptr);
+		mSize = std::exchange(rhs.mSize, 0);
+		mMode = rhs.mMode;
+		mTextSize = std::exchange(rhs.mTextSize, 0);
+		mRows = std::exchange(rhs.mRows, 0);
+		mText = std::exchange(rhs.mText, nullptr);
+		mSuffixes = std::exchange(rhs.mSuffixes, nullptr);
+		mBwt = std::exchange(rhs.mBwt, nullptr);
+		mAlphabet = std::exchange(rhs.mAlphabet, nullptr);
+		mSuperblocks = std::exchange(rhs.mSuperblocks, nullptr);
+		mBlocks = std::exchange(rhs.mBlocks, nullptr);
+		mSampled = std::exchange(rhs.mSampled, nullptr);
+		mSampledRanks = std::exchange(rhs.mSampledRanks, nullptr);
+		mSamples = std::exchange(rhs.mSamples, nullptr);
+		mPrimary = std::exchange(rhs.mPrimary, 0);
+
+		return *this;
+	}
+
+	text_index(const text_index &) = delete;
+	text_index &operator=(const text_index &) = delete;
+
+	// Size of the indexed text
+	size_type size() const noexcept { return mTextSize; }
+	bool empty() const noexcept { return mTextSize == 0; }
+
+	text_index_mode mode() const noexcept { return mMode; }
+
+	// Bytes the index takes up, in memory or mapped
+	size_type memory_usage() const noexcept { return mSize; }
+
+	// Note: Like std::string_view::find(), an empty pattern matches at every position including the end
+	size_type count(std::string_view pattern) const noexcept
+	{
+		const auto [begin, end] = rows_of(pattern);
+		return end - begin;
+	}
+
+	bool contains(std::string_view pattern) const noexcept
+	{
+		const auto [begin, end] = rows_of(pattern);
+		return begin < end;
+	}
+
+	// Every position pattern occurs at, in increasing order
+	std::vector<size_type> locate(std::string_view pattern) const
+	{
+		const auto [begin, end] = rows_of(pattern);
+
+		std::vector<size_type> positions;
+		positions.reserve(end - begin);
+
+		for (size_type row = begin; row < end; ++row)
+			positions.push_back(position_of(row));
+
+		std::sort(positions.begin(), positions.end());
+
+		return positions;
+	}
+
+	void save(const std::filesystem::path &path) const
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		if (!file)
+			throw std::filesystem::filesystem_error("cannot create text index", path, std::make_error_code(std::errc::io_error));
+
+		file.write(mData, static_cast<std::streamsize>(mSize));
+		file.close();
+
+		if (!file)
+			throw std::filesystem::filesystem_error("failed to write text index", path, std::make_error_code(std::errc::io_error));
+	}
+
+	// Reads the whole index to check its checksum. Linear in the index size.
+	bool verify() const noexcept
+	{
+		if (!mData)
+			return false;
+
+		const text_index_file_header &header = *reinterpret_cast<const text_index_file_header*>(mData);
+		return hash_fnv1a(std::string_view(mData + sizeof(header), mSize - sizeof(header))) == header.checksum;
+	}
+
+private:
+
+	void build_suffix_array(std::string_view text)
+	{
+		const size_type rows = text.size() + 1;
+
+		size_type offsets[8] = {};
+		size_type total = sizeof(text_index_file_header);
+
+		offsets[detail::text_section_text] = total;
+		total = detail::align_section(total + text.size());
+		offsets[detail::text_section_suffixes] = total;
+		total = detail::align_section(total + rows * sizeof(std::uint32_t));
+
+		char *data = allocate(total);
+
+		if (!text.empty())
+			std::memcpy(data + offsets[detail::text_section_text], text.data(), text.size());
+
+		std::uint32_t *suffixes = reinterpret_cast<std::uint32_t*>(data + offsets[detail::text_section_suffixes]);
+		detail::sais(detail::sais_text { reinterpret_cast<const unsigned char*>(text.data()), text.size() }, suffixes, rows, 257);
+
+		finish(text_index_mode::suffix_array, text.size(), 0, 0, offsets);
+	}
+
+	void build_fm_index(std::string_view text, const text_index_options &options)
+	{
+		if (options.sample_rate == 0)
+			throw std::invalid_argument("sample_rate has to be at least 1");
+
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(text.data());
+		const size_type n = text.size();
+		const size_type rows = n + 1;
+		const size_type rate = options.sample_rate;
+
+		std::vector<std::uint32_t> sa(rows);
+		detail::sais(detail::sais_text { bytes, n }, sa.data(), rows, 257);
+
+		text_index_alphabet alphabet = {};
+		size_type histogram[256] = {};
+
+		for (size_type i = 0; i < n; ++i)
+			++histogram[bytes[i]];
+
+		alphabet.first[0] = 1;
+
+		for (unsigned c = 0; c < 256; ++c)
+		{
+			alphabet.first[c + 1] = alphabet.first[c] + histogram[c];
+			alphabet.code[c] = static_cast<std::uint8_t>(alphabet.sigma);
+
+			if (histogram[c])
+				++alphabet.sigma;
+		}
+
+		const size_type sigma = alphabet.sigma;
+		const size_type blocks = (rows + detail::text_index_block - 1) / detail::text_index_block;
+		const size_type superblocks = blocks / detail::text_index_blocks_per_superblock + 1;
+		const size_type chunks = (rows + detail::text_index_superblock - 1) / detail::text_index_superblock;
+		const size_type words = (rows + 63) / 64;
+		const size_type samples = n / rate + 1 + (n % rate != 0);
+
+		size_type offsets[8] = {};
+		size_type total = sizeof(text_index_file_header);
+
+		const auto section = [&](detail::text_index_section which, size_type bytes)
+		{
+			offsets[which] = total;
+			total = detail::align_section(total + bytes);
+		};
+
+		section(detail::text_section_bwt, rows);
+		section(detail::text_section_alphabet, sizeof(text_index_alphabet));
+		section(detail::text_section_superblocks, superblocks * sigma * sizeof(std::uint32_t));
+		section(detail::text_section_blocks, (blocks + 1) * sigma * sizeof(std::uint16_t));
+		section(detail::text_section_sampled, words * sizeof(std::uint64_t));
+		section(detail::text_section_sampled_ranks, words * sizeof(std::uint32_t));
+		section(detail::text_section_samples, samples * sizeof(std::uint32_t));
+
+		char *data = allocate(total);
+		char *bwt = data + offsets[detail::text_section_bwt];
+		std::uint32_t *superblock_counts = reinterpret_cast<std::uint32_t*>(data + offsets[detail::text_section_superblocks]);
+		std::uint16_t *block_counts = reinterpret_cast<std::uint16_t*>(data + offsets[detail::text_section_blocks]);
+		std::uint64_t *sampled = reinterpret_cast<std::uint64_t*>(data + offsets[detail::text_section_sampled]);
+		std::uint32_t *sampled_ranks = reinterpret_cast<std::uint32_t*>(data + offsets[detail::text_section_sampled_ranks]);
+		std::uint32_t *sample_positions = reinterpret_cast<std::uint32_t*>(data + offsets[detail::text_section_samples]);
+
+		std::memcpy(data + offsets[detail::text_section_alphabet], &alphabet, sizeof(alphabet));
+
+		const unsigned threads = options.parallel ? std::max(1u, options.threads ? options.threads : std::thread::hardware_concurrency()) : 1;
+		std::vector<std::uint32_t> chunk_counts(chunks * sigma);
+		const size_type primary = static_cast<size_type>(std::find(sa.begin(), sa.end(), 0u) - sa.begin());
+
+		// Note: Work is split by superblock, so block counts (relative to their superblock) and whole words of
+		// the sampled bits never straddle two threads
+		detail::parallel_for_each_index(chunks, threads, [&](size_type chunk)
+		{
+			std::uint32_t *counts = chunk_counts.data() + chunk * sigma;
+			const size_type begin = chunk * detail::text_index_superblock;
+			const size_type end = std::min(rows, begin + detail::text_index_superblock);
+
+			for (size_type row = begin; row < end; ++row)
+			{
+				if (row % detail::text_index_block == 0)
+				{
+					for (size_type code = 0; code < sigma; ++code)
+						block_counts[row / detail::text_index_block * sigma + code] = static_cast<std::uint16_t>(counts[code]);
+				}
+
+				const std::uint32_t position = sa[row];
+
+				// Note: The row for the whole text has nothing before it and gets a 0 byte, which rank() makes up for
+				const unsigned char byte = position ? bytes[position - 1] : 0;
+				bwt[row] = static_cast<char>(byte);
+
+				if (histogram[byte])
+					++counts[alphabet.code[byte]];
+
+				if (position % rate == 0 || position == n)
+					sampled[row / 64] |= std::uint64_t(1) << (row % 64);
+			}
+		});
+
+		for (size_type chunk = 0; chunk + 1 < superblocks; ++chunk)
+		{
+			for (size_type code = 0; code < sigma; ++code)
+				superblock_counts[(chunk + 1) * sigma + code] = superblock_counts[chunk * sigma + code] + chunk_counts[chunk * sigma + code];
+		}
+
+		// The count at the very end, which the loop above never reaches
+		const size_type last = blocks / detail::text_index_blocks_per_superblock;
+
+		for (size_type code = 0; code < sigma; ++code)
+		{
+			std::uint32_t sum = 0;
+
+			for (size_type chunk = 0; chunk < chunks; ++chunk)
+				sum += chunk_counts[chunk * sigma + code];
+
+			block_counts[blocks * sigma + code] = static_cast<std::uint16_t>(sum - superblock_counts[last * sigma + code]);
+		}
+
+		std::uint32_t rank = 0;
+
+		for (size_type word = 0; word < words; ++word)
+		{
+			sampled_ranks[word] = rank;
+			rank += detail::popcount(static_cast<std::uint32_t>(sampled[word])) + detail::popcount(static_cast<std::uint32_t>(sampled[word] >> 32));
+		}
+
+		detail::parallel_for_each_index(chunks, threads, [&](size_type chunk)
+		{
+			const size_type begin = chunk * detail::text_index_superblock;
+			const size_type end = std::min(rows, begin + detail::text_index_superblock);
+			size_type next = sampled_ranks[begin / 64];
+
+			for (size_type row = begin; row < end; ++row)
+			{
+				if (sampled[row / 64] >> (row % 64) & 1)
+					sample_positions[next++] = sa[row];
+			}
+		});
+
+		finish(text_index_mode::fm_index, n, primary, options.sample_rate, offsets);
+	}
+
+	char *allocate(size_type bytes)
+	{
+		mStorage.assign((bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t), 0);
+		return reinterpret_cast<char*>(mStorage.data());
+	}
+
+	void finish(text_index_mode mode, size_type text_size, size_type primary, std::uint32_t sample_rate, const size_type (&offsets)[8])
+	{
+		char *data = reinterpret_cast<char*>(mStorage.data());
+		const size_type size = mStorage.size() * sizeof(std::uint64_t);
+
+		text_index_file_header header = {};
+		std::memcpy(header.magic, detail::text_index_file_magic, sizeof(header.magic));
+		header.version = detail::text_index_file_version;
+		header.mode = static_cast<std::uint32_t>(mode);
+		header.byte_order = detail::text_index_file_byte_order;
+		header.sample_rate = sample_rate;
+		header.text_size = text_size;
+		header.primary = primary;
+		std::copy(std::begin(offsets), std::end(offsets), header.sections);
+		header.checksum = hash_fnv1a(std::string_view(data + sizeof(header), size - sizeof(header)));
+
+		std::memcpy(data, &header, sizeof(header));
+
+		attach(data, size);
+	}
+
+	// Points the sections into data, after checking they're all inside it
+	bool attach(const char *data, size_type size) noexcept
+	{
+		text_index_file_header header;
+		std::memcpy(&header, data, sizeof(header));
+
+		if (std::memcmp(header.magic, detail::text_index_file_magic, sizeof(header.magic)) != 0 ||
+			header.version != detail::text_index_file_version || header.byte_order != detail::text_index_file_byte_order ||
+			header.text_size > detail::text_index_max_size - 1)
+			return false;
+
+		const std::uint64_t rows = header.text_size + 1;
+		const auto fits = [&header, size](int section, std::uint64_t count, std::uint64_t element_size)
+		{
+			const std::uint64_t offset = header.sections[section];
+			return offset % 8 == 0 && offset >= sizeof(header) && offset <= size && count <= (size - offset) / element_size;
+		};
+
+		mData = data;
+		mSize = size;
+		mTextSize = static_cast<size_type>(header.text_size);
+		mRows = static_cast<size_type>(rows);
+
+		if (header.mode == static_cast<std::uint32_t>(text_index_mode::suffix_array))
+		{
+			if (!fits(detail::text_section_text, header.text_size, 1) || !fits(detail::text_section_suffixes, rows, sizeof(std::uint32_t)))
+				return false;
+
+			mMode = text_index_mode::suffix_array;
+			mText = data + header.sections[detail::text_section_text];
+			mSuffixes = reinterpret_cast<const std::uint32_t*>(data + header.sections[detail::text_section_suffixes]);
+
+			return true;
+		}
+
+		if (header.mode != static_cast<std::uint32_t>(text_index_mode::fm_index) || header.sample_rate == 0 || header.primary >= rows ||
+			!fits(detail::text_section_alphabet, 1, sizeof(text_index_alphabet)))
+			return false;
+
+		const text_index_alphabet *alphabet = reinterpret_cast<const text_index_alphabet*>(data + header.sections[detail::text_section_alphabet]);
+		const std::uint64_t sigma = alphabet->sigma;
+		const std::uint64_t blocks = (rows + detail::text_index_block - 1) / detail::text_index_block;
+		const std::uint64_t superblocks = blocks / detail::text_index_blocks_per_superblock + 1;
+		const std::uint64_t words = (rows + 63) / 64;
+		const std::uint64_t samples = header.text_size / header.sample_rate + 1 + (header.text_size % header.sample_rate != 0);
+
+		if (sigma > 256 || alphabet->first[256] != rows || !fits(detail::text_section_bwt, rows, 1) ||
+			!fits(detail::text_section_superblocks, superblocks * sigma, sizeof(std::uint32_t)) ||
+			!fits(detail::text_section_blocks, (blocks + 1) * sigma, sizeof(std::uint16_t)) ||
+			!fits(detail::text_section_sampled, words, sizeof(std::uint64_t)) ||
+			!fits(detail::text_section_sampled_ranks, words, sizeof(std::uint32_t)) ||
+			!fits(detail::text_section_samples, samples, sizeof(std::uint32_t)))
+			return false;
+
+		mMode = text_index_mode::fm_index;
+		mBwt = data + header.sections[detail::text_section_bwt];
+		mAlphabet = alphabet;
+		mSuperblocks = reinterpret_cast<const std::uint32_t*>(data + header.sections[detail::text_section_superblocks]);
+		mBlocks = reinterpret_cast<const std::uint16_t*>(data + header.sections[detail::text_section_blocks]);
+		mSampled = reinterpret_cast<const std::uint64_t*>(data + header.sections[detail::text_section_sampled]);
+		mSampledRanks = reinterpret_cast<const std::uint32_t*>(data + header.sections[detail::text_section_sampled_ranks]);
+		mSamples = reinterpret_cast<const std::uint32_t*>(data + header.sections[detail::text_section_samples]);
+		mPrimary = static_cast<size_type>(header.primary);
+
+		return true;
+	}
+
+	// The range of sorted suffixes that start with pattern
+	std::pair<size_type, size_type> rows_of(std::string_view pattern) const noexcept
+	{
+		if (!mData)
+			return { 0, 0 };
+
+		if (mMode == text_index_mode::suffix_array)
+		{
+			const auto compare = [this, pattern](std::uint32_t position)
+			{
+				const size_type length = std::min(pattern.size(), mTextSize - position);
+				const int result = length ? std::memcmp(mText + position, pattern.data(), length) : 0;
+
+				// Note: A suffix shorter than the pattern that matches as far as it goes sorts before it
+				return result ? result : length < pattern.size() ? -1 : 0;
+			};
+
+			const std::uint32_t *begin = std::partition_point(mSuffixes, mSuffixes + mRows, [&compare](std::uint32_t position) { return compare(position) < 0; });
+			const std::uint32_t *end = std::partition_point(begin, mSuffixes + mRows, [&compare](std::uint32_t position) { return compare(position) == 0; });
+
+			return { static_cast<size_type>(begin - mSuffixes), static_cast<size_type>(end - mSuffixes) };
+		}
+
+		// Backward search, narrowing the rows one byte at a time from the end of the pattern
+		size_type begin = 0;
+		size_type end = mRows;
+
+		for (size_type i = pattern.size(); i-- > 0 && begin < end;)
+		{
+			const unsigned char byte = static_cast<unsigned char>(pattern[i]);
+			const size_type first = static_cast<size_type>(mAlphabet->first[byte]);
+
+			if (mAlphabet->first[byte + 1] == first)
+				return { 0, 0 };
+
+			begin = first + rank(byte, begin);
+			end = first + rank(byte, end);
+		}
+
+		return { begin, std::max(begin, end) };
+	}
+
+	// Occurrences of byte in the transform before row
+	size_type rank(unsigned char byte, size_type row) const noexcept
+	{
+		const size_type code = mAlphabet->code[byte];
+		const size_type block = row / detail::text_index_block;
+		const size_type offset = row % detail::text_index_block;
+		size_type result;
+
+		if (offset <= detail::text_index_block / 2 || (block + 1) * detail::text_index_block > mRows)
+			result = block_count(block, code) + detail::count_byte(mBwt + block * detail::text_index_block, offset, static_cast<char>(byte));
+		else
+			result = block_count(block + 1, code) - detail::count_byte(mBwt + row, detail::text_index_block - offset, static_cast<char>(byte));
+
+		// Note: The primary row holds a 0 that isn't really in the text
+		if (byte == 0 && mPrimary < row)
+			--result;
+
+		return result;
+	}
+
+	size_type block_count(size_type block, size_type code) const noexcept
+	{
+		const size_type sigma = mAlphabet->sigma;
+		return mSuperblocks[block / detail::text_index_blocks_per_superblock * sigma + code] + mBlocks[block * sigma + code];
+	}
+
+	// Text position of the suffix at row
+	size_type position_of(size_type row) const noexcept
+	{
+		if (mMode == text_index_mode::suffix_array)
+			return mSuffixes[row];
+
+		// Step backwards through the text until a row with a stored position turns up
+		size_type steps = 0;
+
+		while (!(mSampled[row / 64] >> (row % 64) & 1))
+		{
+			const unsigned char byte = static_cast<unsigned char>(mBwt[row]);
+			row = static_cast<size_type>(mAlphabet->first[byte]) + rank(byte, row);
+			++steps;
+		}
+
+		const std::uint64_t below = mSampled[row / 64] & ((std::uint64_t(1) << (row % 64)) - 1);
+		const size_type index = mSampledRanks[row / 64] + detail::popcount(static_cast<std::uint32_t>(below)) + detail::popcount(static_cast<std::uint32_t>(below >> 32));
+
+		return mSamples[index] + steps;
+	}
+
+	std::vector<std::uint64_t> mStorage;    // The index when it was built rather than opened
+	detail::mapped_file mFile;
+	const char *mData = nullptr;
+	size_type mSize = 0;
+
+	text_index_mode mMode = text_index_mode::suffix_array;
+	size_type mTextSize = 0;
+	size_type mRows = 0;
+
+	// suffix_array
+	const char *mText = nullptr;
+	const std::uint32_t *mSuffixes = nullptr;
+
+	// fm_index
+	const char *mBwt = nullptr;
+	const text_index_alphabet *mAlphabet = nullptr;
+	const std::uint32_t *mSuperblocks = nullptr;
+	const std::uint16_t *mBlocks = nullptr;
+	const std::uint64_t *mSampled = nullptr;
+	const std::uint32_t *mSampledRanks = nullptr;
+	const std::uint32_t *mSamples = nullptr;
+	size_type mPrimary = 0;
+};
+
+}
@@ -0,0 +1,682 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2021 Spirrwell
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+********************************************************************************/
+
+#pragma once
+
+#include "splstring.h"
+
+// A map from strings to values that can also answer "which key is the longest prefix of this string?", which is
+// what a router asks of every request path.
+//
+//	spl::prefix_trie<int> routes;
+//	routes.insert("/api/", 1);
+//	routes.insert("/api/users/", 2);
+//
+//	if (auto match = routes.longest_prefix_match("/api/users/42"))
+//		handle(*match.value, match.length);    // 2, 11
+//
+// It's an adaptive radix tree (Leis et al., "The Adaptive Radix Tree"). Each node branches on one byte and holds
+// the run of bytes every key below it shares, so a lookup touches one node per branching point of the key, no matter
+// how many keys there are. Nodes come in four sizes, for up to 4, 16, 48 and 256 children, and grow as children are
+// added, so sparse nodes stay small and dense ones are a single array index. Nodes with 16 children are searched
+// with one SIMD compare.
+//
+// Key bytes live in one arena that only ever grows: inserting a key appends just the part no other key shares, and
+// splitting a node refers to the same bytes from both halves instead of copying them. Nodes and child arrays are
+// 32-bit indices into vectors rather than pointers, which keeps them small and makes the whole trie cheap to copy.
+
+namespace spl
+{
+
+namespace detail
+{
+
+constexpr std::uint32_t trie_none = 0xFFFFFFFFu;
+
+enum class trie_kind : std::uint8_t
+{
+	leaf,
+	node4,
+	node16,
+	node48,
+	node256
+};
+
+struct trie_node
+{
+	std::uint32_t prefix = 0;           // Offset of the shared bytes in the arena
+	std::uint32_t prefix_size = 0;
+	std::uint32_t value = trie_none;    // Index into the values, if a key ends here
+	std::uint32_t children = 0;         // Index into the child arrays for kind
+	std::uint16_t count = 0;
+	trie_kind kind = trie_kind::leaf;
+};
+
+// Note: Keys are kept sorted in node4 and node16 so iteration comes out in order
+struct trie_node4
+{
+	std::uint8_t keys[4];
+	std::uint32_t children[4];
+};
+
+struct trie_node16
+{
+	std::uint8_t keys[16];
+	std::uint32_t children[16];
+};
+
+struct trie_node48
+{
+	std::uint8_t index[256];    // Slot + 1 for each byte, 0 for none
+	std::uint32_t children[48];
+};
+
+// Note: 0 means no child, which works because node 0 is the root and never anyone's child
+struct trie_node256
+{
+	std::uint32_t children[256];
+};
+
+// Child arrays of one size, reusing the ones nodes have grown out of
+template <typename T>
+struct trie_pool
+{
+	std::vector<T> items;
+	std::vector<std::uint32_t> unused;
+
+	std::uint32_t allocate()
+	{
+		if (!unused.empty())
+		{
+			const std::uint32_t index = unused.back();
+			unused.pop_back();
+			items[index] = T{};
+			return index;
+		}
+
+		items.emplace_back();
+		return static_cast<std::uint32_t>(items.size() - 1);
+	}
+
+	void release(std::uint32_t index) { unused.push_back(index); }
+
+	void clear() noexcept
+	{
+		items.clear();
+		unused.clear();
+	}
+
+	std::size_t memory_usage() const noexcept { return items.capacity() * sizeof(T) + unused.capacity() * sizeof(std::uint32_t); }
+};
+
+template <std::size_t Size>
+void trie_insert_sorted(std::uint8_t (&keys)[Size], std::uint32_t (&children)[Size], std::size_t count, std::uint8_t byte, std::uint32_t child) noexcept
+{
+	std::size_t i = count;
+
+	for (; i > 0 && keys[i - 1] > byte; --i)
+	{
+		keys[i] = keys[i - 1];
+		children[i] = children[i - 1];
+	}
+
+	keys[i] = byte;
+	children[i] = child;
+}
+
+}
+
+// The result of prefix_trie::longest_prefix_match(), which is false if no key matched
+template <typename T>
+struct prefix_match
+{
+	std::size_t length = 0;    // Size of the matching key
+	T *value = nullptr;
+
+	explicit operator bool() const noexcept { return value != nullptr; }
+};
+
+template <typename V>
+class prefix_trie
+{
+public:
+
+	using size_type = std::size_t;
+	using value_type = V;
+	using match = prefix_match<V>;
+	using const_match = prefix_match<const V>;
+
+	prefix_trie() { mNodes.emplace_back(); }
+
+	prefix_trie(std::initializer_list<std::pair<std::string_view, V>> entries) : prefix_trie()
+	{
+		for (const auto &[key, value] : entries)
+			insert(key, value);
+	}
+
+	// Adds key with a value made from args, unless it's already there.
+	// Returns the key's value and whether it was added. Like with std::vector, the pointer is only good until the next insert.
+	template <typename... Args>
+	std::pair<V*, bool> try_emplace(std::string_view key, Args&&... args)
+	{
+		const std::uint32_t n = locate(key);
+
+		if (mNodes[n].value != detail::trie_none)
+			return { &mValues[mNodes[n].value], false };
+
+		if (mValues.size() >= detail::trie_none)
+			throw std::length_error("prefix_trie too large");
+
+		mValues.emplace_back(std::forward<Args>(args)...);
+		mNodes[n].value = static_cast<std::uint32_t>(mValues.size() - 1);
+
+		return { &mValues.back(), true };
+	}
+
+	// Returns false and leaves the existing value alone if key is already there
+	bool insert(std::string_view key, const V &value) { return try_emplace(key, value).second; }
+	bool insert(std::string_view key, V &&value) { return try_emplace(key, std::move(value)).second; }
+
+	// Returns true if key was added, false if its value was replaced
+	template <typename T>
+	bool insert_or_assign(std::string_view key, T &&value)
+	{
+		// Note: try_emplace() only uses value when it adds the key, so it's still there to assign otherwise
+		const auto [existing, inserted] = try_emplace(key, std::forward<T>(value));
+
+		if (!inserted)
+			*existing = std::forward<T>(value);
+
+		return inserted;
+	}
+
+	V &operator[](std::string_view key) { return *try_emplace(key).first; }
+
+	const V *find(std::string_view key) const noexcept
+	{
+		std::uint32_t n = 0;
+		size_type depth = 0;
+
+		for (;;)
+		{
+			const detail::trie_node &node = mNodes[n];
+
+			if (!prefix_matches(node, key, depth))
+				return nullptr;
+
+			depth += node.prefix_size;
+
+			if (depth == key.size())
+				return node.value != detail::trie_none ? &mValues[node.value] : nullptr;
+
+			n = find_child(node, static_cast<std::uint8_t>(key[depth]));
+
+			if (!n)
+				return nullptr;
+
+			++depth;
+		}
+	}
+
+	V *find(std::string_view key) noexcept { return const_cast<V*>(std::as_const(*this).find(key)); }
+
+	bool contains(std::string_view key) const noexcept { return find(key) != nullptr; }
+
+	// The longest key that text starts with, and its value
+	const_match longest_prefix_match(std::string_view text) const noexcept
+	{
+		const_match best;
+		std::uint32_t n = 0;
+		size_type depth = 0;
+
+		for (;;)
+		{
+			const detail::trie_node &node = mNodes[n];
+
+			if (!prefix_matches(node, text, depth))
+				break;
+
+			depth += node.prefix_size;
+
+			if (node.value != detail::trie_none)
+				best = { depth, &mValues[node.value] };
+
+			if (depth == text.size())
+				break;
+
+			n = find_child(node, static_cast<std::uint8_t>(text[depth]));
+
+			if (!n)
+				break;
+
+			++depth;
+		}
+
+		return best;
+	}
+
+	match longest_prefix_match(std::string_view text) noexcept
+	{
+		const const_match found = std::as_const(*this).longest_prefix_match(text);
+		return { found.length, const_cast<V*>(found.value) };
+	}
+
+	// Calls f(std::string_view key, value) for every key that starts with prefix, in byte order.
+	// Note: Don't insert from inside f.
+	template <typename F>
+	void for_each_prefix(std::string_view prefix, F &&f) const
+	{
+		std::uint32_t n = 0;
+		size_type depth = 0;
+
+		for (;;)
+		{
+			const detail::trie_node &node = mNodes[n];
+			const size_type left = prefix.size() - depth;
+
+			if (left <= node.prefix_size)
+			{
+				// Note: prefix ends inside this node, so everything below it matches if the rest of prefix does
+				if (left && std::memcmp(prefix.data() + depth, mBytes.data() + node.prefix, left) != 0)
+					return;
+
+				std::string key(prefix.data(), depth);
+				key.append(mBytes.data() + node.prefix, node.prefix_size);
+				visit(n, key, f);
+				return;
+			}
+
+			if (!prefix_matches(node, prefix, depth))
+				return;
+
+			depth += node.prefix_size;
+			n = find_child(node, static_cast<std::uint8_t>(prefix[depth]));
+
+			if (!n)
+				return;
+
+			++depth;
+		}
+	}
+
+	template <typename F>
+	void for_each_prefix(std::string_view prefix, F &&f)
+	{
+		std::as_const(*this).for_each_prefix(prefix, [&f](std::string_view key, const V &value) { f(key, const_cast<V&>(value)); });
+	}
+
+	template <typename F>
+	void for_each(F &&f) const { for_each_prefix(std::string_view(), std::forward<F>(f)); }
+
+	template <typename F>
+	void for_each(F &&f) { for_each_prefix(std::string_view(), std::forward<F>(f)); }
+
+	size_type size() const noexcept { return mValues.size(); }
+	bool empty() const noexcept { return mValues.empty(); }
+
+	void clear() noexcept
+	{
+		mNodes.clear();
+		mNodes.emplace_back();
+		mBytes.clear();
+		mValues.clear();
+		mNode4.clear();
+		mNode16.clear();
+		mNode48.clear();
+		mNode256.clear();
+	}
+
+	// Bytes allocated for the keys, nodes and values, not counting anything the values themselves allocate
+	size_type memory_usage() const noexcept
+	{
+		return mBytes.capacity() + mNodes.capacity() * sizeof(detail::trie_node) + mValues.capacity() * sizeof(V) +
+			mNode4.memory_usage() + mNode16.memory_usage() + mNode48.memory_usage() + mNode256.memory_usage();
+	}
+
+private:
+
+	bool prefix_matches(const detail::trie_node &node, std::string_view key, size_type depth) const noexcept
+	{
+		return key.size() - depth >= node.prefix_size &&
+			(!node.prefix_size || std::memcmp(key.data() + depth, mBytes.data() + node.prefix, node.prefix_size) == 0);
+	}
+
+	// The child for byte, or 0 if there isn't one
+	std::uint32_t find_child(const detail::trie_node &node, std::uint8_t byte) const noexcept
+	{
+		switch (node.kind)
+		{
+		case detail::trie_kind::leaf:
+			return 0;
+
+		case detail::trie_kind::node4:
+		{
+			const detail::trie_node4 &children = mNode4.items[node.children];
+
+			for (std::uint16_t i = 0; i < node.count; ++i)
+			{
+				if (children.keys[i] == byte)
+					return children.children[i];
+			}
+
+			return 0;
+		}
+
+		case detail::trie_kind::node16:
+		{
+			const detail::trie_node16 &children = mNode16.items[node.children];
+
+#if defined(SPL_STRING_SSE2)
+			const __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(children.keys));
+			const std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(byte))))) &
+				((1u << node.count) - 1);
+
+			return mask ? children.children[detail::count_trailing_zeros(mask)] : 0;
+#else
+			for (std::uint16_t i = 0; i < node.count; ++i)
+			{
+				if (children.keys[i] == byte)
+					return children.children[i];
+			}
+
+			return 0;
+#endif
+		}
+
+		case detail::trie_kind::node48:
+		{
+			const detail::trie_node48 &children = mNode48.items[node.children];
+			const std::uint8_t slot = children.index[byte];
+
+			return slot ? children.children[slot - 1] : 0;
+		}
+
+		case detail::trie_kind::node256:
+			return mNode256.items[node.children].children[byte];
+		}
+
+		return 0;
+	}
+
+	// Calls f(byte, child) for each child of node, in byte order
+	template <typename F>
+	void for_each_child(const detail::trie_node &node, F &&f) const
+	{
+		switch (node.kind)
+		{
+		case detail::trie_kind::leaf:
+			break;
+
+		case detail::trie_kind::node4:
+		{
+			const detail::trie_node4 &children = mNode4.items[node.children];
+
+			for (std::uint16_t i = 0; i < node.count; ++i)
+				f(children.keys[i], children.children[i]);
+
+			break;
+		}
+
+		case detail::trie_kind::node16:
+		{
+			const detail::trie_node16 &children = mNode16.items[node.children];
+
+			for (std::uint16_t i = 0; i < node.count; ++i)
+				f(children.keys[i], children.children[i]);
+
+			break;
+		}
+
+		case detail::trie_kind::node48:
+		{
+			const detail::trie_node48 &children = mNode48.items[node.children];
+
+			for (unsigned byte = 0; byte < 256; ++byte)
+			{
+				if (children.index[byte])
+					f(static_cast<std::uint8_t>(byte), children.children[children.index[byte] - 1]);
+			}
+
+			break;
+		}
+
+		case detail::trie_kind::node256:
+		{
+			const detail::trie_node256 &children = mNode256.items[node.children];
+
+			for (unsigned byte = 0; byte < 256; ++byte)
+			{
+				if (children.children[byte])
+					f(static_cast<std::uint8_t>(byte), children.children[byte]);
+			}
+
+			break;
+		}
+		}
+	}
+
+	// Calls f for n and everything below it, where key is the full key up to the end of n's prefix
+	template <typename F>
+	void visit(std::uint32_t n, std::string &key, F &f) const
+	{
+		const detail::trie_node &node = mNodes[n];
+
+		if (node.value != detail::trie_none)
+			f(std::string_view(key), mValues[node.value]);
+
+		for_each_child(node, [this, &key, &f](std::uint8_t byte, std::uint32_t child)
+		{
+			const size_type size = key.size();
+			const detail::trie_node &next = mNodes[child];
+
+			key += static_cast<char>(byte);
+			key.append(mBytes.data() + next.prefix, next.prefix_size);
+			visit(child, key, f);
+			key.resize(size);
+		});
+	}
+
+	// The node for key, adding it (and splitting the node it branches off from) if it isn't there yet
+	std::uint32_t locate(std::string_view key)
+	{
+		std::uint32_t n = 0;
+		size_type depth = 0;
+
+		for (;;)
+		{
+			const detail::trie_node &node = mNodes[n];
+			const size_type limit = std::min<size_type>(node.prefix_size, key.size() - depth);
+			size_type common = 0;
+
+			while (common < limit && mBytes[node.prefix + common] == key[depth + common])
+				++common;
+
+			if (common < node.prefix_size)
+				split(n, common);
+
+			depth += common;
+
+			if (depth == key.size())
+				return n;
+
+			const std::uint8_t byte = static_cast<std::uint8_t>(key[depth]);
+			const std::uint32_t child = find_child(mNodes[n], byte);
+
+			if (!child)
+			{
+				const std::uint32_t leaf = add_node(key.substr(depth + 1));
+				add_child(n, byte, leaf);
+				return leaf;
+			}
+
+			n = child;
+			++depth;
+		}
+	}
+
+	// A new leaf whose prefix is suffix
+	std::uint32_t add_node(std::string_view suffix)
+	{
+		if (mNodes.size() >= detail::trie_none || suffix.size() > detail::trie_none - mBytes.size())
+			throw std::length_error("prefix_trie too large");
+
+		detail::trie_node node;
+		node.prefix = static_cast<std::uint32_t>(mBytes.size());
+		node.prefix_size = static_cast<std::uint32_t>(suffix.size());
+
+		mBytes.insert(mBytes.end(), suffix.begin(), suffix.end());
+		mNodes.push_back(node);
+
+		return static_cast<std::uint32_t>(mNodes.size() - 1);
+	}
+
+	// Cuts n's prefix after common bytes. n keeps its index, so its parent doesn't change, and everything it
+	// had moves to a new child that branches on the byte after the cut.
+	void split(std::uint32_t n, size_type common)
+	{
+		if (mNodes.size() >= detail::trie_none)
+			throw std::length_error("prefix_trie too large");
+
+		detail::trie_node lower = mNodes[n];
+		const std::uint8_t byte = static_cast<std::uint8_t>(mBytes[lower.prefix + common]);
+
+		lower.prefix += static_cast<std::uint32_t>(common + 1);
+		lower.prefix_size -= static_cast<std::uint32_t>(common + 1);
+		mNodes.push_back(lower);
+
+		detail::trie_node &upper = mNodes[n];
+		upper.prefix_size = static_cast<std::uint32_t>(common);
+		upper.value = detail::trie_none;
+		upper.children = 0;
+		upper.count = 0;
+		upper.kind = detail::trie_kind::leaf;
+
+		add_child(n, byte, static_cast<std::uint32_t>(mNodes.size() - 1));
+	}
+
+	void add_child(std::uint32_t n, std::uint8_t byte, std::uint32_t child)
+	{
+		detail::trie_node &node = mNodes[n];
+
+		switch (node.kind)
+		{
+		case detail::trie_kind::leaf:
+			node.children = mNode4.allocate();
+			node.kind = detail::trie_kind::node4;
+			[[fallthrough]];
+
+		case detail::trie_kind::node4:
+			if (node.count < 4)
+			{
+				detail::trie_node4 &children = mNode4.items[node.children];
+				detail::trie_insert_sorted(children.keys, children.children, node.count, byte, child);
+				break;
+			}
+			else
+			{
+				const std::uint32_t grown = mNode16.allocate();
+				const detail::trie_node4 &from = mNode4.items[node.children];
+				detail::trie_node16 &to = mNode16.items[grown];
+
+				std::copy_n(from.keys, 4, to.keys);
+				std::copy_n(from.children, 4, to.children);
+				mNode4.release(node.children);
+
+				node.children = grown;
+				node.kind = detail::trie_kind::node16;
+			}
+			[[fallthrough]];
+
+		case detail::trie_kind::node16:
+			if (node.count < 16)
+			{
+				detail::trie_node16 &children = mNode16.items[node.children];
+				detail::trie_insert_sorted(children.keys, children.children, node.count, byte, child);
+				break;
+			}
+			else
+			{
+				const std::uint32_t grown = mNode48.allocate();
+				const detail::trie_node16 &from = mNode16.items[node.children];
+				detail::trie_node48 &to = mNode48.items[grown];
+
+				for (std::uint8_t i = 0; i < 16; ++i)
+				{
+					to.index[from.keys[i]] = static_cast<std::uint8_t>(i + 1);
+					to.children[i] = from.children[i];
+				}
+
+				mNode16.release(node.children);
+
+				node.children = grown;
+				node.kind = detail::trie_kind::node48;
+			}
+			[[fallthrough]];
+
+		case detail::trie_kind::node48:
+			if (node.count < 48)
+			{
+				detail::trie_node48 &children = mNode48.items[node.children];
+				children.index[byte] = static_cast<std::uint8_t>(node.count + 1);
+				children.children[node.count] = child;
+				break;
+			}
+			else
+			{
+				const std::uint32_t grown = mNode256.allocate();
+				const detail::trie_node48 &from = mNode48.items[node.children];
+				detail::trie_node256 &to = mNode256.items[grown];
+
+				for (unsigned i = 0; i < 256; ++i)
+				{
+					if (from.index[i])
+						to.children[i] = from.children[from.index[i] - 1];
+				}
+
+				mNode48.release(node.children);
+
+				node.children = grown;
+				node.kind = detail::trie_kind::node256;
+			}
+			[[fallthrough]];
+
+		case detail::trie_kind::node256:
+			mNode256.items[node.children].children[byte] = child;
+			break;
+		}
+
+		++node.count;
+	}
+
+	std::vector<detail::trie_node> mNodes;    // The root is always node 0
+	std::vector<char> mBytes;
+	std::vector<V> mValues;
+
+	detail::trie_pool<detail::trie_node4> mNode4;
+	detail::trie_pool<detail::trie_node16> mNode16;
+	detail::trie_pool<detail::trie_node48> mNode48;
+	detail::trie_pool<detail::trie_node256> mNode256;
+};
+
+}
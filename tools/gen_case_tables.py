@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""Generates include/splcasetables.h, the Unicode case mapping tables behind
+spl::string::utf8_lower(), utf8_upper() and utf8_casefold().
+
+The mappings come from Python's own str.lower(), str.upper() and str.casefold(),
+applied to one code point at a time, so they include the unconditional
+SpecialCasing.txt expansions (such as U+00DF -> "ss") but not the context
+sensitive ones (such as final sigma).
+
+Each mapping is a two-level table: index[cp >> BLOCK_SHIFT] picks a block of
+2**BLOCK_SHIFT uint16 entries, and identical blocks are stored once. An entry of
+0 leaves the code point alone, anything else indexes the entries array, which
+holds either a delta to add to the code point or a run in the shared
+expansions array.
+
+Usage: python3 tools/gen_case_tables.py > include/splcasetables.h
+"""
+
+import sys
+import unicodedata
+
+BLOCK_SHIFT = 6
+BLOCK_SIZE = 1 << BLOCK_SHIFT
+
+OPERATIONS = [
+    ("case_lower", str.lower),
+    ("case_upper", str.upper),
+    ("case_fold", str.casefold),
+]
+
+
+def build(mapping, expansions, expansion_lookup):
+    mapped = {}
+
+    for cp in range(0x110000):
+        if 0xD800 <= cp <= 0xDFFF:
+            continue
+
+        result = mapping(chr(cp))
+
+        if result != chr(cp):
+            mapped[cp] = [ord(ch) for ch in result]
+
+    limit = (max(mapped) // BLOCK_SIZE + 1) * BLOCK_SIZE
+
+    entries = [(0, 0, 0)]
+    entry_lookup = {(0, 0, 0): 0}
+    values = []
+
+    for cp in range(limit):
+        target = mapped.get(cp)
+
+        if target is None:
+            values.append(0)
+            continue
+
+        if len(target) == 1:
+            entry = (target[0] - cp, 0, 1)
+        else:
+            key = tuple(target)
+
+            if key not in expansion_lookup:
+                expansion_lookup[key] = len(expansions)
+                expansions.extend(target)
+
+            entry = (0, expansion_lookup[key], len(target))
+
+        if entry not in entry_lookup:
+            entry_lookup[entry] = len(entries)
+            entries.append(entry)
+
+        values.append(entry_lookup[entry])
+
+    blocks = []
+    block_lookup = {}
+    index = []
+
+    for start in range(0, limit, BLOCK_SIZE):
+        block = tuple(values[start:start + BLOCK_SIZE])
+
+        if block not in block_lookup:
+            block_lookup[block] = len(blocks)
+            blocks.append(block)
+
+        index.append(block_lookup[block])
+
+    assert len(blocks) <= 256 and len(entries) <= 65536
+
+    return limit, index, blocks, entries
+
+
+def max_growth():
+    growth = 1
+
+    for cp in range(0x80, 0x110000):
+        if 0xD800 <= cp <= 0xDFFF:
+            continue
+
+        source = len(chr(cp).encode("utf-8"))
+
+        for _, mapping in OPERATIONS:
+            mapped = len(mapping(chr(cp)).encode("utf-8"))
+            growth = max(growth, -(-mapped // source))
+
+    return growth
+
+
+def format_numbers(numbers, per_line=16):
+    lines = []
+
+    for i in range(0, len(numbers), per_line):
+        lines.append("\t" + ", ".join(str(n) for n in numbers[i:i + per_line]) + ",")
+
+    return "\n".join(lines)
+
+
+def main():
+    out = sys.stdout
+    expansions = []
+    expansion_lookup = {}
+    tables = [(name, build(mapping, expansions, expansion_lookup)) for name, mapping in OPERATIONS]
+
+    out.write("// Generated by tools/gen_case_tables.py from Unicode %s. Do not edit.\n\n" % unicodedata.unidata_version)
+    out.write("#pragma once\n\n#include <cstdint>\n#include <cstddef>\n\n")
+    out.write("namespace spl\n{\n\nnamespace detail\n{\n\n")
+    out.write("struct case_entry\n{\n\tstd::int32_t delta;\n\tstd::uint16_t expansion;\n\tstd::uint8_t length;\n};\n\n")
+    out.write("struct case_table\n{\n\tchar32_t limit;\n\tconst std::uint8_t *index;\n\tconst std::uint16_t *blocks;\n\tconst case_entry *entries;\n};\n\n")
+    out.write("inline constexpr unsigned case_block_shift = %d;\n\n" % BLOCK_SHIFT)
+    out.write("// Upper bound on how many times longer a UTF-8 string can get by case mapping it\n")
+    out.write("inline constexpr std::size_t case_max_growth = %d;\n\n" % max_growth())
+    out.write("inline constexpr char32_t case_expansions[] = {\n%s\n};\n\n" % format_numbers(expansions))
+
+    for name, (limit, index, blocks, entries) in tables:
+        flat = [value for block in blocks for value in block]
+
+        out.write("inline constexpr std::uint8_t %s_index[] = {\n%s\n};\n\n" % (name, format_numbers(index)))
+        out.write("inline constexpr std::uint16_t %s_blocks[] = {\n%s\n};\n\n" % (name, format_numbers(flat)))
+        out.write("inline constexpr case_entry %s_entries[] = {\n" % name)
+
+        for delta, expansion, length in entries:
+            out.write("\t{ %d, %d, %d },\n" % (delta, expansion, length))
+
+        out.write("};\n\n")
+        out.write("inline constexpr case_table %s_table = { 0x%X, %s_index, %s_blocks, %s_entries };\n\n" % (name, limit, name, name, name))
+
+    out.write("}\n\n}\n")
+
+
+if __name__ == "__main__":
+    main()